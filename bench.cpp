@@ -0,0 +1,319 @@
+// Microbenchmarks of the OS hot paths. Every benchmark times a number of
+// repetitions of a batch of operations and reports the mean, standard
+// deviation and minimum of ns/op over the repetitions.
+//
+// bench.me [--csv <file>] [--reps n] [--filter <name prefix>]
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "os.h"
+#include "simulator.h"
+#include "workload.h"
+
+using namespace std;
+using namespace os_ops;
+
+struct BenchResult {
+  string name;
+  long param;   // queue depth or size the benchmark ran at
+  size_t ops;   // operations per repetition
+  double mean, stddev, min;  // ns/op
+};
+
+class BenchRunner {
+  public:
+    BenchRunner(int reps, const string& filter) : reps{reps}, filter{filter} {}
+
+    // Time body, which performs ops operations, reps times after a warm up
+    // run. reset restores the state before body between repetitions and is
+    // not timed.
+    template<typename Body, typename Reset>
+    void Run(const string& name, long param, size_t ops, Body body,
+             Reset reset) {
+      if (name.compare(0, filter.size(), filter) != 0) return;
+      body();
+      reset();
+      vector<double> samples;
+      for (int r = 0; r < reps; r++) {
+        auto start = chrono::steady_clock::now();
+        body();
+        auto end = chrono::steady_clock::now();
+        reset();
+        samples.push_back(chrono::duration<double, nano>(end - start).count()/ops);
+      }
+      double sum = 0, min = samples[0];
+      for (const auto& s: samples) {
+        sum += s;
+        min = std::min(min, s);
+      }
+      double mean = sum/reps, var = 0;
+      for (const auto& s: samples) var += (s - mean)*(s - mean);
+      var = (reps > 1) ? var/(reps - 1) : 0;
+      BenchResult result{name, param, ops, mean, sqrt(var), min};
+      Print(result);
+      results.push_back(result);
+    }
+
+    template<typename Body>
+    void Run(const string& name, long param, size_t ops, Body body) {
+      Run(name, param, ops, body, []{});
+    }
+
+    bool WriteCSV(const char* path) const {
+      ofstream out{path};
+      if (!out) return false;
+      out << "benchmark,param,ops,mean_ns,stddev_ns,min_ns\n";
+      for (const auto& r: results) {
+        out << r.name << ',' << r.param << ',' << r.ops << ',' << r.mean
+            << ',' << r.stddev << ',' << r.min << '\n';
+      }
+      return (bool)out;
+    }
+
+  private:
+    int reps;
+    string filter;
+    vector<BenchResult> results;
+
+    static void Print(const BenchResult& r) {
+      cout << left << setw(28) << r.name << right << setw(9) << r.param
+           << fixed << setprecision(1)
+           << setw(12) << r.mean << " ns/op  +- " << setw(8) << r.stddev
+           << "  min " << setw(10) << r.min << endl;
+    }
+};
+
+// volatile sink so the compiler keeps results of benchmarked calls
+static volatile size_t sink;
+
+const int kDepths[] = {16, 1024, 65536};
+
+// OS with one disk of 1000 cylinders and room for frames one page processes
+static OS MakeOS(int frames) {
+  SysgenParams params{1, 1, 1, {1000}, {}, 10, 4, 4*frames, 4, false, 1,
+                      false, ReplacementPolicy::none, TLBParams{},
+                      PageTableKind::dense, SchedulerParams{},
+                      DeviceTimings{}};
+  return OS{params};
+}
+
+// NewProcess dispatching to the ready queue behind depth ready processes, and
+// to the job pool behind depth jobs when memory is full
+static void BenchNewProcess(BenchRunner& runner) {
+  const int batch = 1000;
+  for (int depth: kDepths) {
+    for (bool full: {false, true}) {
+      OS os = MakeOS(full ? 1 : depth + batch);
+      for (int i = 0; i < depth + full; i++) os.NewProcess(4);
+      vector<size_t> pids(batch);
+      runner.Run(full ? "os/new_process/job_pool" : "os/new_process/ready",
+                 depth, batch,
+                 [&] {for (auto& pid: pids) os.NewProcess(4, &pid);},
+                 [&] {for (auto pid: pids) os.Kill(pid);});
+    }
+  }
+}
+
+// Kill of random ready processes behind depth others, and of processes whose
+// frames admit a job from a job pool of depth jobs
+static void BenchKill(BenchRunner& runner) {
+  const int batch = 1000;
+  for (int depth: kDepths) {
+    for (bool admit: {false, true}) {
+      // memory holds batch processes and the job pool depth when admitting,
+      // otherwise all processes fit in memory
+      size_t capacity = admit ? batch : depth + batch;
+      OS os = MakeOS(capacity);
+      // track where processes are the same way the OS admits them: largest
+      // (all are one page) and oldest first
+      vector<size_t> memory;
+      deque<size_t> job_pool;
+      auto add = [&] {
+        size_t pid;
+        os.NewProcess(4, &pid);
+        if (memory.size() < capacity) memory.push_back(pid);
+        else job_pool.push_back(pid);
+      };
+      for (size_t i = 0; i < capacity + (admit ? depth : 0); i++) add();
+
+      Random random{1};
+      vector<size_t> victims;
+      auto pick = [&] {
+        // batch distinct processes in memory
+        for (int i = 0; i < batch; i++) {
+          swap(memory[i], memory[i + random.Below(memory.size() - i)]);
+        }
+        victims.assign(memory.begin(), memory.begin() + batch);
+        memory.erase(memory.begin(), memory.begin() + batch);
+      };
+      pick();
+      runner.Run(admit ? "os/kill/admit" : "os/kill/ready", depth, batch,
+                 [&] {for (auto pid: victims) os.Kill(pid);},
+                 [&] {
+                   while (memory.size() < capacity && !job_pool.empty()) {
+                     memory.push_back(job_pool.front());
+                     job_pool.pop_front();
+                   }
+                   for (int i = 0; i < batch; i++) add();
+                   pick();
+                 });
+    }
+  }
+}
+
+// AddRequest and PopFinished / RemoveRequest on a disk with depth requests
+static void BenchDisk(BenchRunner& runner) {
+  const int batch = 10000;
+  const int cylinders = 1000;
+  for (int p = 0; p < 7; p++) {
+    DiskPolicy policy = static_cast<DiskPolicy>(p);
+    for (int depth: kDepths) {
+      PCBPool pool;
+      Disk disk{&pool};
+      disk.num_of_cylinders = cylinders;
+      disk.set_policy(policy);
+      Random random{2};
+      vector<PCB*> queued;
+      for (int i = 0; i < depth; i++) {
+        PCB* pcb = pool.Allocate(i, 4, 1);
+        pcb->cylinder_num = random.Below(cylinders);
+        disk.AddRequest(pcb);
+        queued.push_back(pcb);
+      }
+      string name = string("disk/add_pop/") + PolicyName(policy);
+      runner.Run(name, depth, batch, [&] {
+        for (int i = 0; i < batch; i++) {
+          PCB* finished = disk.PopFinished();
+          finished->cylinder_num = random.Below(cylinders);
+          disk.AddRequest(finished);
+        }
+      });
+      name = string("disk/remove_add/") + PolicyName(policy);
+      runner.Run(name, depth, batch, [&] {
+        for (int i = 0; i < batch; i++) {
+          PCB* pcb = queued[random.Below(depth)];
+          disk.RemoveRequest(pcb);
+          pcb->cylinder_num = random.Below(cylinders);
+          disk.AddRequest(pcb);
+        }
+      });
+    }
+  }
+}
+
+// Visiting all requests of a device queue, ns per visited request
+static void BenchVisit(BenchRunner& runner) {
+  for (int depth: kDepths) {
+    PCBPool pool;
+    Disk disk{&pool};
+    disk.num_of_cylinders = 1000;
+    Device* printer = Device::make_device('p', &pool);
+    Random random{3};
+    for (int i = 0; i < depth; i++) {
+      PCB* pcb = pool.Allocate(i, 4, 1);
+      pcb->cylinder_num = random.Below(1000);
+      disk.AddRequest(pcb);
+      printer->AddRequest(pool.Allocate(depth + i, 4, 1));
+    }
+    int passes = std::max(1, 100000/depth);
+    size_t sum = 0;
+    runner.Run("device/visit/disk", depth, (size_t)passes*depth, [&] {
+      for (int i = 0; i < passes; i++)
+        disk.ForEachRequest([&sum](const PCB* p) {sum += p->pid;});
+    });
+    runner.Run("device/visit/printer", depth, (size_t)passes*depth, [&] {
+      for (int i = 0; i < passes; i++)
+        printer->ForEachRequest([&sum](const PCB* p) {sum += p->pid;});
+    });
+    sink = sum;
+    delete printer;
+  }
+}
+
+// AllocateFrames and FreeFrames of pages frames with half of memory used by
+// scattered frames
+static void BenchFrames(BenchRunner& runner) {
+  const int batch = 10000;
+  const int num_of_frames = 1 << 16;
+  for (int pages: {1, 16, 256}) {
+    for (bool contiguous: {false, true}) {
+      FrameAllocator frames{num_of_frames};
+      Random random{4};
+      vector<int> used(num_of_frames/2);
+      frames.AllocateFrames(num_of_frames/2, used.data());
+      vector<int> keep;
+      for (auto frame: used) {
+        if (random.Below(2)) keep.push_back(frame);
+        else frames.FreeFrames(&frame, 1);
+      }
+      vector<int> table(pages);
+      runner.Run(contiguous ? "frames/alloc_free/contiguous"
+                            : "frames/alloc_free/scattered",
+                 pages, batch, [&] {
+        for (int i = 0; i < batch; i++) {
+          frames.AllocateFrames(pages, table.data(), contiguous);
+          frames.FreeFrames(table.data(), pages);
+        }
+      });
+    }
+  }
+}
+
+// Push and pop on a simulator event queue holding depth events
+static void BenchEventQueue(BenchRunner& runner) {
+  const int batch = 100000;
+  for (int depth: kDepths) {
+    EventQueue events;
+    Random random{5};
+    uint64_t seq = 0;
+    for (int i = 0; i < depth; i++) {
+      events.push(Event{(SimTime)random.Below(1 << 30), seq++, EventType::cpu, 0});
+    }
+    runner.Run("sim/event_queue", depth, batch, [&] {
+      for (int i = 0; i < batch; i++) {
+        SimTime now = events.top().time;
+        events.pop();
+        events.push(Event{now + random.Below(1 << 20), seq++, EventType::cpu, 0});
+      }
+    });
+  }
+}
+
+int main(int argc, char* argv[]) {
+  const char* csv_path = nullptr;
+  int reps = 10;
+  string filter;
+  for (int i = 1; i < argc; i++) {
+    if (i+1 < argc && strcmp(argv[i], "--csv") == 0) csv_path = argv[++i];
+    else if (i+1 < argc && strcmp(argv[i], "--reps") == 0) reps = atoi(argv[++i]);
+    else if (i+1 < argc && strcmp(argv[i], "--filter") == 0) filter = argv[++i];
+    else reps = 0;
+  }
+  if (reps < 1) {
+    cerr << "Usage: " << argv[0]
+         << " [--csv <file>] [--reps n] [--filter <name prefix>]" << endl;
+    return 1;
+  }
+
+  BenchRunner runner{reps, filter};
+  BenchNewProcess(runner);
+  BenchKill(runner);
+  BenchDisk(runner);
+  BenchVisit(runner);
+  BenchFrames(runner);
+  BenchEventQueue(runner);
+
+  if (csv_path != nullptr && !runner.WriteCSV(csv_path)) {
+    cerr << "Can not write " << csv_path << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,162 @@
+#include "checkpoint.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+CheckpointImage::CheckpointImage(const char* path) : data_{nullptr}, size_{0} {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return;
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    // writable since restored PCBs are modified in place, private so the
+    // file never is
+    void* data = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                      fd, 0);
+    if (data != MAP_FAILED) {
+      data_ = static_cast<char*>(data);
+      size_ = st.st_size;
+    }
+  }
+  // the mapping keeps the file
+  close(fd);
+}
+
+CheckpointImage::~CheckpointImage() {
+  if (data_ != nullptr) munmap(data_, size_);
+}
+
+namespace os_ops {
+
+  namespace {
+    // bools are written as bytes, structs field by field so no padding
+    // ends up in the file
+    void SaveSysgen(const SysgenParams& params, CheckpointWriter& out) {
+      out.Put<int32_t>(params.printer_num);
+      out.Put<int32_t>(params.disk_num);
+      out.Put<int32_t>(params.cd_num);
+      out.PutVector(params.cyl_nums);
+      out.PutVector(params.disk_policies);
+      out.Put<int32_t>(params.time_slice);
+      out.Put<int32_t>(params.page_size);
+      out.Put<int32_t>(params.mem_size);
+      out.Put<int32_t>(params.max_proc_size);
+      out.Put<uint8_t>(params.contiguous_frames);
+      out.Put<int32_t>(params.cpu_num);
+      out.Put<uint8_t>(params.cpu_affinity);
+      out.Put(params.page_replacement);
+      out.Put<int32_t>(params.tlb.entries);
+      out.Put<int32_t>(params.tlb.ways);
+      out.Put(params.tlb.policy);
+      out.Put<uint8_t>(params.tlb.asid);
+      out.Put(params.page_tables);
+      out.Put(params.scheduler.policy);
+      out.Put<int32_t>(params.scheduler.levels);
+      out.Put<int32_t>(params.scheduler.boost_interval);
+      out.Put<int32_t>(params.scheduler.target_latency);
+      out.Put<int32_t>(params.scheduler.min_granularity);
+      const DeviceTimings& t = params.device_timings;
+      out.Put<uint8_t>(t.enabled);
+      const int fields[] = {t.read_size, t.seek_settle, t.seek_per_cylinder,
+                            t.rpm, t.disk_rate, t.printer_setup,
+                            t.printer_rate, t.cd_access, t.cd_read_rate,
+                            t.cd_write_rate};
+      for (int field: fields) out.Put<int32_t>(field);
+    }
+
+    void RestoreSysgen(CheckpointReader& in, SysgenParams* params) {
+      params->printer_num = in.Get<int32_t>();
+      params->disk_num = in.Get<int32_t>();
+      params->cd_num = in.Get<int32_t>();
+      in.GetVector(&params->cyl_nums);
+      in.GetVector(&params->disk_policies);
+      params->time_slice = in.Get<int32_t>();
+      params->page_size = in.Get<int32_t>();
+      params->mem_size = in.Get<int32_t>();
+      params->max_proc_size = in.Get<int32_t>();
+      params->contiguous_frames = in.Get<uint8_t>();
+      params->cpu_num = in.Get<int32_t>();
+      params->cpu_affinity = in.Get<uint8_t>();
+      params->page_replacement = in.Get<ReplacementPolicy>();
+      params->tlb.entries = in.Get<int32_t>();
+      params->tlb.ways = in.Get<int32_t>();
+      params->tlb.policy = in.Get<TLBPolicy>();
+      params->tlb.asid = in.Get<uint8_t>();
+      params->page_tables = in.Get<PageTableKind>();
+      params->scheduler.policy = in.Get<CPUPolicy>();
+      params->scheduler.levels = in.Get<int32_t>();
+      params->scheduler.boost_interval = in.Get<int32_t>();
+      params->scheduler.target_latency = in.Get<int32_t>();
+      params->scheduler.min_granularity = in.Get<int32_t>();
+      DeviceTimings& t = params->device_timings;
+      t.enabled = in.Get<uint8_t>();
+      int* fields[] = {&t.read_size, &t.seek_settle, &t.seek_per_cylinder,
+                       &t.rpm, &t.disk_rate, &t.printer_setup,
+                       &t.printer_rate, &t.cd_access, &t.cd_read_rate,
+                       &t.cd_write_rate};
+      for (int* field: fields) *field = in.Get<int32_t>();
+    }
+  }
+
+  bool SaveCheckpoint(const OS& os, const char* path, std::string* error) {
+    FILE* file = fopen(path, "wb");
+    if (file == nullptr) {
+      *error = std::string("Can not write ") + path + ": " + strerror(errno);
+      return false;
+    }
+    CheckpointWriter out{file};
+    CheckpointHeader header{};
+    memcpy(header.magic, kCheckpointMagic, sizeof(header.magic));
+    header.version = kCheckpointVersion;
+    header.pcb_size = sizeof(PCB);
+    out.Put(header);
+    SaveSysgen(os.sysgen(), out);
+    os.Save(out);
+    bool ok = out.ok();
+    if (fclose(file) != 0) ok = false;
+    if (!ok) {
+      *error = std::string("Can not write ") + path + ": " + strerror(errno);
+      remove(path);
+    }
+    return ok;
+  }
+
+  bool LoadCheckpoint(const char* path, std::unique_ptr<OS>* os,
+                      std::string* error) {
+    std::shared_ptr<CheckpointImage> image = std::make_shared<CheckpointImage>(path);
+    if (!image->is_open()) {
+      *error = std::string("Can not read ") + path + ": " + strerror(errno);
+      return false;
+    }
+    CheckpointReader in{image};
+    CheckpointHeader header = in.Get<CheckpointHeader>();
+    if (!in.ok() || memcmp(header.magic, kCheckpointMagic, sizeof(header.magic)) != 0) {
+      *error = std::string(path) + " is not a checkpoint";
+      return false;
+    }
+    if (header.version != kCheckpointVersion || header.pcb_size != sizeof(PCB)) {
+      *error = std::string(path) + " was written by another version";
+      return false;
+    }
+    SysgenParams params;
+    RestoreSysgen(in, &params);
+    if (!in.ok() || !ValidSysgen(params, error)) {
+      // a valid checkpoint only holds valid parameters
+      if (in.ok()) *error = std::string(path) + " is corrupt: " + *error;
+      else *error = std::string(path) + " is truncated";
+      return false;
+    }
+    std::unique_ptr<OS> restored{new OS{params}};
+    if (!restored->Restore(in) || !in.ok()) {
+      *error = std::string(path) + " is corrupt";
+      return false;
+    }
+    *os = std::move(restored);
+    return true;
+  }
+
+}
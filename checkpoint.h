@@ -0,0 +1,39 @@
+// Checkpoints: the complete state of an OS saved to a binary file and
+// restored later, possibly by another run of the same build. A checkpoint is
+// a header, the Sysgen parameters and what OS::Save writes. Restoring maps
+// the file copy-on-write, so the PCBs of large systems are used in place and
+// only read from disk when touched.
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "os.h"
+
+namespace os_ops {
+
+// First bytes of every checkpoint
+struct CheckpointHeader {
+  char magic[4];      // kCheckpointMagic
+  uint32_t version;   // kCheckpointVersion
+  uint32_t pcb_size;  // sizeof(PCB) of the build that wrote it
+  uint32_t reserved;
+};
+const char kCheckpointMagic[4] = {'O', 'S', 'C', 'P'};
+// Changes whenever the format does
+const uint32_t kCheckpointVersion = 3;
+
+// Save the state of os to path. Returns false and stores the reason in error
+// on failure.
+bool SaveCheckpoint(const OS& os, const char* path, std::string* error);
+
+// Create *os from the checkpoint at path. Returns false and stores the
+// reason in error if it can not be read or was written by another build.
+bool LoadCheckpoint(const char* path, std::unique_ptr<OS>* os,
+                    std::string* error);
+
+}
+
+#endif
@@ -0,0 +1,134 @@
+// Streams of checkpoint files: the state of an OS is written field by field in
+// host byte order and read back from a copy-on-write mapping of the file, so
+// large arrays can be used in place instead of being copied.
+#ifndef CHECKPOINT_IO_H
+#define CHECKPOINT_IO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Spans are aligned to this in the file, so they can be used in place
+const size_t kCheckpointAlign = 64;
+
+class CheckpointWriter {
+  public:
+    // out must be open for binary writing and outlive the writer
+    explicit CheckpointWriter(FILE* out) : out{out} {}
+
+    bool ok() const {return !failed;}
+    size_t offset() const {return pos;}
+
+    void Write(const void* data, size_t size) {
+      if (size > 0 && fwrite(data, 1, size, out) != size) failed = true;
+      pos += size;
+    }
+    template<typename T>
+    void Put(const T& value) {
+      static_assert(std::is_trivially_copyable<T>::value, "raw copy");
+      Write(&value, sizeof(value));
+    }
+    // Size followed by the elements
+    template<typename T>
+    void PutVector(const std::vector<T>& values) {
+      static_assert(std::is_trivially_copyable<T>::value, "raw copy");
+      Put<uint64_t>(values.size());
+      Write(values.data(), values.size()*sizeof(T));
+    }
+    // Pad to kCheckpointAlign before a span read in place
+    void Align() {
+      static const char zeros[kCheckpointAlign] = {0};
+      Write(zeros, (kCheckpointAlign - pos % kCheckpointAlign) % kCheckpointAlign);
+    }
+
+  private:
+    FILE* out;
+    size_t pos = 0;
+    bool failed = false;
+};
+
+// Private writable mapping of a whole checkpoint file. Pages are only read
+// from the file when touched and only copied when written.
+class CheckpointImage {
+  public:
+    explicit CheckpointImage(const char* path);
+    ~CheckpointImage();
+    CheckpointImage(const CheckpointImage&) = delete;
+    CheckpointImage& operator=(const CheckpointImage&) = delete;
+
+    bool is_open() const {return data_ != nullptr;}
+    char* data() const {return data_;}
+    size_t size() const {return size_;}
+
+  private:
+    char* data_;
+    size_t size_;
+};
+
+// Reads what a CheckpointWriter wrote. Reading past the end or Fail() makes
+// the reader fail, after which reads return zeros; callers check ok() once
+// they are done.
+class CheckpointReader {
+  public:
+    explicit CheckpointReader(const std::shared_ptr<CheckpointImage>& image) :
+        image_{image}, pos{image->data()}, end{image->data() + image->size()} {}
+
+    bool ok() const {return !failed;}
+    void Fail() {failed = true;}
+    // Mapping spans point into, anything using them must share it
+    const std::shared_ptr<CheckpointImage>& image() const {return image_;}
+
+    void Read(void* data, size_t size) {
+      if (failed || (size_t)(end - pos) < size) {
+        failed = true;
+        memset(data, 0, size);
+        return;
+      }
+      memcpy(data, pos, size);
+      pos += size;
+    }
+    template<typename T>
+    T Get() {
+      static_assert(std::is_trivially_copyable<T>::value, "raw copy");
+      T value;
+      Read(&value, sizeof(value));
+      return value;
+    }
+    template<typename T>
+    void GetVector(std::vector<T>* values) {
+      uint64_t size = Get<uint64_t>();
+      if (failed || size > (uint64_t)(end - pos)/sizeof(T)) {
+        failed = true;
+        values->clear();
+        return;
+      }
+      values->resize(size);
+      Read(values->data(), size*sizeof(T));
+    }
+    // size bytes in place after padding to kCheckpointAlign, nullptr if the
+    // file ends before
+    char* Span(size_t size) {
+      size_t offset = pos - image_->data();
+      size_t padding = (kCheckpointAlign - offset % kCheckpointAlign) % kCheckpointAlign;
+      if (failed || (size_t)(end - pos) < padding ||
+          (size_t)(end - pos) - padding < size) {
+        failed = true;
+        return nullptr;
+      }
+      char* span = pos + padding;
+      pos = span + size;
+      return span;
+    }
+
+  private:
+    std::shared_ptr<CheckpointImage> image_;
+    char* pos;
+    char* end;
+    bool failed = false;
+};
+
+#endif
@@ -0,0 +1,273 @@
+#include "config.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "trace.h"
+
+namespace os_ops {
+
+  namespace {
+    // Value of cylinders or policy: a list for the disks in order, or one
+    // value for the disks first to last (1-based)
+    template<typename T>
+    struct DiskSetting {
+      int first, last;  // 0 for a list
+      std::vector<T> values;
+      int line;
+    };
+
+    // [begin, end) without the spaces and tabs at both ends
+    std::string Trim(const char* begin, const char* end) {
+      while (begin < end && (*begin == ' ' || *begin == '\t' || *begin == '\r'))
+        begin++;
+      while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r'))
+        end--;
+      return std::string(begin, end);
+    }
+
+    bool ParseInt(const std::string& s, int* value) {
+      if (s.empty()) return false;
+      char* end;
+      errno = 0;
+      long result = strtol(s.c_str(), &end, 10);
+      if (*end != '\0' || errno != 0 || result < INT_MIN || result > INT_MAX)
+        return false;
+      *value = result;
+      return true;
+    }
+
+    bool ParseValue(const std::string& s, int* value) {return ParseInt(s, value);}
+    bool ParseValue(const std::string& s, DiskPolicy* value) {
+      return ParsePolicy(s, value);
+    }
+
+    // Append the values of "v, v*n, ..." to values. Returns false if a value
+    // or count is invalid or the list is longer than the most disks.
+    template<typename T>
+    bool ParseList(const std::string& text, std::vector<T>* values) {
+      size_t pos = 0;
+      while (true) {
+        size_t comma = text.find(',', pos);
+        if (comma == std::string::npos) comma = text.size();
+        std::string item = Trim(text.data() + pos, text.data() + comma);
+        size_t star = item.find('*');
+        int count = 1;
+        T value;
+        if (star != std::string::npos) {
+          if (!ParseInt(Trim(item.data() + star + 1, item.data() + item.size()),
+                        &count) || count < 1 ||
+              count > kMaxDisks - (int)values->size())
+            return false;
+          item = Trim(item.data(), item.data() + star);
+        }
+        if (!ParseValue(item, &value) || values->size() == (size_t)kMaxDisks)
+          return false;
+        values->insert(values->end(), count, value);
+        if (comma == text.size()) return true;
+        pos = comma + 1;
+      }
+    }
+
+    // Parse "n" or "first-last" of a disk subscript
+    bool ParseDiskRange(const std::string& s, int* first, int* last) {
+      size_t dash = s.find('-');
+      if (dash == std::string::npos) {
+        if (!ParseInt(s, first)) return false;
+        *last = *first;
+      }
+      else if (!ParseInt(Trim(s.data(), s.data() + dash), first) ||
+               !ParseInt(Trim(s.data() + dash + 1, s.data() + s.size()), last))
+        return false;
+      return *first >= 1 && *first <= *last;
+    }
+
+    // Apply settings in file order to the values of num_of_disks disks,
+    // marking the disks they name in set. Returns false and stores the
+    // reason in error if a setting does not fit the disks.
+    template<typename T>
+    bool ApplyDiskSettings(const std::vector<DiskSetting<T>>& settings,
+                           int num_of_disks, std::vector<T>* values,
+                           std::vector<bool>* set, std::string* error) {
+      for (const auto& s: settings) {
+        int first = s.first, last = s.last;
+        if (first == 0 && s.values.size() == 1) {
+          first = 1;
+          last = num_of_disks;
+        }
+        if (first == 0) {
+          if (s.values.size() != (size_t)num_of_disks) {
+            *error = "line " + std::to_string(s.line) + ": " +
+                     std::to_string(s.values.size()) + " values for " +
+                     std::to_string(num_of_disks) + " disks";
+            return false;
+          }
+          *values = s.values;
+          set->assign(num_of_disks, true);
+        }
+        else if (last > num_of_disks) {
+          *error = "line " + std::to_string(s.line) + ": no disk " +
+                   std::to_string(last);
+          return false;
+        }
+        else {
+          std::fill(values->begin() + first - 1, values->begin() + last, s.values[0]);
+          std::fill(set->begin() + first - 1, set->begin() + last, true);
+        }
+      }
+      return true;
+    }
+  }
+
+  bool ParseConfig(const char* data, size_t size, SysgenParams* params,
+                   std::string* error) {
+    struct Scalar {
+      const char* key;
+      int* value;
+      bool set;
+    };
+    Scalar scalars[] = {
+        {"printers", &params->printer_num, false},
+        {"disks", &params->disk_num, false},
+        {"cds", &params->cd_num, false},
+        {"time_slice", &params->time_slice, false},
+        {"page_size", &params->page_size, false},
+        {"memory_size", &params->mem_size, false},
+        {"max_process_size", &params->max_proc_size, false}};
+    std::vector<DiskSetting<int>> cylinders;
+    std::vector<DiskSetting<DiskPolicy>> policies;
+
+    const char* end = data + size;
+    int line = 0;
+    for (const char* pos = data; pos < end;) {
+      const char* eol = static_cast<const char*>(memchr(pos, '\n', end - pos));
+      if (eol == nullptr) eol = end;
+      line++;
+      const char* comment = std::find_if(pos, eol, [](char ch) {
+        return ch == '#' || ch == ';';
+      });
+      std::string text = Trim(pos, comment);
+      pos = eol + 1;
+      if (text.empty() || (text.front() == '[' && text.back() == ']')) continue;
+
+      std::string where = "line " + std::to_string(line) + ": ";
+      size_t equals = text.find('=');
+      if (equals == std::string::npos) {
+        *error = where + "expected <key> = <value>";
+        return false;
+      }
+      std::string key = Trim(text.data(), text.data() + equals);
+      std::string value = Trim(text.data() + equals + 1, text.data() + text.size());
+
+      // per-disk keys, with an optional [disk] or [first-last] subscript
+      int first = 0, last = 0;
+      size_t bracket = key.find('[');
+      std::string name = Trim(key.data(), key.data() + std::min(bracket, key.size()));
+      if (name == "cylinders" || name == "policy") {
+        if (bracket != std::string::npos &&
+            (key.back() != ']' ||
+             !ParseDiskRange(Trim(key.data() + bracket + 1,
+                                  key.data() + key.size() - 1), &first, &last))) {
+          *error = where + "invalid disk range " + key;
+          return false;
+        }
+        bool valid;
+        if (name == "cylinders") {
+          cylinders.push_back(DiskSetting<int>{first, last, {}, line});
+          valid = ParseList(value, &cylinders.back().values);
+          valid = valid && (first == 0 || cylinders.back().values.size() == 1);
+        }
+        else {
+          policies.push_back(DiskSetting<DiskPolicy>{first, last, {}, line});
+          valid = ParseList(value, &policies.back().values);
+          valid = valid && (first == 0 || policies.back().values.size() == 1);
+        }
+        if (!valid) {
+          *error = where + "invalid " + key + " " + value;
+          return false;
+        }
+        continue;
+      }
+
+      Scalar* scalar = std::find_if(std::begin(scalars), std::end(scalars),
+                                    [&](const Scalar& s) {return key == s.key;});
+      if (scalar == std::end(scalars)) {
+        *error = where + "unknown key " + key;
+        return false;
+      }
+      if (scalar->set) {
+        *error = where + key + " given twice";
+        return false;
+      }
+      if (!ParseInt(value, scalar->value)) {
+        *error = where + key + " is not a number";
+        return false;
+      }
+      scalar->set = true;
+    }
+
+    for (auto& scalar: scalars) {
+      if (scalar.set) continue;
+      if (scalar.value == &params->disk_num) {
+        // as many as the first list of cylinders, none without
+        params->disk_num = 0;
+        for (const auto& s: cylinders) {
+          if (s.first != 0) continue;
+          params->disk_num = s.values.size();
+          break;
+        }
+      }
+      else {
+        *error = std::string("missing ") + scalar.key;
+        return false;
+      }
+    }
+    if (params->disk_num < 0 || params->disk_num > kMaxDisks) {
+      *error = "Number of disk devices must be 0-2^20";
+      return false;
+    }
+
+    std::vector<bool> set(params->disk_num, false);
+    params->cyl_nums.assign(params->disk_num, 0);
+    if (!ApplyDiskSettings(cylinders, params->disk_num, &params->cyl_nums,
+                           &set, error))
+      return false;
+    auto unset = std::find(set.begin(), set.end(), false);
+    if (unset != set.end()) {
+      *error = "no cylinders for disk " + std::to_string(unset - set.begin() + 1);
+      return false;
+    }
+    params->disk_policies.assign(params->disk_num, DiskPolicy::fscan);
+    if (!ApplyDiskSettings(policies, params->disk_num, &params->disk_policies,
+                           &set, error))
+      return false;
+
+    params->cpu_num = 1;
+    params->cpu_affinity = false;
+    params->contiguous_frames = false;
+    params->page_replacement = ReplacementPolicy::none;
+    params->tlb = TLBParams{};
+    params->page_tables = PageTableKind::dense;
+    params->scheduler = SchedulerParams{};
+    params->device_timings = DeviceTimings{};
+    return ValidSysgen(*params, error);
+  }
+
+  bool LoadConfig(const char* path, SysgenParams* params, std::string* error) {
+    MappedFile file{path};
+    if (!file.is_open()) {
+      *error = std::string("Can not read ") + path;
+      return false;
+    }
+    if (!ParseConfig(file.data(), file.size(), params, error)) {
+      *error = std::string(path) + ": " + *error;
+      return false;
+    }
+    return true;
+  }
+
+}
@@ -0,0 +1,48 @@
+// Sysgen parameters from a configuration file instead of the interactive
+// prompts, for systems with too many devices to type in:
+//
+//   # storage tier        (comments start with # or ;)
+//   [devices]             (section headers only group keys)
+//   printers = 2
+//   cds = 1
+//   disks = 10000
+//   cylinders = 200           one value for every disk
+//   cylinders[1-100] = 400    disks 1 to 100
+//   policy = c-look
+//   policy[5] = sstf
+//   [cpu]
+//   time_slice = 10
+//   [memory]
+//   page_size = 4
+//   memory_size = 512
+//   max_process_size = 64
+//
+// cylinders and policy (fcfs/sstf/scan/c-scan/look/c-look/fscan, FSCAN if not
+// given) also take a list with a value per disk, where v*n repeats v n times
+// (e.g. cylinders = 200*5000, 400*5000). Later keys override earlier ones for
+// the disks they name. disks defaults to the length of the first cylinders
+// list, and is at most 2^20. The other parameters are as for a trace: one
+// round robin CPU, all pages of a process in memory, dense page tables and no
+// TLB.
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <cstddef>
+#include <string>
+
+#include "os.h"
+
+namespace os_ops {
+
+// Parse the size bytes of configuration at data into params. Returns false
+// and stores the reason in error if a key is unknown, missing or invalid (with
+// the line of the key), or params break a rule of ValidSysgen.
+bool ParseConfig(const char* data, size_t size, SysgenParams* params,
+                 std::string* error);
+
+// Parse the configuration file at path into params, as ParseConfig
+bool LoadConfig(const char* path, SysgenParams* params, std::string* error);
+
+}
+
+#endif
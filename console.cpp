@@ -0,0 +1,276 @@
+// Implementation of the interactive console front-end in console.h
+
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include "console.h"
+
+namespace os_ops {
+
+  // Get input from standard input stream until input type matches type T of
+  // variable it is being stored in.
+  // Returns retrieved input.
+  template<typename T>
+  T InputWithTypeCheck(const std::string& error_message) {
+    T input_var;
+    std::cin >> input_var;
+    while (std::cin.fail()) {
+      std::cout << error_message << ": ";
+      std::cin.clear();
+      std::cin.ignore(256,'\n');
+      std::cin >> input_var;
+    }
+    return input_var;
+  }
+
+  // Ask for duration of time slice process was in CPU until system call,
+  // at most the time slice of the active process (which MLFQ and CFS vary).
+  // Return duration.
+  int PromptBurst(const OS& os) {
+    std::cout << "Duration of time slice process was in the CPU: ";
+    int duration = InputWithTypeCheck<int>("Duration invalid: ");
+    while (duration < 0 || duration > os.quantum()) {
+      std::cout << "Duration must be 0-" << os.quantum() << ": ";
+      duration = InputWithTypeCheck<int>("Duration invalid: ");
+    }
+    return duration;
+  }
+
+  void PrintTerminated(const ProcessStats& stats) {
+    float avg_burst_time = (stats.bursts == 0) ? 0 : stats.cpu_time/stats.bursts;
+    std::cout << "Process " << stats.pid << " terminated. ";
+    std::cout << "Total CPU time: " << stats.cpu_time
+              << ", avg. burst time: " << avg_burst_time << std::endl;
+  }
+
+  void PromptNewProcess(OS& os) {
+    std::cout << "Process " << os.next_pid() << " arrived" << std::endl;
+    std::cout << "Process size: ";
+    int proc_size = InputWithTypeCheck<int>("Process size invalid: ");
+    while (proc_size <= 0) {
+      std::cout << "Process size must be > 0: ";
+      proc_size = InputWithTypeCheck<int>("Process size invalid: ");
+    }
+    if (os.NewProcess(proc_size) == Status::too_large) {
+      std::cerr << "Rejecting process with size (" << proc_size
+                << ") larger than maximum process size ("
+                << os.max_process_size() << ")" << std::endl;
+    }
+  }
+
+  void PromptIORequest(OS& os, char device_type, int device_num) {
+    if (os.active() == nullptr) {
+      std::cerr << "I/O request failed. CPU has no active process" << std::endl;
+      return;
+    }
+    int burst = PromptBurst(os);
+
+    // get all IO request information
+    std::cout << "File name (max 20 characters): ";
+    std::string file_name = InputWithTypeCheck<std::string>("File name invalid");
+    while (file_name.size() > 20) {
+      std::cout << "File name too large. Try again: ";
+      file_name = InputWithTypeCheck<std::string>("File name invalid");
+    }
+
+    int proc_size = os.active()->size;
+    int start_mem_loc = -1;
+    bool invalid = true;
+    std::cout << "Starting location in memory (hex): ";
+    while (invalid) {
+      std::string start_mem_loc_str = InputWithTypeCheck<std::string>("Memory location invalid");
+      // make sure memory input is valid hex
+      while (start_mem_loc_str.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) {
+        start_mem_loc_str = InputWithTypeCheck<std::string>("Memory location invalid");
+      }
+      std::istringstream ss{start_mem_loc_str};
+      ss >> std::hex >> start_mem_loc;
+      if (start_mem_loc >= 0 && start_mem_loc < proc_size) {
+        invalid = false;
+      }
+      else {
+        std::cout << "Start memory location must be >= 0 and < " << proc_size << ": ";
+      }
+    }
+
+    char operation = 'w';
+    if (device_type != 'p') {  // if device is a printer, only write operation
+      std::cout << "Read or write (r/w): ";
+      operation = InputWithTypeCheck<char>("Operation invalid (r/w)");
+      while (operation != 'r' && operation != 'w') {
+        std::cout << "Operation has to be read(r) or write(w): ";
+        operation = InputWithTypeCheck<char>("Operation invalid (r/w)");
+      }
+    }
+
+    int cylinder = -1;
+    if (device_type == 'd') {  // if device is disk, ask for cylinder number
+      int num_of_cylinders = os.disk_cylinders(device_num);
+      std::cout << "Cylinder to access: ";
+      cylinder = InputWithTypeCheck<int>("Cylinder number invalid");
+      while (cylinder < 0 || cylinder > num_of_cylinders-1) {
+        std::cout << "Cylinder number must be 0-"
+                  << num_of_cylinders - 1
+                  << ": ";
+        cylinder = InputWithTypeCheck<int>("Cylinder number invalid");
+      }
+    }
+
+    int file_size = 0;
+    if (operation == 'w') {
+      std::cout << "Write file size: ";
+      file_size = InputWithTypeCheck<int>("File size invalid");
+      while (file_size <= 0) {
+        std::cout << "File size must be > 0: ";
+        file_size = InputWithTypeCheck<int>("File size invalid");
+      }
+    }
+
+    size_t physical_loc;
+    IOParams params{file_name.c_str(), start_mem_loc, operation, cylinder,
+                    file_size};
+    Status status = os.IORequest(device_type, device_num, burst, params,
+                                 &physical_loc);
+    if (status != Status::ok) {
+      std::cerr << "I/O request failed. " << StatusMessage(status) << std::endl;
+      return;
+    }
+    std::cout << "Physical address: " << std::hex << physical_loc << std::dec
+              << std::endl;
+  }
+
+  void PromptInterrupt(OS& os, char device_type, int device_num) {
+    size_t pid;
+    Status status = os.HandleInterrupt(device_type, device_num, &pid);
+    if (status == Status::queue_empty) {
+      std::cerr << "Device queue empty." << std::endl;
+      return;
+    }
+    if (status != Status::ok) {
+      std::cerr << StatusMessage(status) << std::endl;
+      return;
+    }
+    std::cout << "IO request for process " << pid << " completed"
+              << std::endl;
+  }
+
+  void PromptTerminate(OS& os) {
+    if (os.active() == nullptr) {
+      std::cerr << "No active process to terminate" << std::endl;
+      return;
+    }
+    ProcessStats stats;
+    if (os.TerminateActiveProcess(PromptBurst(os), &stats) == Status::ok)
+      PrintTerminated(stats);
+  }
+
+  void PromptEndOfTimeSlice(OS& os) {
+    if (os.EndOfTimeSlice() == Status::no_active_process)
+      std::cerr << "No active process" << std::endl;
+  }
+
+  void PromptKill(OS& os, int proc_id) {
+    ProcessStats stats;
+    if (os.Kill(proc_id, false, &stats) == Status::no_such_process) {
+      std::cerr << "Process with pid " << proc_id << " does not exist" << std::endl;
+      return;
+    }
+    PrintTerminated(stats);
+  }
+
+  void PromptSnapshot(const OS& os) {
+    std::cout << "Show r/p/d/c/m/j: ";
+    char snap_type = InputWithTypeCheck<char>("Invalid snapshot type (r/p/d/c)");
+    while (snap_type != 'r' && snap_type != 'p' && snap_type != 'd' &&
+           snap_type != 'c' && snap_type != 'm' && snap_type != 'j') {
+      std::cout << "Invalid, not r/p/d/c" << std::endl;
+      snap_type = InputWithTypeCheck<char>("Invalid snapshot type (r/p/d/c/m/j)");
+    }
+    std::cin.ignore(std::numeric_limits<std::streamsize>::max(),'\n');
+    os.Snapshot(snap_type, std::cout, 22);
+  }
+
+  OS Sysgen() {
+    std::cout << "SYSGEN" << std::endl;
+    std::cout << "Num of printer devices: ";
+    int printer_num = InputWithTypeCheck<int>("Invalid number of printers");
+    while (printer_num < 0) {
+      std::cout << "Number of printers must be >= 0: ";
+      printer_num = InputWithTypeCheck<int>("Invalid number of printers");
+    }
+
+    std::cout << "Num of disk devices: ";
+    int disk_num = InputWithTypeCheck<int>("Invalid number of disk devices");
+    while (disk_num < 0 || disk_num > kMaxDisks) {
+      std::cout << "Number of disk devices must be 0-2^20: ";
+      disk_num = InputWithTypeCheck<int>("Invalid number of disk devices");
+    }
+    std::vector<int> cyl_nums;
+    std::vector<DiskPolicy> disk_policies;
+    for (int i = 0; i < disk_num; i++) {
+      std::cout << "Num of disk " << i+1 << " cylinders: ";
+      int num_of_cylinders = InputWithTypeCheck<int>("Invalid number of cylinders");
+      while (num_of_cylinders < 0) {
+        std::cout << "Number of cylinders must be >= 0: ";
+        num_of_cylinders = InputWithTypeCheck<int>("Invalid number of cylinders");
+      }
+      cyl_nums.push_back(num_of_cylinders);
+
+      std::cout << "Disk " << i+1
+                << " scheduling policy (fcfs/sstf/scan/c-scan/look/c-look/fscan): ";
+      DiskPolicy policy;
+      std::string policy_name = InputWithTypeCheck<std::string>("Invalid scheduling policy");
+      while (!ParsePolicy(policy_name, &policy)) {
+        std::cout << "Policy must be fcfs/sstf/scan/c-scan/look/c-look/fscan: ";
+        policy_name = InputWithTypeCheck<std::string>("Invalid scheduling policy");
+      }
+      disk_policies.push_back(policy);
+    }
+
+    std::cout << "Num of cd-rw devices: ";
+    int cd_num = InputWithTypeCheck<int>("Invalid number of cd-rw devices");
+    while (cd_num < 0) {
+      std::cout << "Number of cd-rw devices must be >= 0: ";
+      cd_num = InputWithTypeCheck<int>("Invalid number of cd-rw devices");
+    }
+
+    std::cout << "Length of time slice (ms): ";
+    int time_slice = InputWithTypeCheck<int>("Invalid time slice length");
+    while (time_slice <= 0) {
+      std::cout << "Length of time slice must be > 0: ";
+      time_slice = InputWithTypeCheck<int>("Invalid time slice length");
+    }
+
+    std::cout << "Page size: ";
+    int page_size = InputWithTypeCheck<int>("Invalid page size");
+    while (page_size <= 0 || (page_size & (~page_size+1)) != page_size) {
+      std::cout << "Page size must be > 0 and a power of 2: ";
+      page_size = InputWithTypeCheck<int>("Invalid page size");
+    }
+
+    std::cout << "Size of memory: ";
+    int memory_size = InputWithTypeCheck<int>("Invalid memory size");
+    while (memory_size <= 0 || memory_size % page_size != 0 ||
+           memory_size/page_size > kPageFrame + 1) {
+      std::cout << "Memory size must be > 0, multiple of page size and at most 2^28 pages: ";
+      memory_size = InputWithTypeCheck<int>("Invalid memory size");
+    }
+
+    std::cout << "Max process size: ";
+    int max_proc_size = InputWithTypeCheck<int>("Invalid max process size");
+    while (max_proc_size <= 0 || max_proc_size > memory_size) {
+      std::cout << "Max process size must be > 0 and <= " << memory_size << ": ";
+      max_proc_size = InputWithTypeCheck<int>("Invalid max process size");
+    }
+
+    SysgenParams params{printer_num, disk_num, cd_num, cyl_nums, disk_policies,
+                        time_slice, page_size, memory_size, max_proc_size,
+                        false, 1, false, ReplacementPolicy::none, TLBParams{},
+                        PageTableKind::dense, SchedulerParams{},
+                        DeviceTimings{}};
+    return OS{params};
+  }
+
+}
@@ -0,0 +1,38 @@
+// Interactive console front-end for the OS in os.h. Prompts for all
+// parameters on standard input and prints results on standard output.
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include "os.h"
+
+namespace os_ops {
+
+// Generate an operating system with numbers of devices taken from user input.
+// Returns created OS
+OS Sysgen();
+
+// Ask for process size and add new process to the OS.
+void PromptNewProcess(OS& os);
+
+// Ask for I/O parameters of the active process and send it to device
+// device_num of device_type.
+void PromptIORequest(OS& os, char device_type, int device_num);
+
+// Report completion of the I/O request at the head of a device queue.
+void PromptInterrupt(OS& os, char device_type, int device_num);
+
+// Ask for the last burst of the active process and terminate it.
+void PromptTerminate(OS& os);
+
+// Move the active process to the back of the ready queue.
+void PromptEndOfTimeSlice(OS& os);
+
+// Kill process with pid == proc_id.
+void PromptKill(OS& os, int proc_id);
+
+// Ask for snapshot type and print it in 24 line chunks.
+void PromptSnapshot(const OS& os);
+
+}
+
+#endif
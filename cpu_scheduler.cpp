@@ -0,0 +1,221 @@
+#include "cpu_scheduler.h"
+
+const char* kCPUPolicyNames[] = {"rr", "mlfq", "cfs"};
+
+const char* CPUPolicyName(CPUPolicy policy) {
+  return kCPUPolicyNames[static_cast<int>(policy)];
+}
+bool ParseCPUPolicy(const std::string& name, CPUPolicy* policy) {
+  for (int i = 0; i < 3; i++) {
+    if (name == kCPUPolicyNames[i]) {
+      *policy = static_cast<CPUPolicy>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+int NiceWeight(int nice) {
+  // Linux's weights: 1024/1.25^nice, rounded
+  static const int kWeights[] = {
+    88761, 71755, 56483, 46273, 36291, 29154, 23254, 18705, 14949, 11916,
+    9548, 7620, 6100, 4904, 3906, 3121, 2501, 1991, 1586, 1277,
+    1024, 820, 655, 526, 423, 335, 272, 215, 172, 137,
+    110, 87, 70, 56, 45, 36, 29, 23, 18, 15};
+  return kWeights[nice - kMinNice];
+}
+
+RunQueue::~RunQueue() {}
+RunQueue* RunQueue::make_run_queue(const SchedulerParams& params,
+                                   int time_slice, const PCBPool* pool) {
+  switch (params.policy) {
+    case CPUPolicy::round_robin: return new RoundRobinQueue{time_slice, pool};
+    case CPUPolicy::mlfq: return new MLFQueue{params.levels, time_slice, pool};
+    case CPUPolicy::cfs:
+      return new CFSQueue{params.target_latency, params.min_granularity, pool};
+  }
+  return nullptr;
+}
+
+
+PCB* RoundRobinQueue::Next() {
+  PCB* p = queue.front();
+  if (p != nullptr) Remove(p);
+  return p;
+}
+
+PCB* RoundRobinQueue::Steal() {
+  PCB* p = queue.back();
+  if (p != nullptr) Remove(p);
+  return p;
+}
+
+void RoundRobinQueue::Save(CheckpointWriter& out) const {
+  out.Put<uint64_t>(count);
+  queue.Save(out);
+}
+
+void RoundRobinQueue::Restore(CheckpointReader& in) {
+  count = in.Get<uint64_t>();
+  queue.Restore(in);
+}
+
+void RoundRobinQueue::VisitReady(RequestVisitor& visitor) const {
+  for (PCB* p: queue) visitor.Visit(p);
+}
+
+
+MLFQueue::MLFQueue(int levels, int time_slice, const PCBPool* pool) :
+    time_slice{time_slice} {
+  queues.reserve(levels);
+  for (int i = 0; i < levels; i++) queues.emplace_back(pool);
+}
+
+void MLFQueue::Add(PCB* p) {
+  queues[p->priority].push_back(p);
+  non_empty |= 1u << p->priority;
+  count++;
+}
+
+void MLFQueue::Remove(PCB* p) {
+  PCBQueue& queue = queues[p->priority];
+  queue.erase(p);
+  if (queue.empty()) non_empty &= ~(1u << p->priority);
+  count--;
+}
+
+PCB* MLFQueue::Pop(int level, bool front) {
+  PCB* p = front ? queues[level].front() : queues[level].back();
+  Remove(p);
+  return p;
+}
+
+PCB* MLFQueue::Next() {
+  // lowest set bit is the highest priority level with processes
+  if (non_empty == 0) return nullptr;
+  return Pop(__builtin_ctz(non_empty), true);
+}
+
+PCB* MLFQueue::Steal() {
+  // the last process of the lowest priority level, the one that would
+  // have waited longest
+  if (non_empty == 0) return nullptr;
+  return Pop(31 - __builtin_clz(non_empty), false);
+}
+
+void MLFQueue::Expired(PCB* p) {
+  if (p->priority + 1 < levels()) p->priority++;
+}
+
+void MLFQueue::Woken(PCB* p) {
+  if (p->priority > 0) p->priority--;
+}
+
+void MLFQueue::Boost() {
+  // lower levels join the top level behind it, keeping their order
+  for (int level = 1; level < levels(); level++) {
+    while (!queues[level].empty()) {
+      PCB* p = Pop(level, true);
+      p->priority = 0;
+      Add(p);
+    }
+  }
+}
+
+void MLFQueue::Save(CheckpointWriter& out) const {
+  out.Put<uint64_t>(count);
+  out.Put<int32_t>(levels());
+  for (const auto& queue: queues) queue.Save(out);
+  out.Put(non_empty);
+}
+
+void MLFQueue::Restore(CheckpointReader& in) {
+  count = in.Get<uint64_t>();
+  if (in.Get<int32_t>() != levels()) {
+    in.Fail();
+    return;
+  }
+  for (auto& queue: queues) queue.Restore(in);
+  non_empty = in.Get<uint32_t>();
+}
+
+void MLFQueue::VisitReady(RequestVisitor& visitor) const {
+  for (const auto& queue: queues) {
+    for (PCB* p: queue) visitor.Visit(p);
+  }
+}
+
+
+void CFSQueue::Add(PCB* p) {
+  // sleepers get at most half a latency of credit
+  int64_t floor = min_vruntime - target_latency*1000/2;
+  if (p->vruntime < floor) p->vruntime = floor;
+  tree.emplace(std::make_pair(p->vruntime, p->pid), p->handle);
+  total_weight += NiceWeight(p->nice);
+  count++;
+}
+
+void CFSQueue::Remove(PCB* p) {
+  tree.erase(std::make_pair(p->vruntime, p->pid));
+  total_weight -= NiceWeight(p->nice);
+  count--;
+}
+
+PCB* CFSQueue::Pop(PCBHandle handle) {
+  PCB* p = pool->get(handle);
+  Remove(p);
+  return p;
+}
+
+PCB* CFSQueue::Next() {
+  if (tree.empty()) return nullptr;
+  PCB* p = Pop(tree.begin()->second);
+  if (p->vruntime > min_vruntime) min_vruntime = p->vruntime;
+  return p;
+}
+
+PCB* CFSQueue::Steal() {
+  // the process furthest ahead loses least by moving
+  if (tree.empty()) return nullptr;
+  return Pop(std::prev(tree.end())->second);
+}
+
+int CFSQueue::Quantum(const PCB* p) const {
+  // p has been taken out of the queue to run
+  int64_t weight = NiceWeight(p->nice);
+  int slice = target_latency*weight/(total_weight + weight);
+  return slice > min_granularity ? slice : min_granularity;
+}
+
+void CFSQueue::Ran(PCB* p, int duration) {
+  p->vruntime += (int64_t)duration*1000*1024/NiceWeight(p->nice);
+}
+
+void CFSQueue::Save(CheckpointWriter& out) const {
+  out.Put<uint64_t>(count);
+  out.Put(min_vruntime);
+  out.Put(total_weight);
+  // keys are the vruntime and pid of the PCBs
+  out.Put<uint64_t>(tree.size());
+  for (const auto& node: tree) out.Put(node.second);
+}
+
+void CFSQueue::Restore(CheckpointReader& in) {
+  count = in.Get<uint64_t>();
+  min_vruntime = in.Get<int64_t>();
+  total_weight = in.Get<int64_t>();
+  uint64_t size = in.Get<uint64_t>();
+  for (uint64_t i = 0; i < size; i++) {
+    // in key order, so every node goes at the end
+    PCB* p = pool->ReadPCB(in);
+    if (p == nullptr) {
+      in.Fail();
+      return;
+    }
+    tree.emplace_hint(tree.end(), std::make_pair(p->vruntime, p->pid), p->handle);
+  }
+}
+
+void CFSQueue::VisitReady(RequestVisitor& visitor) const {
+  for (const auto& node: tree) visitor.Visit(pool->get(node.second));
+}
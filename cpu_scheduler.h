@@ -0,0 +1,175 @@
+// CPU scheduling: the run queue of each CPU decides which ready process runs
+// next, which one an idle CPU may steal and how long a time slice is.
+#ifndef CPU_SCHEDULER_H
+#define CPU_SCHEDULER_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "checkpoint_io.h"
+#include "pcb_pool.h"
+
+// CPU scheduling policies
+enum class CPUPolicy {round_robin, mlfq, cfs};
+
+// Name of policy as used in options (rr/mlfq/cfs)
+const char* CPUPolicyName(CPUPolicy policy);
+// Store the policy called name in policy. Returns false if there is none.
+bool ParseCPUPolicy(const std::string& name, CPUPolicy* policy);
+
+// Most priority levels of a multilevel feedback queue
+const int kMaxLevels = 16;
+
+// Nice values of processes, lower gets a larger CPU share
+const int kMinNice = -20, kMaxNice = 19;
+// Load weight of nice (1024 for 0), each step is worth about 10% CPU time
+int NiceWeight(int nice);
+
+// Configuration of the run queues of every CPU
+struct SchedulerParams {
+  CPUPolicy policy;
+  int levels;          // mlfq: priority levels, 1 to kMaxLevels
+  int boost_interval;  // mlfq: ms between moving everything to the top
+                       // level, never if 0
+  int target_latency;  // cfs: ms in which every runnable process runs once
+  int min_granularity; // cfs: shortest time slice in ms
+};
+
+// Interface for run queues as well as factory method to create them
+// Add(p)          - queue p, which is ready to run
+// Next()          - pop the process to run next (nullptr if empty)
+// Steal()         - pop the process another CPU should take (nullptr if
+//                   empty)
+// Remove(p)       - remove p, which must be queued
+// Quantum(p)      - time slice of p in ms
+// Ran(p, duration) - p, not queued, ran for duration ms
+// Expired(p)      - p, not queued, used up its time slice
+// Woken(p)        - p, not queued, completed I/O
+// Boost()         - move all queued processes to the top level
+// Save(out)       - write the queue, its processes are saved by the PCBPool
+// Restore(in)     - restore what Save wrote into an empty queue of the same
+//                   policy and levels
+// VisitReady(visitor) - visit queued processes in the order they would run
+// ForEachReady(f) - call f(PCB*) for queued processes in the order they
+//                   would run
+class RunQueue {
+  public:
+    // Run queue of params.policy with base time slice time_slice ms
+    static RunQueue* make_run_queue(const SchedulerParams& params,
+                                    int time_slice, const PCBPool* pool);
+    virtual ~RunQueue();
+
+    size_t size() const {return count;}
+    bool empty() const {return count == 0;}
+    // Priority levels, and processes queued in level (0 is the highest)
+    virtual int levels() const {return 1;}
+    virtual size_t level_size(int level) const {return count;}
+
+    virtual void Add(PCB* p) = 0;
+    virtual PCB* Next() = 0;
+    virtual PCB* Steal() = 0;
+    virtual void Remove(PCB* p) = 0;
+    virtual int Quantum(const PCB* p) const = 0;
+    virtual void Ran(PCB* p, int duration) {}
+    virtual void Expired(PCB* p) {}
+    virtual void Woken(PCB* p) {}
+    virtual void Boost() {}
+    virtual void Save(CheckpointWriter& out) const = 0;
+    virtual void Restore(CheckpointReader& in) = 0;
+    virtual void VisitReady(RequestVisitor& visitor) const = 0;
+
+    template<typename F>
+    void ForEachReady(F f) const {
+      FunctionVisitor<F> visitor{f};
+      VisitReady(visitor);
+    }
+
+  protected:
+    size_t count = 0;
+};
+
+// Round robin: one FIFO queue, every process gets the same time slice
+class RoundRobinQueue: public RunQueue {
+  public:
+    RoundRobinQueue(int time_slice, const PCBPool* pool) :
+        time_slice{time_slice}, queue{pool} {}
+    void Add(PCB* p) {queue.push_back(p); count++;}
+    PCB* Next();
+    PCB* Steal();
+    void Remove(PCB* p) {queue.erase(p); count--;}
+    int Quantum(const PCB* p) const {return time_slice;}
+    void Save(CheckpointWriter& out) const;
+    void Restore(CheckpointReader& in);
+    void VisitReady(RequestVisitor& visitor) const;
+
+  private:
+    int time_slice;
+    PCBQueue queue;
+};
+
+// Multilevel feedback queue: a FIFO queue per priority level (PCB::priority)
+// whose time slice doubles with each level down. Processes that use their
+// whole slice drop a level, processes completing I/O rise one. A bitmap of
+// the non-empty levels finds the highest in O(1).
+class MLFQueue: public RunQueue {
+  public:
+    MLFQueue(int levels, int time_slice, const PCBPool* pool);
+    int levels() const {return queues.size();}
+    size_t level_size(int level) const {return queues[level].size();}
+
+    void Add(PCB* p);
+    PCB* Next();
+    PCB* Steal();
+    void Remove(PCB* p);
+    int Quantum(const PCB* p) const {return time_slice << p->priority;}
+    void Expired(PCB* p);
+    void Woken(PCB* p);
+    void Boost();
+    void Save(CheckpointWriter& out) const;
+    void Restore(CheckpointReader& in);
+    void VisitReady(RequestVisitor& visitor) const;
+
+  private:
+    int time_slice;               // of the top level
+    std::vector<PCBQueue> queues;  // indexed by level
+    uint32_t non_empty = 0;       // bit l set if queues[l] is not empty
+
+    PCB* Pop(int level, bool front);
+};
+
+// Completely fair: processes ordered by virtual runtime, their CPU time
+// scaled by 1024/NiceWeight(nice), and the one that has run least goes
+// next. Time slices split target_latency among the runnable processes by
+// weight, but are at least min_granularity.
+class CFSQueue: public RunQueue {
+  public:
+    CFSQueue(int target_latency, int min_granularity, const PCBPool* pool) :
+        pool{pool}, target_latency{target_latency},
+        min_granularity{min_granularity} {}
+
+    void Add(PCB* p);
+    PCB* Next();
+    PCB* Steal();
+    void Remove(PCB* p);
+    int Quantum(const PCB* p) const;
+    void Ran(PCB* p, int duration);
+    void Save(CheckpointWriter& out) const;
+    void Restore(CheckpointReader& in);
+    void VisitReady(RequestVisitor& visitor) const;
+
+  private:
+    const PCBPool* pool;
+    int target_latency, min_granularity;
+    std::map<std::pair<int64_t, size_t>, PCBHandle> tree;  // (vruntime, pid)
+    // never decreases, processes waking up or arriving start near it so
+    // they can not claim the CPU for the time they did not run
+    int64_t min_vruntime = 0;
+    int64_t total_weight = 0;  // of the queued processes
+
+    PCB* Pop(PCBHandle handle);
+};
+
+#endif
@@ -2,171 +2,168 @@
 #include <exception>
 
 Device::~Device() {}
-Device* Device::make_device(char device_type) {
-  if (device_type == 'p') return new Printer;
-  else if (device_type == 'c') return new CD_RW;
-  else if (device_type == 'd') return new Disk;
+Device* Device::make_device(char device_type, const PCBPool* pool) {
+  if (device_type == 'p') return new Printer{pool};
+  else if (device_type == 'c') return new CD_RW{pool};
+  else if (device_type == 'd') return new Disk{pool};
   else throw std::invalid_argument("device_type");
 }
 
+PCB* Device::StartService() {
+  if (in_service == nullptr) in_service = Select();
+  return in_service;
+}
+PCB* Device::PopFinished() {
+  PCB* finished = StartService();
+  in_service = nullptr;
+  return finished;
+}
+void Device::RemoveRequest(PCB* request) {
+  if (request == in_service) in_service = nullptr;
+  else Remove(request);
+}
+void Device::VisitRequests(RequestVisitor& visitor) const {
+  if (in_service != nullptr) visitor.Visit(in_service);
+  VisitQueued(visitor);
+}
+void Device::Save(CheckpointWriter& out) const {
+  out.Put(in_service ? in_service->handle : kNullHandle);
+  SaveQueue(out);
+}
+void Device::Restore(CheckpointReader& in, const PCBPool* pool) {
+  in_service = pool->ReadPCB(in);
+  RestoreQueue(in);
+}
 
-Printer::~Printer() {
-  for (auto& p: req_queue) {
-    delete p;
-  }
+int64_t ServiceTime(const DeviceTimings& timings, char device_type,
+                    const PCB* request, int seek) {
+  double bytes = (request->op == 'w') ? request->file_size : timings.read_size;
+  double us = 0;
+  if (device_type == 'd') {
+    // seeks accelerate and then coast, so their time grows with the square
+    // root of the distance
+    if (seek > 0) us += timings.seek_settle + timings.seek_per_cylinder*std::sqrt(seek);
+    if (timings.rpm > 0) us += 60e6/timings.rpm/2;
+    if (timings.disk_rate > 0) us += bytes*1000/timings.disk_rate;
+  }
+  else if (device_type == 'p') {
+    us += timings.printer_setup;
+    if (timings.printer_rate > 0) us += bytes*1000/timings.printer_rate;
+  }
+  else if (device_type == 'c') {
+    int rate = (request->op == 'w') ? timings.cd_write_rate : timings.cd_read_rate;
+    us += timings.cd_access;
+    if (rate > 0) us += bytes*1000/rate;
+  }
+  return std::llround(us);
 }
+
+
 void Printer::AddRequest(PCB* request) {
   req_queue.push_back(request);
 }
-PCB* Printer::PopFinished() {
+PCB* Printer::Select() {
   if (req_queue.empty())
     return nullptr;
-  PCB* finished = req_queue.front();
+  PCB* next = req_queue.front();
   req_queue.pop_front();
-  return finished;
+  return next;
 }
-void Printer::RemoveRequest(int pid) {
-  for (auto itr = req_queue.begin(); itr != req_queue.end();) {
-    if ((*itr)->pid == pid) {
-      itr = req_queue.erase(itr);
-    }
-    else ++itr;
-  }
+void Printer::Remove(PCB* request) {
+  req_queue.erase(request);
+}
+void Printer::VisitQueued(RequestVisitor& visitor) const {
+  for (const auto& p: req_queue) visitor.Visit(p);
+}
+void Printer::SaveQueue(CheckpointWriter& out) const {
+  req_queue.Save(out);
+}
+void Printer::RestoreQueue(CheckpointReader& in) {
+  req_queue.Restore(in);
 }
-const std::deque<PCB*> Printer::AllRequests() const {return req_queue;}
 
 
-CD_RW::~CD_RW() {
-  for (auto& p: req_queue) {
-    delete p;
-  }
-}
 void CD_RW::AddRequest(PCB* request) {
   req_queue.push_back(request);
 }
-PCB* CD_RW::PopFinished() {
+PCB* CD_RW::Select() {
   if (req_queue.empty())
     return nullptr;
-  PCB* finished = req_queue.front();
+  PCB* next = req_queue.front();
   req_queue.pop_front();
-  return finished;
+  return next;
 }
-void CD_RW::RemoveRequest(int pid) {
-  for (auto itr = req_queue.begin(); itr != req_queue.end();) {
-    if ((*itr)->pid == pid) {
-      itr = req_queue.erase(itr);
-    }
-    else ++itr;
-  }
+void CD_RW::Remove(PCB* request) {
+  req_queue.erase(request);
+}
+void CD_RW::VisitQueued(RequestVisitor& visitor) const {
+  for (const auto& p: req_queue) visitor.Visit(p);
+}
+void CD_RW::SaveQueue(CheckpointWriter& out) const {
+  req_queue.Save(out);
+}
+void CD_RW::RestoreQueue(CheckpointReader& in) {
+  req_queue.Restore(in);
 }
-const std::deque<PCB*> CD_RW::AllRequests() const {return req_queue;}
 
 
 Disk::~Disk() {
-  for (int i = 0; i < queue_1.size(); i++) {
-    PCB* p = queue_1.top();
-    queue_1.pop(head_pos);
-    delete p;
-  }
-  for (int i = 0; i < queue_2.size(); i++) {
-    PCB* p = queue_2.top();
-    queue_2.pop(head_pos);
-    delete p;
-  }
+  delete scheduler;
+}
+void Disk::set_policy(DiskPolicy new_policy) {
+  DiskScheduler* new_scheduler = DiskScheduler::make_scheduler(new_policy, pool);
+  std::vector<PCB*> queued;
+  // the request in service stays out of the scheduler
+  auto add = [&queued](PCB* p) {queued.push_back(p);};
+  FunctionVisitor<decltype(add)> visitor{add};
+  VisitQueued(visitor);
+  for (const auto& p: queued) {
+    scheduler->Remove(p);
+    new_scheduler->Add(p);
+  }
+  delete scheduler;
+  scheduler = new_scheduler;
+  policy = new_policy;
 }
 void Disk::AddRequest(PCB* request) {
-  // add to first queue, then close it
-  if (!running) {
-    queue_1.push(head_pos, request);
-    running = true;
-    return;
-  }
-  // if the first queue is being serviced, defer all requests to second queue
-  if (run_queue == 1) {
-    queue_2.push(head_pos, request);
-  }
-  // if the second queue is being serviced, defer all requests to first queue
-  else if (run_queue == 2) {
-    queue_1.push(head_pos, request);
-  }
+  request->disk_arrival = disk_stats.serviced;
+  scheduler->Add(request);
 }
-PCB* Disk::PopFinished() {
-  PCB* finished = nullptr;
-  // pop from first queue if servicing it
-  if (run_queue == 1) {
-    if (!queue_1.empty()) {
-      finished = queue_1.top();
-      queue_1.pop(head_pos);
-      if (queue_1.empty()) {  // if after pop queue is empty, change service queue
-        run_queue = 2;
-      }
-    }
-  }
-  else if (run_queue == 2) {
-    if (!queue_2.empty()) {
-      finished = queue_2.top();
-      queue_2.pop(head_pos);
-      if (queue_2.empty()) {
-        run_queue = 1;
-      }
-    }
-  }
-  if (finished != nullptr) {
-    head_pos = finished->cylinder_num; // move seek head to new cylinder pos
-  }
+PCB* Disk::Select() {
+  seek = 0;
+  PCB* finished = scheduler->Next(head_pos, num_of_cylinders, seek);
+  if (finished == nullptr) return nullptr;
+  size_t wait = disk_stats.serviced - finished->disk_arrival;
+  disk_stats.seek_distance += seek;
+  disk_stats.serviced++;
+  disk_stats.total_wait += wait;
+  disk_stats.max_wait = std::max(disk_stats.max_wait, wait);
+  head_pos = finished->cylinder_num; // move seek head to new cylinder pos
   return finished;
 }
-void Disk::RemoveRequest(int pid) {
-  bool deleted = false;
-
-  // iterate through queue_1 and look for process with pid == pid
-  for (auto itr = queue_1.begin(); itr != queue_1.end();) {
-    if ((*itr)->pid == pid) {
-      itr = queue_1.erase(itr);
-      deleted = true;
-      break;
-    }
-    else ++itr;
-  }
-  if (deleted && queue_1.empty() && run_queue == 1)
-    run_queue = 2;
-  bool deleted_2 = false;
-  // if not found in queue_1, check queue_2
-  if (!deleted) {
-    for (auto itr = queue_2.begin(); itr != queue_2.end();) {
-      if ((*itr)->pid == pid) {
-        itr = queue_2.erase(itr);
-        deleted_2 = true;
-        break;
-      }
-      else ++itr;
-    }
-    if (deleted_2 && queue_2.empty() && run_queue == 2)
-      run_queue = 1;
-  }
+void Disk::Remove(PCB* request) {
+  scheduler->Remove(request);
 }
-const std::deque<PCB*> Disk::AllRequests() const {
-  std::deque<PCB*> req_queue;
-  // if servicing queue 1 put queue 1 requests first
-  if (run_queue == 1) {
-    std::vector<PCB*> vec_1 = queue_1.ToVector(head_pos);
-    std::vector<PCB*> vec_2 = queue_2.ToVector(head_pos);
-    for (const auto& v: vec_1) {
-      req_queue.push_back(v);
-    }
-    for (const auto& v: vec_2) {
-      req_queue.push_back(v);
-    }
-  }
-  else if (run_queue == 2) {
-    std::vector<PCB*> vec_1 = queue_1.ToVector(head_pos);
-    std::vector<PCB*> vec_2 = queue_2.ToVector(head_pos);
-    for (const auto& v: vec_2) {
-      req_queue.push_back(v);
-    }
-    for (const auto& v: vec_1) {
-      req_queue.push_back(v);
-    }
+void Disk::VisitQueued(RequestVisitor& visitor) const {
+  scheduler->VisitRequests(head_pos, visitor);
+}
+void Disk::SaveQueue(CheckpointWriter& out) const {
+  out.Put(policy);
+  out.Put<int32_t>(head_pos);
+  out.Put<int32_t>(seek);
+  out.Put(disk_stats);
+  scheduler->Save(out);
+}
+void Disk::RestoreQueue(CheckpointReader& in) {
+  // the policy may have been changed since Sysgen
+  DiskPolicy saved = in.Get<DiskPolicy>();
+  if (saved < DiskPolicy::fcfs || saved > DiskPolicy::fscan) {
+    in.Fail();
+    return;
   }
-  return req_queue;
+  if (saved != policy) set_policy(saved);
+  head_pos = in.Get<int32_t>();
+  seek = in.Get<int32_t>();
+  disk_stats = in.Get<DiskStats>();
+  scheduler->Restore(in);
 }
@@ -4,126 +4,168 @@
 #include <iostream>
 #include <deque>
 #include <cmath>
+#include <cstdint>
 #include <cstdlib>
 #include <vector>
 #include <algorithm>
+#include <iterator>
+#include <map>
 #include <string>
+#include <utility>
 
 #include "pcb.h"
+#include "disk_scheduler.h"
+
+// Physical service times of the devices. Disks seek, wait for the sector to
+// rotate under the head and transfer; printers print at a fixed rate; CD/RWs
+// reach the track and then read, or write more slowly. All zero
+// (DeviceTimings{}) leaves service times to whoever drives the devices.
+struct DeviceTimings {
+  bool enabled;
+  int read_size;         // bytes read per request, reads do not give a size
+  // disks
+  int seek_settle;       // us of every seek of at least one cylinder
+  int seek_per_cylinder; // us per square root of the cylinders travelled
+  int rpm;               // a request waits half a rotation on average
+  int disk_rate;         // bytes per ms
+  // printers
+  int printer_setup;     // us per request
+  int printer_rate;      // bytes per ms
+  // cd/rws
+  int cd_access;         // us per request
+  int cd_read_rate, cd_write_rate;  // bytes per ms
+};
+
+// Time in us device_type (c/d/p) takes to service request, whose disk head
+// travelled seek cylinders to reach it
+int64_t ServiceTime(const DeviceTimings& timings, char device_type,
+                    const PCB* request, int seek);
 
 // Interface for devices as well as factory method to create specific devices
 // AddRequest(PCB* request) - add a request to the device queue
-// PopFinished()            - pop a request off the device queue
-// RemoveRequest(int pid)   - find and remove request with pid == pid if exists
-// AllRequests()            - return all requests as a deque
+// StartService()           - take the request to service next off the queue,
+//                            PopFinished returns it (nullptr if empty)
+// PopFinished()            - pop the request in service, or else the one
+//                            that would be next, off the device queue
+// RemoveRequest(PCB* request) - remove request, which must be in the queue or
+//                               in service
+// VisitRequests(visitor)   - visit all requests in service order
+// ForEachRequest(f)        - call f(PCB*) for all requests in service order
+// Save(out)                - write the requests and the state of the device
+// Restore(in, pool)        - restore what Save wrote into an empty device of
+//                            the same type, once the PCBs are in pool
+// Derived devices implement the queue below the request in service:
+// Select()                 - pop the request to service next (nullptr if none)
+// Remove(PCB* request)     - remove request, which must be queued
+// VisitQueued(visitor)     - visit queued requests in service order
+// SaveQueue(out)/RestoreQueue(in) - save/restore the queue
 struct Device {
-  static Device* make_device(char device_type);
+  static Device* make_device(char device_type, const PCBPool* pool);
   virtual ~Device() = 0;
   virtual void AddRequest(PCB* request) = 0;
-  virtual PCB* PopFinished() = 0;
-  virtual void RemoveRequest(int pid) = 0;
-  virtual const std::deque<PCB*> AllRequests() const = 0;
+  PCB* StartService();
+  PCB* PopFinished();
+  void RemoveRequest(PCB* request);
+  void VisitRequests(RequestVisitor& visitor) const;
+  // Cylinders the disk head travelled to the request in service
+  virtual int service_seek() const {return 0;}
+  void Save(CheckpointWriter& out) const;
+  void Restore(CheckpointReader& in, const PCBPool* pool);
+
+  template<typename F>
+  void ForEachRequest(F f) const {
+    FunctionVisitor<F> visitor{f};
+    VisitRequests(visitor);
+  }
+
+  protected:
+    virtual PCB* Select() = 0;
+    virtual void Remove(PCB* request) = 0;
+    virtual void VisitQueued(RequestVisitor& visitor) const = 0;
+    virtual void SaveQueue(CheckpointWriter& out) const = 0;
+    virtual void RestoreQueue(CheckpointReader& in) = 0;
+
+  private:
+    PCB* in_service = nullptr;
 };
 
 // Derived Printer class
 struct Printer: Device {
-  ~Printer();
+  explicit Printer(const PCBPool* pool) : req_queue{pool} {}
   void AddRequest(PCB* request);
-  PCB* PopFinished();
-  const std::deque<PCB*> AllRequests() const;
-
-  void RemoveRequest(int pid);
-  std::deque<PCB*> req_queue;
+  PCBQueue req_queue;
+
+  protected:
+    PCB* Select();
+    void Remove(PCB* request);
+    void VisitQueued(RequestVisitor& visitor) const;
+    void SaveQueue(CheckpointWriter& out) const;
+    void RestoreQueue(CheckpointReader& in);
 };
 
 // Derived CD/RW class
 struct CD_RW: Device {
-  ~CD_RW();
+  explicit CD_RW(const PCBPool* pool) : req_queue{pool} {}
   void AddRequest(PCB* request);
-  PCB* PopFinished();
-  const std::deque<PCB*> AllRequests() const;
-
-  void RemoveRequest(int pid);
-  std::deque<PCB*> req_queue;
+  PCBQueue req_queue;
+
+  protected:
+    PCB* Select();
+    void Remove(PCB* request);
+    void VisitQueued(RequestVisitor& visitor) const;
+    void SaveQueue(CheckpointWriter& out) const;
+    void RestoreQueue(CheckpointReader& in);
 };
 
 
+// Scheduling statistics of a disk. Waits are counted in requests serviced
+// while a request was queued.
+struct DiskStats {
+  long long seek_distance = 0;  // cylinders travelled by the head
+  size_t serviced = 0;
+  long long total_wait = 0;
+  size_t max_wait = 0;
+
+  double mean_wait() const {return serviced == 0 ? 0 : (double)total_wait/serviced;}
+};
+
 // Derived Disk class
-// Uses FSCAN scheduling algorithm for device queue
+// Requests are serviced in the order of a DiskScheduler policy, FSCAN unless
+// set otherwise
 struct Disk: Device {
   private:
-    bool running = false;
-    int run_queue = 1;
     int head_pos = 0;
-
-    // Comparison functor for PCB* type in priority queue
-    // Priority: minimum seek time from current head position to PCB cylinder
-    struct LessSeekTime {
-      LessSeekTime(int h_pos): _head_pos{h_pos} {}
-      int _head_pos;
-      bool operator()(const PCB* proc1, const PCB* proc2) const {
-        return abs(_head_pos-proc2->cylinder_num) < abs(_head_pos-proc1->cylinder_num);
-      }
-    };
-
-    // Helper priority queue class for PCBs
-    class PCBPriorityQueue {
-      private:
-        std::vector<PCB*> elements;
-
-      public:
-        typedef std::vector<PCB*>::iterator iterator;
-        typedef std::vector<PCB*>::const_iterator const_iterator;
-
-        std::vector<PCB*> ToVector(int h_pos) const {
-          std::vector<PCB*> elems = elements;
-          std::vector<PCB*> new_vec;
-          while (!elems.empty()) {
-            new_vec.push_back(elems.front());
-            std::pop_heap(elems.begin(), elems.end(), LessSeekTime(h_pos));
-            elems.pop_back();
-          }
-          return new_vec;
-        }
-        void push(int h_pos, PCB* e) {
-          elements.push_back(e);
-          std::push_heap(elements.begin(), elements.end(), LessSeekTime(h_pos));
-        }
-        void pop(int h_pos) {
-          if (!elements.empty()) {
-            std::pop_heap(elements.begin(), elements.end(), LessSeekTime(h_pos));
-            elements.pop_back();
-          }
-        }
-
-        iterator erase(iterator pos) {return elements.erase(pos);}
-
-        PCB* top() {
-          if (!elements.empty()) {
-            return elements.front();
-          }
-          return nullptr;
-        }
-        int size() {return elements.size();}
-        bool empty() {return elements.empty();}
-
-        iterator begin() {return elements.begin();}
-        const_iterator begin() const {return elements.begin();}
-        iterator end()   {return elements.end();}
-        const_iterator end() const {return elements.end();}
-    };
+    const PCBPool* pool;
+    DiskPolicy policy;
+    DiskScheduler* scheduler;
+    DiskStats disk_stats;
+    int seek = 0;  // of the last request selected
 
   public:
     int num_of_cylinders;
-    PCBPriorityQueue queue_1, queue_2;  // run queue and waiting queue
 
-    Disk(): num_of_cylinders{0} {}
+    explicit Disk(const PCBPool* pool) :
+        pool{pool}, policy{DiskPolicy::fscan},
+        scheduler{DiskScheduler::make_scheduler(policy, pool)},
+        num_of_cylinders{0} {}
     ~Disk();
+    Disk(const Disk&) = delete;
+    Disk& operator=(const Disk&) = delete;
+
+    // Change scheduling policy, queued requests move to the new policy
+    void set_policy(DiskPolicy new_policy);
+    DiskPolicy get_policy() const {return policy;}
+    const DiskStats& stats() const {return disk_stats;}
+    int service_seek() const {return seek;}
 
-    void RemoveRequest(int pid);
     void AddRequest(PCB* request);
-    PCB* PopFinished();
-    const std::deque<PCB*> AllRequests() const;
+
+  protected:
+    PCB* Select();
+    void Remove(PCB* request);
+    void VisitQueued(RequestVisitor& visitor) const;
+    void SaveQueue(CheckpointWriter& out) const;
+    void RestoreQueue(CheckpointReader& in);
 };
 
 #endif
@@ -0,0 +1,222 @@
+#include "disk_scheduler.h"
+#include <cstdlib>
+#include <stdexcept>
+
+namespace {
+const char* kPolicyNames[] = {"fcfs", "sstf", "scan", "c-scan", "look",
+                              "c-look", "fscan"};
+
+// Visit requests of queue in [first, last) in ascending or descending
+// cylinder order
+void VisitRange(const CylinderQueue& queue,
+                CylinderQueue::const_iterator first,
+                CylinderQueue::const_iterator last, bool ascending,
+                RequestVisitor& visitor) {
+  if (ascending) {
+    for (; first != last; ++first) visitor.Visit(queue.get(first));
+  }
+  else {
+    while (last != first) visitor.Visit(queue.get(--last));
+  }
+}
+}
+
+const char* PolicyName(DiskPolicy policy) {
+  return kPolicyNames[static_cast<int>(policy)];
+}
+bool ParsePolicy(const std::string& name, DiskPolicy* policy) {
+  for (int i = 0; i < 7; i++) {
+    if (name == kPolicyNames[i]) {
+      *policy = static_cast<DiskPolicy>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+DiskScheduler::~DiskScheduler() {}
+DiskScheduler* DiskScheduler::make_scheduler(DiskPolicy policy,
+                                             const PCBPool* pool) {
+  switch (policy) {
+    case DiskPolicy::fcfs: return new FCFSScheduler{pool};
+    case DiskPolicy::sstf: return new SSTFScheduler{pool};
+    case DiskPolicy::scan: return new ElevatorScheduler{pool, true};
+    case DiskPolicy::look: return new ElevatorScheduler{pool, false};
+    case DiskPolicy::c_scan: return new CircularScheduler{pool, true};
+    case DiskPolicy::c_look: return new CircularScheduler{pool, false};
+    case DiskPolicy::fscan: return new FSCANScheduler{pool};
+  }
+  throw std::invalid_argument("policy");
+}
+
+
+void FCFSScheduler::Add(PCB* request) {
+  req_queue.push_back(request);
+}
+PCB* FCFSScheduler::Next(int head_pos, int num_of_cylinders, int& seek) {
+  PCB* next = req_queue.front();
+  if (next == nullptr) return nullptr;
+  req_queue.pop_front();
+  seek = abs(next->cylinder_num - head_pos);
+  return next;
+}
+void FCFSScheduler::Remove(PCB* request) {
+  req_queue.erase(request);
+}
+void FCFSScheduler::VisitRequests(int head_pos,
+                                  RequestVisitor& visitor) const {
+  for (const auto& p: req_queue) visitor.Visit(p);
+}
+
+
+void SSTFScheduler::Add(PCB* request) {
+  queue.insert(request);
+}
+PCB* SSTFScheduler::Next(int head_pos, int num_of_cylinders, int& seek) {
+  PCB* next = queue.nearest(head_pos);
+  if (next == nullptr) return nullptr;
+  queue.erase(next);
+  seek = abs(next->cylinder_num - head_pos);
+  return next;
+}
+void SSTFScheduler::Remove(PCB* request) {
+  queue.erase(request);
+}
+void SSTFScheduler::VisitRequests(int head_pos,
+                                  RequestVisitor& visitor) const {
+  queue.ForEachNearestFirst(head_pos, [&visitor](PCB* p) {visitor.Visit(p);});
+}
+
+
+void ElevatorScheduler::Save(CheckpointWriter& out) const {
+  out.Put<uint8_t>(up);
+  queue.Save(out);
+}
+void ElevatorScheduler::Restore(CheckpointReader& in) {
+  up = in.Get<uint8_t>();
+  queue.Restore(in);
+}
+void ElevatorScheduler::Add(PCB* request) {
+  queue.insert(request);
+}
+PCB* ElevatorScheduler::Next(int head_pos, int num_of_cylinders, int& seek) {
+  if (queue.empty()) return nullptr;
+  PCB* next = up ? queue.at_or_above(head_pos) : queue.at_or_below(head_pos);
+  if (next != nullptr) {
+    seek = abs(next->cylinder_num - head_pos);
+  }
+  else {
+    // nothing left in the direction of travel, reverse
+    int turn = up ? num_of_cylinders-1 : 0;
+    up = !up;
+    next = up ? queue.lowest() : queue.highest();
+    if (to_end) seek = abs(turn - head_pos) + abs(turn - next->cylinder_num);
+    else seek = abs(next->cylinder_num - head_pos);
+  }
+  queue.erase(next);
+  return next;
+}
+void ElevatorScheduler::Remove(PCB* request) {
+  queue.erase(request);
+}
+void ElevatorScheduler::VisitRequests(int head_pos,
+                                      RequestVisitor& visitor) const {
+  // requests ahead in the direction of travel, then the rest on the way back
+  auto split = queue.lower_bound(up ? head_pos : head_pos+1);
+  VisitRange(queue, up ? split : queue.begin(), up ? queue.end() : split, up,
+             visitor);
+  VisitRange(queue, up ? queue.begin() : split, up ? split : queue.end(), !up,
+             visitor);
+}
+
+
+void CircularScheduler::Add(PCB* request) {
+  queue.insert(request);
+}
+PCB* CircularScheduler::Next(int head_pos, int num_of_cylinders, int& seek) {
+  if (queue.empty()) return nullptr;
+  PCB* next = queue.at_or_above(head_pos);
+  if (next != nullptr) {
+    seek = next->cylinder_num - head_pos;
+  }
+  else {
+    // wrap around to the lowest request
+    next = queue.lowest();
+    if (to_end) {
+      seek = (num_of_cylinders-1 - head_pos) + (num_of_cylinders-1) +
+             next->cylinder_num;
+    }
+    else seek = head_pos - next->cylinder_num;
+  }
+  queue.erase(next);
+  return next;
+}
+void CircularScheduler::Remove(PCB* request) {
+  queue.erase(request);
+}
+void CircularScheduler::VisitRequests(int head_pos,
+                                      RequestVisitor& visitor) const {
+  auto split = queue.lower_bound(head_pos);
+  VisitRange(queue, split, queue.end(), true, visitor);
+  VisitRange(queue, queue.begin(), split, true, visitor);
+}
+
+
+void FSCANScheduler::Save(CheckpointWriter& out) const {
+  out.Put<int32_t>(run_queue);
+  queue_1.Save(out);
+  queue_2.Save(out);
+}
+void FSCANScheduler::Restore(CheckpointReader& in) {
+  run_queue = in.Get<int32_t>();
+  if (run_queue != 1 && run_queue != 2) in.Fail();
+  queue_1.Restore(in);
+  queue_2.Restore(in);
+}
+void FSCANScheduler::Add(PCB* request) {
+  CylinderQueue& running = (run_queue == 1) ? queue_1 : queue_2;
+  CylinderQueue& waiting = (run_queue == 1) ? queue_2 : queue_1;
+  // an idle disk services the request right away, otherwise defer all
+  // requests to the waiting queue until the running queue is empty
+  if (running.empty() && waiting.empty()) {
+    running.insert(request);
+  }
+  else {
+    waiting.insert(request);
+  }
+}
+PCB* FSCANScheduler::Next(int head_pos, int num_of_cylinders, int& seek) {
+  CylinderQueue* running = (run_queue == 1) ? &queue_1 : &queue_2;
+  if (running->empty()) {  // change service queue
+    run_queue = 3 - run_queue;
+    running = (run_queue == 1) ? &queue_1 : &queue_2;
+  }
+  PCB* next = running->nearest(head_pos);
+  if (next == nullptr) return nullptr;
+  running->erase(next);
+  if (running->empty()) {  // if after pop queue is empty, change service queue
+    run_queue = 3 - run_queue;
+  }
+  seek = abs(next->cylinder_num - head_pos);
+  return next;
+}
+void FSCANScheduler::Remove(PCB* request) {
+  if (queue_1.erase(request)) {
+    if (queue_1.empty() && run_queue == 1)
+      run_queue = 2;
+  }
+  else if (queue_2.erase(request)) {
+    if (queue_2.empty() && run_queue == 2)
+      run_queue = 1;
+  }
+}
+void FSCANScheduler::VisitRequests(int head_pos,
+                                   RequestVisitor& visitor) const {
+  auto add = [&visitor](PCB* p) {visitor.Visit(p);};
+  // running queue requests first, the waiting queue is serviced from where
+  // the running queue leaves the head
+  const CylinderQueue& running = (run_queue == 1) ? queue_1 : queue_2;
+  const CylinderQueue& waiting = (run_queue == 1) ? queue_2 : queue_1;
+  int last_pos = running.ForEachNearestFirst(head_pos, add);
+  waiting.ForEachNearestFirst(last_pos, add);
+}
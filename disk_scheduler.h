@@ -0,0 +1,234 @@
+#ifndef DISK_SCHEDULER_H
+#define DISK_SCHEDULER_H
+
+#include <iterator>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "checkpoint_io.h"
+#include "pcb_pool.h"
+
+// Requests of a disk ordered by cylinder (ties by pid), so the request
+// nearest to the head is found and any request is removed in O(log n)
+class CylinderQueue {
+  public:
+    typedef std::map<std::pair<int, size_t>, PCBHandle>::const_iterator const_iterator;
+
+    explicit CylinderQueue(const PCBPool* pool) : pool{pool} {}
+
+    bool empty() const {return requests.empty();}
+    size_t size() const {return requests.size();}
+    const_iterator begin() const {return requests.begin();}
+    const_iterator end() const {return requests.end();}
+    PCB* get(const_iterator itr) const {return pool->get(itr->second);}
+    // First request at or above cylinder
+    const_iterator lower_bound(int cylinder) const {
+      return requests.lower_bound(std::make_pair(cylinder, (size_t)0));
+    }
+
+    void insert(PCB* request) {
+      requests.emplace(std::make_pair(request->cylinder_num, request->pid),
+                       request->handle);
+    }
+    // Handles in cylinder order, the keys come from the PCBs
+    void Save(CheckpointWriter& out) const {
+      out.Put<uint64_t>(requests.size());
+      for (const auto& request: requests) out.Put(request.second);
+    }
+    void Restore(CheckpointReader& in) {
+      uint64_t size = in.Get<uint64_t>();
+      for (uint64_t i = 0; i < size; i++) {
+        PCB* request = pool->ReadPCB(in);
+        if (request == nullptr) {
+          in.Fail();
+          return;
+        }
+        requests.emplace_hint(requests.end(),
+                              std::make_pair(request->cylinder_num, request->pid),
+                              request->handle);
+      }
+    }
+    // Remove request, returns false if it is not in the queue
+    bool erase(const PCB* request) {
+      return requests.erase(std::make_pair(request->cylinder_num,
+                                           request->pid)) > 0;
+    }
+
+    // Lowest/highest cylinder request (nullptr if empty)
+    PCB* lowest() const {return empty() ? nullptr : get(requests.begin());}
+    PCB* highest() const {return empty() ? nullptr : get(std::prev(requests.end()));}
+
+    // First request at or above/last request at or below cylinder head_pos
+    // (nullptr if none)
+    PCB* at_or_above(int head_pos) const {
+      const_iterator above = lower_bound(head_pos);
+      return (above == requests.end()) ? nullptr : get(above);
+    }
+    PCB* at_or_below(int head_pos) const {
+      const_iterator above = lower_bound(head_pos+1);
+      return (above == requests.begin()) ? nullptr : get(std::prev(above));
+    }
+
+    // Request with minimum seek time from head_pos (nullptr if empty)
+    PCB* nearest(int head_pos) const {
+      const_iterator above = lower_bound(head_pos);
+      if (above == requests.begin()) {
+        return (above == requests.end()) ? nullptr : get(above);
+      }
+      const_iterator below = std::prev(above);
+      if (above == requests.end() ||
+          head_pos - below->first.first < above->first.first - head_pos) {
+        return get(below);
+      }
+      return get(above);
+    }
+
+    // Call visit(PCB*) for all requests in the order shortest seek time first
+    // would service them starting at head_pos, without removing them.
+    // Returns head position after the last request.
+    template<typename F>
+    int ForEachNearestFirst(int head_pos, F visit) const {
+      // the next request is always the closest unserviced one on either
+      // side of the requests already serviced
+      const_iterator above = lower_bound(head_pos);
+      const_iterator below = above;
+      bool below_left = (below != requests.begin());
+      if (below_left) --below;
+      while (above != requests.end() || below_left) {
+        if (above == requests.end() ||
+            (below_left && head_pos - below->first.first < above->first.first - head_pos)) {
+          head_pos = below->first.first;
+          visit(get(below));
+          // the other requests of the cylinder are then at distance 0 above
+          // the head, so they follow in pid order
+          const_iterator first = lower_bound(head_pos);
+          for (const_iterator same = first; same != below; ++same)
+            visit(get(same));
+          below = first;
+          below_left = (below != requests.begin());
+          if (below_left) --below;
+        }
+        else {
+          head_pos = above->first.first;
+          visit(get(above));
+          ++above;
+        }
+      }
+      return head_pos;
+    }
+
+  private:
+    const PCBPool* pool;
+    std::map<std::pair<int, size_t>, PCBHandle> requests;  // (cylinder, pid)
+};
+
+// Disk scheduling policies
+enum class DiskPolicy {fcfs, sstf, scan, c_scan, look, c_look, fscan};
+
+// Name of policy as used in Sysgen and traces (fcfs/sstf/scan/c-scan/look/
+// c-look/fscan)
+const char* PolicyName(DiskPolicy policy);
+
+// Parse policy name into policy. Returns false if name is not a policy.
+bool ParsePolicy(const std::string& name, DiskPolicy* policy);
+
+// Interface for disk scheduling policies as well as factory method to create
+// specific policies
+// Add(PCB* request)              - queue a request
+// Next(head_pos, cylinders, seek) - pop the request to service next with the
+//                                  head at head_pos, store head travel in seek
+// Remove(PCB* request)           - remove request, which must be queued
+// VisitRequests(head_pos, visitor) - visit requests in service order
+// Save(out)                      - write the queued requests and the state of
+//                                  the policy
+// Restore(in)                    - restore what Save wrote into an empty
+//                                  scheduler of the same policy
+struct DiskScheduler {
+  static DiskScheduler* make_scheduler(DiskPolicy policy, const PCBPool* pool);
+  virtual ~DiskScheduler() = 0;
+  virtual void Add(PCB* request) = 0;
+  virtual PCB* Next(int head_pos, int num_of_cylinders, int& seek) = 0;
+  virtual void Remove(PCB* request) = 0;
+  virtual void VisitRequests(int head_pos, RequestVisitor& visitor) const = 0;
+  virtual void Save(CheckpointWriter& out) const = 0;
+  virtual void Restore(CheckpointReader& in) = 0;
+};
+
+// First come first served
+struct FCFSScheduler: DiskScheduler {
+  explicit FCFSScheduler(const PCBPool* pool) : req_queue{pool} {}
+  void Add(PCB* request);
+  PCB* Next(int head_pos, int num_of_cylinders, int& seek);
+  void Remove(PCB* request);
+  void VisitRequests(int head_pos, RequestVisitor& visitor) const;
+  void Save(CheckpointWriter& out) const {req_queue.Save(out);}
+  void Restore(CheckpointReader& in) {req_queue.Restore(in);}
+
+  PCBQueue req_queue;
+};
+
+// Shortest seek time first
+struct SSTFScheduler: DiskScheduler {
+  explicit SSTFScheduler(const PCBPool* pool) : queue{pool} {}
+  void Add(PCB* request);
+  PCB* Next(int head_pos, int num_of_cylinders, int& seek);
+  void Remove(PCB* request);
+  void VisitRequests(int head_pos, RequestVisitor& visitor) const;
+  void Save(CheckpointWriter& out) const {queue.Save(out);}
+  void Restore(CheckpointReader& in) {queue.Restore(in);}
+
+  CylinderQueue queue;
+};
+
+// Elevator: sweep up and down servicing requests on the way.
+// SCAN travels to the last/first cylinder before reversing, LOOK reverses at
+// the last request in the direction of travel.
+struct ElevatorScheduler: DiskScheduler {
+  ElevatorScheduler(const PCBPool* pool, bool to_end) : to_end{to_end},
+                                                        queue{pool} {}
+  void Add(PCB* request);
+  PCB* Next(int head_pos, int num_of_cylinders, int& seek);
+  void Remove(PCB* request);
+  void VisitRequests(int head_pos, RequestVisitor& visitor) const;
+  void Save(CheckpointWriter& out) const;
+  void Restore(CheckpointReader& in);
+
+  bool to_end;
+  bool up = true;
+  CylinderQueue queue;
+};
+
+// Circular elevator: service requests sweeping up only, then return to the
+// start. C-SCAN travels to the last cylinder and back to cylinder 0, C-LOOK
+// jumps from the highest to the lowest request.
+struct CircularScheduler: DiskScheduler {
+  CircularScheduler(const PCBPool* pool, bool to_end) : to_end{to_end},
+                                                        queue{pool} {}
+  void Add(PCB* request);
+  PCB* Next(int head_pos, int num_of_cylinders, int& seek);
+  void Remove(PCB* request);
+  void VisitRequests(int head_pos, RequestVisitor& visitor) const;
+  void Save(CheckpointWriter& out) const {queue.Save(out);}
+  void Restore(CheckpointReader& in) {queue.Restore(in);}
+
+  bool to_end;
+  CylinderQueue queue;
+};
+
+// FSCAN: requests arriving while a queue is serviced wait in a second queue,
+// requests of the queue being serviced are picked shortest seek time first
+struct FSCANScheduler: DiskScheduler {
+  explicit FSCANScheduler(const PCBPool* pool) : queue_1{pool}, queue_2{pool} {}
+  void Add(PCB* request);
+  PCB* Next(int head_pos, int num_of_cylinders, int& seek);
+  void Remove(PCB* request);
+  void VisitRequests(int head_pos, RequestVisitor& visitor) const;
+  void Save(CheckpointWriter& out) const;
+  void Restore(CheckpointReader& in);
+
+  int run_queue = 1;
+  CylinderQueue queue_1, queue_2;  // run queue and waiting queue
+};
+
+#endif
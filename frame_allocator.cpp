@@ -0,0 +1,125 @@
+#include "frame_allocator.h"
+
+FrameAllocator::FrameAllocator(int num_of_frames) :
+    words((num_of_frames + 63)/64, ~0ull), num_of_frames{num_of_frames},
+    free_count{num_of_frames} {
+  // frames past the end of memory are never free
+  if (num_of_frames % 64 != 0) {
+    words.back() = (1ull << (num_of_frames % 64)) - 1;
+  }
+}
+
+// Bits of x where a run of at least n >= 1 ones that ends within x starts
+static uint64_t RunStarts(uint64_t x, int n) {
+  int length = 1;
+  for (; length*2 <= n; length *= 2) x &= x >> length;
+  if (length < n) x &= x >> (n - length);
+  return x;
+}
+
+int FrameAllocator::FindRun(int n) const {
+  int run_start = -1, run_length = 0;  // free run reaching the current word
+  for (size_t w = 0; w < words.size(); w++) {
+    uint64_t bits = words[w];
+    // whole words extend a run without looking at single bits
+    if (bits == ~0ull) {
+      if (run_length == 0) run_start = w*64;
+      run_length += 64;
+      if (run_length >= n) return run_start;
+      continue;
+    }
+    // run continued by the low free frames of this word
+    if (run_length > 0 && run_length + __builtin_ctzll(~bits) >= n)
+      return run_start;
+    // run within this word
+    if (n <= 64) {
+      uint64_t starts = RunStarts(bits, n);
+      if (starts != 0) return w*64 + __builtin_ctzll(starts);
+    }
+    // run starting at the high free frames of this word
+    run_length = __builtin_clzll(~bits);
+    run_start = w*64 + 64 - run_length;
+  }
+  return -1;
+}
+
+bool FrameAllocator::AllocateFrames(int n, int* frames, bool contiguous) {
+  if (n > free_count) return false;
+  free_count -= n;
+  int run_start = contiguous ? FindRun(n) : -1;
+  if (run_start >= 0) {
+    for (int i = 0; i < n; i++) {
+      int frame = run_start + i;
+      words[frame >> 6] &= ~(1ull << (frame & 63));
+      frames[i] = frame;
+    }
+    return true;
+  }
+
+  // take free frames a word at a time, starting where the last search ended
+  int taken = 0;
+  size_t w = hint;
+  while (taken < n) {
+    uint64_t bits = words[w];
+    while (bits != 0 && taken < n) {
+      frames[taken++] = w*64 + __builtin_ctzll(bits);
+      bits &= bits - 1;
+    }
+    words[w] = bits;
+    if (taken < n) w = (w + 1 == words.size()) ? 0 : w + 1;
+  }
+  hint = w;
+  return true;
+}
+
+void FrameAllocator::FreeFrames(const int* frames, int n) {
+  for (int i = 0; i < n; i++) {
+    words[frames[i] >> 6] |= 1ull << (frames[i] & 63);
+  }
+  free_count += n;
+}
+
+FreeRunStats FrameAllocator::RunStats() const {
+  FreeRunStats stats;
+  stats.free_frames = free_count;
+  int run_length = 0;
+  for (size_t w = 0; w < words.size(); w++) {
+    uint64_t bits = words[w];
+    if (bits == ~0ull) {
+      if (run_length == 0) stats.runs++;
+      run_length += 64;
+      continue;
+    }
+    int b = 0;
+    while (b < 64) {
+      uint64_t rest = bits >> b;
+      if (rest & 1) {
+        int ones = __builtin_ctzll(~rest);
+        if (run_length == 0) stats.runs++;
+        run_length += ones;
+        b += ones;
+        continue;
+      }
+      if (run_length > stats.largest_run) stats.largest_run = run_length;
+      run_length = 0;
+      if (rest == 0) break;
+      b += __builtin_ctzll(rest);
+    }
+  }
+  if (run_length > stats.largest_run) stats.largest_run = run_length;
+  return stats;
+}
+
+void FrameAllocator::Save(CheckpointWriter& out) const {
+  out.PutVector(words);
+  out.Put<int32_t>(free_count);
+  out.Put<uint64_t>(hint);
+}
+
+void FrameAllocator::Restore(CheckpointReader& in) {
+  size_t num_of_words = words.size();
+  in.GetVector(&words);
+  free_count = in.Get<int32_t>();
+  hint = in.Get<uint64_t>();
+  if (words.size() != num_of_words || hint >= num_of_words) in.Fail();
+}
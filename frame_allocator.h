@@ -0,0 +1,70 @@
+// Physical memory frame allocation with a bitmap, one bit per frame, scanned
+// a 64-bit word at a time.
+#ifndef FRAME_ALLOCATOR_H
+#define FRAME_ALLOCATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "checkpoint_io.h"
+
+// Free space statistics of a FrameAllocator
+struct FreeRunStats {
+  int free_frames = 0;
+  int runs = 0;          // maximal runs of contiguous free frames
+  int largest_run = 0;
+
+  // 0 if all free frames are contiguous, approaching 1 when free memory is
+  // split into many small runs
+  double fragmentation() const {
+    return free_frames == 0 ? 0 : 1 - (double)largest_run/free_frames;
+  }
+};
+
+class FrameAllocator {
+  public:
+    explicit FrameAllocator(int num_of_frames);
+
+    int size() const {return num_of_frames;}
+    int free_frames() const {return free_count;}
+    bool is_free(int frame) const {
+      return (words[frame >> 6] >> (frame & 63)) & 1;
+    }
+
+    // Store n free frames in frames and mark them used. If contiguous, take
+    // the first run of n free frames if there is one. Returns false and
+    // allocates nothing if fewer than n frames are free.
+    bool AllocateFrames(int n, int* frames, bool contiguous = false);
+
+    // Mark the n frames in frames free
+    void FreeFrames(const int* frames, int n);
+
+    // Count free runs, O(frames/64)
+    FreeRunStats RunStats() const;
+
+    // Restore into an allocator of as many frames
+    void Save(CheckpointWriter& out) const;
+    void Restore(CheckpointReader& in);
+
+    // Call f(int frame) for every free frame in ascending order
+    template<typename F>
+    void ForEachFree(F f) const {
+      for (size_t w = 0; w < words.size(); w++) {
+        for (uint64_t bits = words[w]; bits != 0; bits &= bits - 1) {
+          f((int)(w*64 + __builtin_ctzll(bits)));
+        }
+      }
+    }
+
+  private:
+    std::vector<uint64_t> words;  // bit set == frame free
+    int num_of_frames;
+    int free_count;
+    size_t hint = 0;  // word to start searching for free frames at
+
+    // First frame of a run of n free frames, -1 if there is none
+    int FindRun(int n) const;
+};
+
+#endif
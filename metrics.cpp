@@ -0,0 +1,319 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace os_ops {
+
+  int64_t Histogram::BucketMax(int bucket) {
+    if (bucket < (1 << kSubBits)) return bucket;
+    int exp = (bucket >> kSubBits) + kSubBits - 1;
+    int sub = bucket & ((1 << kSubBits) - 1);
+    int64_t width = 1ll << (exp - kSubBits);
+    return (((1ll << kSubBits) + sub) << (exp - kSubBits)) + width - 1;
+  }
+
+  void Histogram::Save(CheckpointWriter& out) const {
+    out.PutVector(buckets);
+    out.Put<uint64_t>(count_);
+    out.Put(sum);
+    out.Put(max_);
+  }
+
+  void Histogram::Restore(CheckpointReader& in) {
+    in.GetVector(&buckets);
+    count_ = in.Get<uint64_t>();
+    sum = in.Get<int64_t>();
+    max_ = in.Get<int64_t>();
+    if (buckets.size() != (count_ == 0 ? 0 : (size_t)kBuckets)) in.Fail();
+  }
+
+  int64_t Histogram::Quantile(double q) const {
+    if (count_ == 0) return 0;
+    uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(q*count_));
+    uint64_t seen = 0;
+    for (int b = 0; b < kBuckets; b++) {
+      seen += buckets[b];
+      if (seen >= rank) return std::min(BucketMax(b), max_);
+    }
+    return max_;
+  }
+
+  void Metrics::Save(CheckpointWriter& out) const {
+    out.Put<uint64_t>(arrivals);
+    out.Put<uint64_t>(completed);
+    out.Put<uint64_t>(killed);
+    out.Put(cpu_busy);
+    out.PutVector(cores);
+    ready_wait.Save(out);
+    turnaround.Save(out);
+    out.Put(share_sum);
+    out.Put(share_squares);
+    out.Put<uint64_t>(shares);
+    job_pool_wait.Save(out);
+    out.Put(ready_depth_time);
+    out.Put<uint64_t>(levels.size());
+    for (const auto& l: levels) {
+      out.Put<int32_t>(l.quantum);
+      l.wait.Save(out);
+      out.Put(l.depth_time);
+      out.Put<uint64_t>(l.demotions);
+      out.Put<uint64_t>(l.promotions);
+    }
+    out.Put<uint64_t>(boosts);
+    out.Put<uint64_t>(devices.size());
+    for (const auto& d: devices) {
+      d.wait.Save(out);
+      d.depth.Save(out);
+      out.Put<int32_t>(d.queued);
+      out.Put(d.depth_time);
+      out.Put(d.depth_change);
+      d.service.Save(out);
+      out.Put(d.busy);
+      out.Put(d.seek_distance);
+    }
+    out.Put<int32_t>(frames);
+    out.Put<int32_t>(used_frames);
+    out.Put(frame_time);
+    const size_t counters[] = {
+        page_references, page_faults, evictions, dirty_evictions,
+        translations, tlb_lookups, tlb_hits, tlb_flushes, tlb_shootdowns,
+        page_walks, walk_accesses, page_table_bytes, peak_page_table_bytes};
+    for (size_t counter: counters) out.Put<uint64_t>(counter);
+    process_faults.Save(out);
+  }
+
+  void Metrics::Restore(CheckpointReader& in) {
+    arrivals = in.Get<uint64_t>();
+    completed = in.Get<uint64_t>();
+    killed = in.Get<uint64_t>();
+    cpu_busy = in.Get<SimTime>();
+    size_t num_of_cores = cores.size();
+    in.GetVector(&cores);
+    if (cores.size() != num_of_cores) in.Fail();
+    ready_wait.Restore(in);
+    turnaround.Restore(in);
+    share_sum = in.Get<double>();
+    share_squares = in.Get<double>();
+    shares = in.Get<uint64_t>();
+    job_pool_wait.Restore(in);
+    ready_depth_time = in.Get<SimTime>();
+    if (in.Get<uint64_t>() != levels.size()) in.Fail();
+    for (auto& l: levels) {
+      if (!in.ok()) return;
+      l.quantum = in.Get<int32_t>();
+      l.wait.Restore(in);
+      l.depth_time = in.Get<SimTime>();
+      l.demotions = in.Get<uint64_t>();
+      l.promotions = in.Get<uint64_t>();
+    }
+    boosts = in.Get<uint64_t>();
+    if (in.Get<uint64_t>() != devices.size()) in.Fail();
+    for (auto& d: devices) {
+      if (!in.ok()) return;
+      d.wait.Restore(in);
+      d.depth.Restore(in);
+      d.queued = in.Get<int32_t>();
+      d.depth_time = in.Get<SimTime>();
+      d.depth_change = in.Get<SimTime>();
+      d.service.Restore(in);
+      d.busy = in.Get<SimTime>();
+      d.seek_distance = in.Get<long long>();
+    }
+    frames = in.Get<int32_t>();
+    used_frames = in.Get<int32_t>();
+    frame_time = in.Get<SimTime>();
+    size_t* counters[] = {
+        &page_references, &page_faults, &evictions, &dirty_evictions,
+        &translations, &tlb_lookups, &tlb_hits, &tlb_flushes, &tlb_shootdowns,
+        &page_walks, &walk_accesses, &page_table_bytes, &peak_page_table_bytes};
+    for (size_t* counter: counters) *counter = in.Get<uint64_t>();
+    process_faults.Restore(in);
+  }
+
+  std::string DeviceName(const DeviceMetrics& d) {
+    const char* type = d.type == 'c' ? "cd" : d.type == 'd' ? "disk" : "printer";
+    return type + std::to_string(d.num);
+  }
+
+  namespace {
+    // statistics reported for every histogram
+    struct HistogramStat {
+      const char* name;
+      double value;
+    };
+
+    std::vector<HistogramStat> Stats(const Histogram& h) {
+      return {{"count", (double)h.count()}, {"mean", h.mean()},
+              {"p50", (double)h.Quantile(0.5)}, {"p90", (double)h.Quantile(0.9)},
+              {"p99", (double)h.Quantile(0.99)}, {"max", (double)h.max()}};
+    }
+
+    void HistogramJSON(const char* name, const Histogram& h, std::ostream& out) {
+      out << '"' << name << "\":{";
+      bool first = true;
+      for (const auto& stat: Stats(h)) {
+        if (!first) out << ',';
+        out << '"' << stat.name << "\":" << stat.value;
+        first = false;
+      }
+      out << '}';
+    }
+
+    void HistogramCSV(SimTime now, const std::string& name, const Histogram& h,
+                      std::ostream& out) {
+      for (const auto& stat: Stats(h)) {
+        out << now << ',' << name << ',' << stat.name << ',' << stat.value << '\n';
+      }
+    }
+
+    double MeanDepth(SimTime depth_time, SimTime now) {
+      return now == 0 ? 0 : (double)depth_time/now;
+    }
+  }
+
+  void WriteMetricsJSON(const Metrics& metrics, SimTime now, std::ostream& out) {
+    // enough digits for microsecond times, restored at the end
+    std::streamsize precision = out.precision(12);
+    out << "{\"time_us\":" << now
+        << ",\"arrivals\":" << metrics.arrivals
+        << ",\"completed\":" << metrics.completed
+        << ",\"killed\":" << metrics.killed
+        << ",\"cpu_utilization\":" << metrics.cpu_utilization(now)
+        << ",\"frame_utilization\":" << metrics.frame_utilization(now)
+        << ",\"mean_ready_depth\":" << MeanDepth(metrics.ready_depth_time, now)
+        << ",\"fairness\":" << metrics.fairness() << ',';
+    out << "\"cpus\":[";
+    for (size_t i = 0; i < metrics.cores.size(); i++) {
+      const CoreMetrics& c = metrics.cores[i];
+      if (i > 0) out << ',';
+      out << "{\"utilization\":" << (now == 0 ? 0 : (double)c.busy/now)
+          << ",\"migrations\":" << c.migrations
+          << ",\"steals\":" << c.steals << '}';
+    }
+    out << "],";
+    HistogramJSON("ready_wait", metrics.ready_wait, out);
+    out << ",\"boosts\":" << metrics.boosts << ",\"levels\":[";
+    for (size_t i = 0; i < metrics.levels.size(); i++) {
+      const LevelMetrics& l = metrics.levels[i];
+      if (i > 0) out << ',';
+      out << "{\"quantum_ms\":" << l.quantum
+          << ",\"mean_depth\":" << MeanDepth(l.depth_time, now)
+          << ",\"demotions\":" << l.demotions
+          << ",\"promotions\":" << l.promotions << ',';
+      HistogramJSON("wait", l.wait, out);
+      out << '}';
+    }
+    out << "],";
+    HistogramJSON("turnaround", metrics.turnaround, out);
+    out << ',';
+    HistogramJSON("job_pool_wait", metrics.job_pool_wait, out);
+    out << ",\"paging\":{\"references\":" << metrics.page_references
+        << ",\"faults\":" << metrics.page_faults
+        << ",\"fault_rate\":" << metrics.fault_rate()
+        << ",\"evictions\":" << metrics.evictions
+        << ",\"dirty_evictions\":" << metrics.dirty_evictions << ',';
+    HistogramJSON("process_faults", metrics.process_faults, out);
+    out << "},\"tlb\":{\"translations\":" << metrics.translations
+        << ",\"lookups\":" << metrics.tlb_lookups
+        << ",\"hits\":" << metrics.tlb_hits
+        << ",\"hit_rate\":" << metrics.tlb_hit_rate()
+        << ",\"flushes\":" << metrics.tlb_flushes
+        << ",\"shootdowns\":" << metrics.tlb_shootdowns
+        << ",\"walk_accesses\":" << metrics.walk_accesses
+        << ",\"effective_access_ns\":" << metrics.effective_access_ns()
+        << "},\"page_tables\":{\"walks\":" << metrics.page_walks
+        << ",\"walk_cost\":" << metrics.walk_cost()
+        << ",\"bytes\":" << metrics.page_table_bytes
+        << ",\"peak_bytes\":" << metrics.peak_page_table_bytes
+        << "},\"devices\":[";
+    for (size_t i = 0; i < metrics.devices.size(); i++) {
+      const DeviceMetrics& d = metrics.devices[i];
+      if (i > 0) out << ',';
+      out << "{\"name\":\"" << DeviceName(d) << "\",\"mean_depth\":"
+          << MeanDepth(d.depth_time, now) << ",\"utilization\":"
+          << MeanDepth(d.busy, now) << ",\"seek_distance\":"
+          << d.seek_distance << ',';
+      HistogramJSON("wait", d.wait, out);
+      out << ',';
+      HistogramJSON("depth", d.depth, out);
+      out << ',';
+      HistogramJSON("service", d.service, out);
+      out << '}';
+    }
+    out << "]}" << std::endl;
+    out.precision(precision);
+  }
+
+  void WriteMetricsCSV(const Metrics& metrics, SimTime now, std::ostream& out,
+                       bool header) {
+    std::streamsize precision = out.precision(12);
+    if (header) out << "time_us,metric,stat,value\n";
+    out << now << ",processes,arrivals," << metrics.arrivals << '\n'
+        << now << ",processes,completed," << metrics.completed << '\n'
+        << now << ",processes,killed," << metrics.killed << '\n'
+        << now << ",cpu,utilization," << metrics.cpu_utilization(now) << '\n'
+        << now << ",frames,utilization," << metrics.frame_utilization(now) << '\n'
+        << now << ",ready_queue,mean_depth,"
+        << MeanDepth(metrics.ready_depth_time, now) << '\n'
+        << now << ",cpu,fairness," << metrics.fairness() << '\n';
+    for (size_t i = 0; i < metrics.cores.size(); i++) {
+      const CoreMetrics& c = metrics.cores[i];
+      std::string name = "cpu" + std::to_string(i);
+      out << now << ',' << name << ",utilization,"
+          << (now == 0 ? 0 : (double)c.busy/now) << '\n'
+          << now << ',' << name << ",migrations," << c.migrations << '\n'
+          << now << ',' << name << ",steals," << c.steals << '\n';
+    }
+    HistogramCSV(now, "ready_wait", metrics.ready_wait, out);
+    if (!metrics.levels.empty())
+      out << now << ",ready_queue,boosts," << metrics.boosts << '\n';
+    for (size_t i = 0; i < metrics.levels.size(); i++) {
+      const LevelMetrics& l = metrics.levels[i];
+      std::string name = "level" + std::to_string(i);
+      out << now << ',' << name << ",quantum_ms," << l.quantum << '\n'
+          << now << ',' << name << ",mean_depth,"
+          << MeanDepth(l.depth_time, now) << '\n'
+          << now << ',' << name << ",demotions," << l.demotions << '\n'
+          << now << ',' << name << ",promotions," << l.promotions << '\n';
+      HistogramCSV(now, name + "_wait", l.wait, out);
+    }
+    HistogramCSV(now, "turnaround", metrics.turnaround, out);
+    HistogramCSV(now, "job_pool_wait", metrics.job_pool_wait, out);
+    out << now << ",paging,references," << metrics.page_references << '\n'
+        << now << ",paging,faults," << metrics.page_faults << '\n'
+        << now << ",paging,fault_rate," << metrics.fault_rate() << '\n'
+        << now << ",paging,evictions," << metrics.evictions << '\n'
+        << now << ",paging,dirty_evictions," << metrics.dirty_evictions << '\n';
+    HistogramCSV(now, "process_faults", metrics.process_faults, out);
+    out << now << ",tlb,translations," << metrics.translations << '\n'
+        << now << ",tlb,lookups," << metrics.tlb_lookups << '\n'
+        << now << ",tlb,hits," << metrics.tlb_hits << '\n'
+        << now << ",tlb,hit_rate," << metrics.tlb_hit_rate() << '\n'
+        << now << ",tlb,flushes," << metrics.tlb_flushes << '\n'
+        << now << ",tlb,shootdowns," << metrics.tlb_shootdowns << '\n'
+        << now << ",tlb,walk_accesses," << metrics.walk_accesses << '\n'
+        << now << ",tlb,effective_access_ns," << metrics.effective_access_ns()
+        << '\n'
+        << now << ",page_tables,walks," << metrics.page_walks << '\n'
+        << now << ",page_tables,walk_cost," << metrics.walk_cost() << '\n'
+        << now << ",page_tables,bytes," << metrics.page_table_bytes << '\n'
+        << now << ",page_tables,peak_bytes," << metrics.peak_page_table_bytes
+        << '\n';
+    for (const auto& d: metrics.devices) {
+      std::string name = DeviceName(d);
+      out << now << ',' << name << ",mean_depth,"
+          << MeanDepth(d.depth_time, now) << '\n'
+          << now << ',' << name << ",utilization,"
+          << MeanDepth(d.busy, now) << '\n'
+          << now << ',' << name << ",seek_distance," << d.seek_distance
+          << '\n';
+      HistogramCSV(now, name + "_wait", d.wait, out);
+      HistogramCSV(now, name + "_depth", d.depth, out);
+      HistogramCSV(now, name + "_service", d.service, out);
+    }
+    out.flush();
+    out.precision(precision);
+  }
+
+}
@@ -0,0 +1,199 @@
+// Always-on OS metrics: log-bucketed latency histograms, counters and time
+// weighted queue depths, measured on the OS clock, and their export as JSON
+// or CSV.
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "checkpoint_io.h"
+
+namespace os_ops {
+
+// Time in microseconds
+typedef int64_t SimTime;
+const SimTime kMillisecond = 1000;
+
+// Default access times for effective access time estimates
+const double kTLBLookupNs = 1;
+const double kMemoryAccessNs = 100;
+
+// Histogram of non-negative values in log-linear buckets: 4 buckets per power
+// of two, so quantiles are within 25% of the recorded values
+class Histogram {
+  public:
+    void Add(int64_t value) {
+      if (value < 0) value = 0;
+      if (buckets.empty()) buckets.assign(kBuckets, 0);
+      buckets[Bucket(value)]++;
+      count_++;
+      sum += value;
+      if (value > max_) max_ = value;
+    }
+
+    size_t count() const {return count_;}
+    int64_t max() const {return max_;}
+    double mean() const {return count_ == 0 ? 0 : (double)sum/count_;}
+    // Upper bound of the bucket holding quantile q (0 <= q <= 1) of the
+    // values, 0 if there are none
+    int64_t Quantile(double q) const;
+
+    void Save(CheckpointWriter& out) const;
+    void Restore(CheckpointReader& in);
+
+  private:
+    static const int kSubBits = 2;
+    static const int kBuckets = (64 - kSubBits) << kSubBits;
+
+    // allocated by the first Add, the histograms of most devices of a large
+    // system stay empty
+    std::vector<uint64_t> buckets;
+    size_t count_ = 0;
+    int64_t sum = 0;
+    int64_t max_ = 0;
+
+    static int Bucket(int64_t value) {
+      if (value < (1 << kSubBits)) return value;
+      int exp = 63 - __builtin_clzll(value);
+      int sub = (value >> (exp - kSubBits)) & ((1 << kSubBits) - 1);
+      return ((exp - kSubBits + 1) << kSubBits) + sub;
+    }
+    static int64_t BucketMax(int bucket);
+};
+
+// Queue metrics of a device
+struct DeviceMetrics {
+  char type;          // c/d/p
+  int num;            // 1-based
+  Histogram wait;     // request to completion
+  Histogram depth;    // requests queued ahead of a new request
+  int queued = 0;
+  SimTime depth_time = 0;  // integral of queued over time
+  SimTime depth_change = 0;  // depth_time is integrated up to this time
+  // requests whose service was started with timings (OS::StartService)
+  Histogram service;  // service time
+  SimTime busy = 0;   // sum of service times
+  long long seek_distance = 0;  // disks: cylinders travelled
+};
+
+// Metrics of a priority level of the run queues, summed over all CPUs
+struct LevelMetrics {
+  int quantum = 0;         // ms
+  Histogram wait;          // time in the level's queue per dispatch
+  SimTime depth_time = 0;  // integral of the processes queued in the level
+  size_t demotions = 0;    // processes that dropped out of the level
+  size_t promotions = 0;   // processes that rose into the level
+};
+
+// Metrics of a CPU
+struct CoreMetrics {
+  SimTime busy = 0;       // CPU time charged to processes
+  size_t migrations = 0;  // processes dispatched that last ran on another CPU
+  size_t steals = 0;      // processes taken from another CPU's run queue
+  // time up to which the depths of the run queue and its levels are
+  // integrated into Metrics
+  SimTime depth_change = 0;
+};
+
+// Metrics of an OS. Times are on the OS clock.
+struct Metrics {
+  size_t arrivals = 0;       // processes created
+  size_t completed = 0;      // processes terminated
+  size_t killed = 0;         // processes killed before terminating
+  SimTime cpu_busy = 0;      // CPU time charged to processes, all CPUs
+  std::vector<CoreMetrics> cores;
+
+  Histogram ready_wait;      // time in the ready queue per dispatch
+  Histogram turnaround;      // arrival to termination
+  // share of their runnable time terminated processes ran per unit of
+  // weight, for the fairness index
+  double share_sum = 0, share_squares = 0;
+  size_t shares = 0;
+  Histogram job_pool_wait;   // arrival to admission of jobs that waited
+  SimTime ready_depth_time = 0;  // integral of the run queue lengths
+  std::vector<LevelMetrics> levels;  // multilevel queues only
+  size_t boosts = 0;               // moves of every ready process to the top
+  std::vector<DeviceMetrics> devices;  // in OS order cd/rw->disks->printers
+
+  int frames = 0;
+  int used_frames = 0;
+  SimTime frame_time = 0;    // integral of used_frames over time
+
+  size_t page_references = 0;  // pages translated for I/O requests
+  size_t page_faults = 0;      // pages loaded on demand
+  size_t evictions = 0;        // pages replaced to load another
+  size_t dirty_evictions = 0;  // replaced pages that had to be written back
+  Histogram process_faults;    // page faults per process that held memory
+
+  size_t translations = 0;     // addresses translated
+  size_t tlb_lookups = 0;
+  size_t tlb_hits = 0;
+  size_t tlb_flushes = 0;      // on context switches without ASIDs
+  size_t tlb_shootdowns = 0;   // evicted pages invalidated in every TLB
+  size_t page_walks = 0;       // page table lookups (TLB misses)
+  size_t walk_accesses = 0;    // memory accesses walking page tables
+  size_t page_table_bytes = 0;       // page table memory in use
+  size_t peak_page_table_bytes = 0;
+
+  // Averages over elapsed time, CPU utilization over all CPUs
+  double cpu_utilization(SimTime elapsed) const {
+    return elapsed == 0 ? 0 : (double)cpu_busy/elapsed/std::max<size_t>(1, cores.size());
+  }
+  double frame_utilization(SimTime elapsed) const {
+    return elapsed == 0 || frames == 0 ? 0 : (double)frame_time/elapsed/frames;
+  }
+  void AddShare(double share) {
+    share_sum += share;
+    share_squares += share*share;
+    shares++;
+  }
+  // Jain's fairness index of the weighted CPU shares: 1 if all are equal,
+  // 1/n if one process got everything
+  double fairness() const {
+    return share_squares == 0 ? 1 : share_sum*share_sum/(shares*share_squares);
+  }
+  double tlb_hit_rate() const {
+    return tlb_lookups == 0 ? 0 : (double)tlb_hits/tlb_lookups;
+  }
+  // Mean time of a memory access through address translation in ns, given
+  // the time of a TLB lookup and of a memory access
+  double effective_access_ns(double tlb_ns = kTLBLookupNs,
+                             double memory_ns = kMemoryAccessNs) const {
+    if (translations == 0) return 0;
+    return (tlb_lookups*tlb_ns + (translations + walk_accesses)*memory_ns)/
+           translations;
+  }
+  // Memory accesses per page table walk
+  double walk_cost() const {
+    return page_walks == 0 ? 0 : (double)walk_accesses/page_walks;
+  }
+  // Page faults per page reference
+  double fault_rate() const {
+    return page_references == 0 ? 0 : (double)page_faults/page_references;
+  }
+
+  // Restore into the metrics of an OS with as many CPUs, priority levels and
+  // devices
+  void Save(CheckpointWriter& out) const;
+  void Restore(CheckpointReader& in);
+};
+
+// Name of device d for output, e.g. disk2
+std::string DeviceName(const DeviceMetrics& d);
+
+// Write metrics at time now as one JSON object on one line
+void WriteMetricsJSON(const Metrics& metrics, SimTime now, std::ostream& out);
+
+// Write metrics at time now as CSV rows, one per histogram and one for the
+// totals, preceded by a header line if header
+void WriteMetricsCSV(const Metrics& metrics, SimTime now, std::ostream& out,
+                     bool header);
+
+}
+
+#endif
@@ -2,294 +2,600 @@
 // 08 Oct 2017
 // Implementation file for methods and function of basic OS in os.h
 
+#include <algorithm>
 #include <iomanip>
 #include <limits>
 #include <iostream>
-#include <sstream>
+#include <cctype>
+#include <cstring>
 
 #include "os.h"
 
-int PCB::page_size = 0;
 namespace os_ops {
 
-  // Get input from standard input stream until input type matches type T of
-  // variable it is being stored in.
-  // Returns retrieved input.
-  template<typename T>
-  T InputWithTypeCheck(const std::string& error_message) {
-    T input_var;
-    std::cin >> input_var;
-    while (std::cin.fail()) {
-      std::cout << error_message << ": ";
-      std::cin.clear();
-      std::cin.ignore(256,'\n');
-      std::cin >> input_var;
-    }
-    return input_var;
+  const char* StatusMessage(Status status) {
+    switch (status) {
+      case Status::ok: return "OK";
+      case Status::no_active_process: return "CPU has no active process";
+      case Status::invalid_device: return "No such device";
+      case Status::invalid_params: return "Invalid parameters";
+      case Status::queue_empty: return "Device queue empty";
+      case Status::too_large: return "Process larger than maximum process size";
+      case Status::no_such_process: return "Process does not exist";
+      case Status::invalid_cpu: return "No such CPU";
+    }
+    return "Unknown status";
+  }
+
+  // Whether the policies and page table organization of params are values of
+  // their enums, which they need not be if read from a file
+  static bool KnownPolicies(const SysgenParams& params) {
+    for (DiskPolicy policy: params.disk_policies) {
+      if (policy < DiskPolicy::fcfs || policy > DiskPolicy::fscan) return false;
+    }
+    return params.page_replacement >= ReplacementPolicy::none &&
+           params.page_replacement <= ReplacementPolicy::clock &&
+           params.tlb.policy >= TLBPolicy::lru &&
+           params.tlb.policy <= TLBPolicy::random &&
+           params.page_tables >= PageTableKind::dense &&
+           params.page_tables <= PageTableKind::inverted &&
+           params.scheduler.policy >= CPUPolicy::round_robin &&
+           params.scheduler.policy <= CPUPolicy::cfs;
+  }
+
+  bool ValidSysgen(const SysgenParams& params, std::string* error) {
+    const char* rule = nullptr;
+    if (!KnownPolicies(params))
+      rule = "Unknown scheduling or replacement policy or page table organization";
+    else if (params.printer_num < 0) rule = "Number of printers must be >= 0";
+    else if (params.disk_num < 0 || params.disk_num > kMaxDisks)
+      rule = "Number of disk devices must be 0-2^20";
+    else if (params.cyl_nums.size() != (size_t)params.disk_num)
+      rule = "Number of cylinders required for every disk";
+    else if (!params.disk_policies.empty() &&
+             params.disk_policies.size() != (size_t)params.disk_num)
+      rule = "Scheduling policy required for every disk";
+    else if (params.cd_num < 0) rule = "Number of cd-rw devices must be >= 0";
+    else if (params.time_slice <= 0) rule = "Length of time slice must be > 0";
+    else if (params.cpu_num < 1) rule = "Number of CPUs must be >= 1";
+    else if (params.scheduler.policy == CPUPolicy::mlfq &&
+             (params.scheduler.levels < 1 || params.scheduler.levels > kMaxLevels))
+      rule = "Number of priority levels must be 1-16";
+    // the lowest level runs processes for time_slice << (levels-1) ms
+    else if (params.scheduler.policy == CPUPolicy::mlfq &&
+             params.time_slice > std::numeric_limits<int>::max() >>
+                                 (params.scheduler.levels - 1))
+      rule = "Time slice of the lowest priority level must fit in an int";
+    else if (params.scheduler.boost_interval < 0)
+      rule = "Priority boost interval must be >= 0";
+    else if (params.scheduler.policy == CPUPolicy::cfs &&
+             (params.scheduler.min_granularity < 1 ||
+              params.scheduler.target_latency < params.scheduler.min_granularity))
+      rule = "Target latency must be >= minimum granularity >= 1";
+    else if (params.tlb.entries < 0 ||
+             (params.tlb.entries > 0 && (params.tlb.ways < 1 ||
+                                         params.tlb.entries % params.tlb.ways != 0)))
+      rule = "TLB entries must be >= 0 and a multiple of its ways";
+    else if (params.page_size <= 0 ||
+             (params.page_size & (~params.page_size+1)) != params.page_size)
+      rule = "Page size must be > 0 and a power of 2";
+    else if (params.mem_size <= 0 || params.mem_size % params.page_size != 0)
+      rule = "Memory size must be > 0 and multiple of page size";
+    else if (params.mem_size/params.page_size > kPageFrame + 1)
+      rule = "Memory must be at most 2^28 pages";
+    else if (params.max_proc_size <= 0 || params.max_proc_size > params.mem_size)
+      rule = "Max process size must be > 0 and <= memory size";
+    else if (params.device_timings.enabled &&
+             (params.device_timings.read_size < 0 ||
+              params.device_timings.seek_settle < 0 ||
+              params.device_timings.seek_per_cylinder < 0 ||
+              params.device_timings.rpm < 0 ||
+              params.device_timings.disk_rate < 0 ||
+              params.device_timings.printer_setup < 0 ||
+              params.device_timings.printer_rate < 0 ||
+              params.device_timings.cd_access < 0 ||
+              params.device_timings.cd_read_rate < 0 ||
+              params.device_timings.cd_write_rate < 0))
+      rule = "Device timings must be >= 0";
+    for (const auto& cyl: params.cyl_nums) {
+      if (rule == nullptr && cyl < 0) rule = "Number of cylinders must be >= 0";
+    }
+    if (rule != nullptr && error != nullptr) *error = rule;
+    return rule == nullptr;
   }
 
-  OS::OS(OS&& other) : active_process{other.active_process},
+  OS::OS(OS&& other) : config(std::move(other.config)),
+                             cores{std::move(other.cores)},
+                             time_slice_length{other.time_slice_length},
+                             boost_interval{other.boost_interval},
+                             next_boost{other.next_boost},
+                             affinity{other.affinity},
+                             CPU_time_sum{other.CPU_time_sum},
+                             num_of_completed{other.num_of_completed},
                              pid_count{other.pid_count},
                              printer_num{other.printer_num},
                              disk_num{other.disk_num}, cd_num{other.cd_num},
-                             CPU_time_sum{other.CPU_time_sum},
-                             num_of_completed{other.num_of_completed},
-                             time_slice_length{other.time_slice_length},
                              page_size{other.page_size}, mem_size{other.mem_size},
                              max_proc_size{other.max_proc_size},
-                             free_frame_list{std::move(other.free_frame_list)},
+                             contiguous_frames{other.contiguous_frames},
+                             timings(other.timings),
+                             frames{std::move(other.frames)},
                              frame_table{std::move(other.frame_table)},
+                             replacement{other.replacement},
+                             replacer{std::move(other.replacer)},
+                             frame_entries{std::move(other.frame_entries)},
                              devices{std::move(other.devices)},
-                             ready_queue{std::move(other.ready_queue)},
-                             input_queue{std::move(other.input_queue)} {
-    other.active_process = nullptr;
-  }
+                             pool{std::move(other.pool)},
+                             tables{std::move(other.tables)},
+                             admit_frames{std::move(other.admit_frames)},
+                             job_pool{std::move(other.job_pool)},
+                             proc_index{std::move(other.proc_index)},
+                             now{other.now},
+                             external_clock{other.external_clock},
+                             os_metrics{std::move(other.os_metrics)} {}
   OS::~OS() {
     for (auto& d: devices) delete d;
-    for (auto& p: ready_queue) delete p;
-    delete active_process;
+    // PCBs are freed with the pool
+  }
+
+  void OS::AdvanceClock(SimTime time) {
+    external_clock = true;
+    SetClock(time);
+  }
+
+  void OS::SetClock(SimTime time) {
+    if (time <= now) return;
+    SimTime elapsed = time - now;
+    os_metrics.frame_time += os_metrics.used_frames*elapsed;
+    // queue depths are integrated as they change, see SettleDepths
+    now = time;
+  }
+
+  void OS::SettleQueue(int core) const {
+    SimTime& last = os_metrics.cores[core].depth_change;
+    SimTime elapsed = now - last;
+    if (elapsed <= 0) return;
+    const RunQueue* queue = cores[core].run_queue.get();
+    os_metrics.ready_depth_time += queue->size()*elapsed;
+    for (size_t l = 0; l < os_metrics.levels.size(); l++)
+      os_metrics.levels[l].depth_time += queue->level_size(l)*elapsed;
+    last = now;
+  }
+
+  void OS::SettleDevice(int index) const {
+    DeviceMetrics& d = os_metrics.devices[index];
+    d.depth_time += d.queued*(now - d.depth_change);
+    d.depth_change = now;
   }
 
-  void OS::IORequest(char device_type, int device_num) {
-    if (active_process == nullptr) {
-      std::cerr << "I/O request failed. CPU has no active process" << std::endl;
+  void OS::SettleDepths() const {
+    for (size_t c = 0; c < cores.size(); c++) SettleQueue(c);
+    for (size_t d = 0; d < devices.size(); d++) SettleDevice(d);
+  }
+
+  void OS::ChargeCPU(int duration, int core) {
+    os_metrics.cpu_busy += duration*kMillisecond;
+    os_metrics.cores[core].busy += duration*kMillisecond;
+    cores[core].run_queue->Ran(cores[core].active, duration);
+    if (!external_clock) SetClock(now + duration*kMillisecond);
+  }
+
+  void OS::SetActive(int core, PCB* p) {
+    Core& c = cores[core];
+    c.active = p;
+    if (p == nullptr) return;
+    // without ASIDs the translations of the previous process must go
+    if (c.tlb && !c.tlb->asid() && c.tlb_pid != p->pid) {
+      c.tlb->Flush();
+      os_metrics.tlb_flushes++;
+    }
+    c.tlb_pid = p->pid;
+    p->slice = c.run_queue->Quantum(p);
+    p->proc_state = PCB::active;
+    p->core = core;
+    if (p->last_core >= 0 && p->last_core != core)
+      os_metrics.cores[core].migrations++;
+    p->last_core = core;
+  }
+
+  int OS::LeastLoaded() const {
+    int least = 0;
+    for (size_t c = 0; c < cores.size(); c++) {
+      if (cores[c].active == nullptr) return c;
+      if (cores[c].run_queue->size() < cores[least].run_queue->size()) least = c;
+    }
+    return least;
+  }
+
+  void OS::MakeReady(PCB* p, int core) {
+    if (affinity && p->last_core >= 0) core = p->last_core;
+    else if (core < 0) core = LeastLoaded();
+
+    if (cores[core].active == nullptr) {
+      os_metrics.ready_wait.Add(0);
+      if (!os_metrics.levels.empty()) os_metrics.levels[p->priority].wait.Add(0);
+      SetActive(core, p);
       return;
     }
+    Enqueue(p, core);
+    // idle CPUs do not wait for affinity
+    for (size_t c = 0; c < cores.size(); c++) {
+      if (cores[c].active == nullptr) ScheduleNext(c);
+    }
+  }
 
-    // add CPU time to process
-    active_process->cpu_time += TimeSliceInterrupt();
-    active_process->bursts++;
+  void OS::Enqueue(PCB* p, int core) {
+    p->proc_state = PCB::ready;
+    p->core = core;
+    p->queued_time = now;
+    SettleQueue(core);
+    cores[core].run_queue->Add(p);
+  }
 
-    // calculate which device IO request is meant for
-    // convert lowercase device type (c/d/p) to 0,1,2
-    int device_id = (device_type-99) % 11;
-    int offset = cd_num*(--device_id >= 0);
-    offset += disk_num*(device_id-1 >= 0);
-    int index = offset + device_num-1;
-
-    // get all IO request information
-    std::cout << "File name (max 20 characters): ";
-    std::string file_name = InputWithTypeCheck<std::string>("File name invalid");
-    while (file_name.size() > 20) {
-      std::cout << "File name too large. Try again: ";
-      file_name = InputWithTypeCheck<std::string>("File name invalid");
-    }
-
-    int start_mem_loc = -1;
-    bool invalid = true;
-    std::cout << "Starting location in memory (hex): ";
-    while (invalid) {
-      std::string start_mem_loc_str = InputWithTypeCheck<std::string>("Memory location invalid");
-      // make sure memory input is valid hex
-      while (start_mem_loc_str.find_first_not_of("012345679abcdefABCDEF") != std::string::npos) {
-        start_mem_loc_str = InputWithTypeCheck<std::string>("Memory location invalid");
-      }
-      std::istringstream ss{start_mem_loc_str};
-      ss >> std::hex >> start_mem_loc;
-      if (start_mem_loc > 0 && start_mem_loc < active_process->size) {
-        invalid = false;
-      }
-      else {
-        std::cout << "Start memory location must be >= 0 and < " << active_process->size << ": ";
+  void OS::ScheduleNext(int core) {
+    BoostPriorities();
+    int victim = core;
+    if (cores[core].run_queue->empty()) {
+      // steal from the longest run queue
+      for (size_t c = 0; c < cores.size(); c++) {
+        if (cores[c].run_queue->size() > cores[victim].run_queue->size())
+          victim = c;
       }
     }
-    // split input logical address into page number and displacement
-    int displacement = start_mem_loc % page_size;
-    int page_number = start_mem_loc/page_size;
-    // get frame number from page table
-    int frame_number = active_process->page_table[page_number];
-    active_process->physical_loc = frame_number*page_size + displacement;
-    std::cout << "Physical address: " << std::hex << active_process->physical_loc << std::endl;
+    RunQueue* queue = cores[victim].run_queue.get();
+    SettleQueue(victim);
+    PCB* next = nullptr;
+    if (victim == core) {
+      next = queue->Next();
+    }
+    else {
+      next = queue->Steal();
+      os_metrics.cores[core].steals++;
+    }
+    if (next != nullptr) {
+      next->ready_time += now - next->queued_time;
+      os_metrics.ready_wait.Add(now - next->queued_time);
+      if (!os_metrics.levels.empty())
+        os_metrics.levels[next->priority].wait.Add(now - next->queued_time);
+    }
+    SetActive(core, next);
+  }
+
+  void OS::BoostPriorities() {
+    if (boost_interval <= 0 || now < next_boost) return;
+    // running processes are boosted too, waiting ones rise as their I/O
+    // completes
+    for (size_t c = 0; c < cores.size(); c++) {
+      SettleQueue(c);
+      cores[c].run_queue->Boost();
+      if (cores[c].active != nullptr) cores[c].active->priority = 0;
+    }
+    os_metrics.boosts++;
+    next_boost = now + boost_interval*kMillisecond;
+  }
+
+  int OS::disk_cylinders(int disk_num) const {
+    const Disk* d = disk(disk_num);
+    return (d == nullptr) ? -1 : d->num_of_cylinders;
+  }
+
+  const Disk* OS::disk(int disk_num) const {
+    int index = DeviceIndex('d', disk_num);
+    if (index < 0) return nullptr;
+    return static_cast<const Disk*>(devices[index]);
+  }
+
+  int OS::DeviceIndex(char device_type, int device_num) const {
+    // convert device type (c/d/p or C/D/P) to 0,1,2
+    char type = tolower(device_type);
+    int device_id, count;
+    if (type == 'c') {device_id = 0; count = cd_num;}
+    else if (type == 'd') {device_id = 1; count = disk_num;}
+    else if (type == 'p') {device_id = 2; count = printer_num;}
+    else return -1;
+    if (device_num < 1 || device_num > count) return -1;
+
+    int offset = cd_num*(--device_id >= 0);
+    offset += disk_num*(device_id-1 >= 0);
+    return offset + device_num-1;
+  }
+
+  Status OS::TimeSliceInterrupt(int duration, int core) {
+    if (!IsCore(core)) return Status::invalid_cpu;
+    PCB* active_process = cores[core].active;
+    if (active_process == nullptr) return Status::no_active_process;
+    if (duration < 0 || duration > active_process->slice)
+      return Status::invalid_params;
+    active_process->cpu_time += duration;
+    ChargeCPU(duration, core);
+    return Status::ok;
+  }
 
+  Status OS::IORequest(char device_type, int device_num, int burst,
+                       const IOParams& params, size_t* physical_loc,
+                       int core) {
+    if (!IsCore(core)) return Status::invalid_cpu;
+    PCB* active_process = cores[core].active;
+    if (active_process == nullptr) return Status::no_active_process;
+    int index = DeviceIndex(device_type, device_num);
+    if (index < 0 || !islower(device_type)) return Status::invalid_device;
+
+    // validate all IO request information before changing any state
+    if (burst < 0 || burst > active_process->slice) return Status::invalid_params;
+    if (params.file_name == nullptr || strlen(params.file_name) > 20)
+      return Status::invalid_params;
+    if (params.start_mem_loc < 0 || params.start_mem_loc >= active_process->size)
+      return Status::invalid_params;
     char operation = 'w';
     if (device_type != 'p') {  // if device is a printer, only write operation
-      std::cout << "Read or write (r/w): ";
-      operation = InputWithTypeCheck<char>("Operation invalid (r/w)");
-      while (operation != 'r' && operation != 'w') {
-        std::cout << "Operation has to be read(r) or write(w): ";
-        operation = InputWithTypeCheck<char>("Operation invalid (r/w)");
-      }
+      operation = params.op;
+      if (operation != 'r' && operation != 'w') return Status::invalid_params;
     }
-
     int cylinder = -1;
-    if (device_type == 'd') {  // if device is disk, ask for cylinder number
+    if (device_type == 'd') {
+      cylinder = params.cylinder;
       Disk* d = static_cast<Disk*>(devices[index]);
-      std::cout << "Cylinder to access: ";
-      cylinder = InputWithTypeCheck<int>("Cylinder number invalid");
-      while (cylinder < 0 || cylinder > d->num_of_cylinders-1) {
-        std::cout << "Cylinder number must be 0-"
-                  << d->num_of_cylinders - 1
-                  << ": ";
-        cylinder = InputWithTypeCheck<int>("Cylinder number invalid");
-      }
+      if (cylinder < 0 || cylinder > d->num_of_cylinders-1)
+        return Status::invalid_params;
     }
-
     int file_size = 0;
     if (operation == 'w') {
-      std::cout << "Write file size: ";
-      file_size = InputWithTypeCheck<int>("File size invalid");
-      while (file_size <= 0) {
-        std::cout << "File size must be > 0: ";
-        file_size = InputWithTypeCheck<int>("File size invalid");
-      }
+      file_size = params.file_size;
+      if (file_size <= 0) return Status::invalid_params;
     }
-    active_process->file_name = file_name;
-    active_process->start_mem_loc = start_mem_loc;
+
+    // add CPU time to process
+    active_process->cpu_time += burst;
+    active_process->bursts++;
+    ChargeCPU(burst, core);
+
+    // split input logical address into page number and displacement
+    int displacement = params.start_mem_loc % page_size;
+    int page_number = params.start_mem_loc/page_size;
+    // get frame number from the TLB or page table, reads from the device
+    // write the page
+    int frame_number = Translate(active_process, page_number, core,
+                                 operation == 'r');
+    active_process->physical_loc = frame_number*page_size + displacement;
+    if (physical_loc != nullptr) *physical_loc = active_process->physical_loc;
+
+    strcpy(active_process->file_name, params.file_name);
+    active_process->start_mem_loc = params.start_mem_loc;
     active_process->op = operation;
     active_process->file_size = file_size;
     active_process->cylinder_num = cylinder;
 
     // push process onto the device queue
+    active_process->proc_state = PCB::waiting;
+    active_process->device = index;
+    active_process->queued_time = now;
+    DeviceMetrics& device_metrics = os_metrics.devices[index];
+    SettleDevice(index);
+    device_metrics.depth.Add(device_metrics.queued++);
     devices[index]->AddRequest(active_process);
 
-    // move new process from ready queue to CPU
-    if (!ready_queue.empty()) {
-      active_process = ready_queue.front();
-      ready_queue.pop_front();
-    }
-    else
-      active_process = nullptr;
+    // move new process from run queue to CPU
+    ScheduleNext(core);
+    return Status::ok;
   }
 
-  void OS::HandleInterrupt(char device_type, int device_num) {
-    // convert device type (uppercase C/D/P) to 0/1/2
-    int device_id = (device_type-67) % 11;
-    int offset = cd_num*(--device_id >= 0);
-    offset += disk_num*(device_id-1 >= 0);
-    int index = offset + device_num-1;
+  Status OS::HandleInterrupt(char device_type, int device_num, size_t* pid,
+                             int core) {
+    int index = DeviceIndex(device_type, device_num);
+    if (index < 0 || !isupper(device_type)) return Status::invalid_device;
+    if (core >= 0 && !IsCore(core)) return Status::invalid_cpu;
 
     PCB* finished = devices[index]->PopFinished();
-    if (finished == nullptr) {
-      std::cerr << "Device queue empty." << std::endl;
-      return;
-    }
+    if (finished == nullptr) return Status::queue_empty;
+
+    DeviceMetrics& device_metrics = os_metrics.devices[index];
+    SettleDevice(index);
+    device_metrics.queued--;
+    device_metrics.wait.Add(now - finished->queued_time);
+
+    // move process for which I/O finished to ready queue or directly to CPU,
+    // with multilevel queues a level up
+    finished->device = -1;
+    int level = finished->priority;
+    cores[finished->last_core].run_queue->Woken(finished);
+    if (finished->priority < level)
+      os_metrics.levels[finished->priority].promotions++;
+    MakeReady(finished, core);
+    if (pid != nullptr) *pid = finished->pid;
+    return Status::ok;
+  }
 
-    // move process for which I/O finished to ready queue or directly to CPU
-    if (active_process == nullptr) {
-      active_process = finished;
-    }
-    else {
-      ready_queue.push_back(finished);
-    }
-    std::cout << "IO request for process " << finished->pid << " completed"
-              << std::endl;
+  Status OS::StartService(char device_type, int device_num,
+                          SimTime* duration) {
+    int index = DeviceIndex(device_type, device_num);
+    if (index < 0) return Status::invalid_device;
+
+    PCB* request = devices[index]->StartService();
+    if (request == nullptr) return Status::queue_empty;
+    int seek = devices[index]->service_seek();
+    SimTime time = 0;
+    if (timings.enabled) {
+      time = ServiceTime(timings, tolower(device_type), request, seek);
+      DeviceMetrics& device_metrics = os_metrics.devices[index];
+      device_metrics.service.Add(time);
+      device_metrics.busy += time;
+      device_metrics.seek_distance += seek;
+    }
+    if (duration != nullptr) *duration = time;
+    return Status::ok;
   }
 
-  void OS::NewProcess() {
-    size_t pid = pid_count++;
-    std::cout << "Process " << pid << " arrived" << std::endl;
-    std::cout << "Process size: ";
-    int proc_size = InputWithTypeCheck<int>("Process size invalid: ");
-    while (proc_size <= 0) {
-      std::cout << "Process size must be > 0: ";
-      proc_size = InputWithTypeCheck<int>("Process size invalid: ");
-    }
-    if (proc_size > max_proc_size) {
-      std::cerr << "Rejecting process with size (" << proc_size << ") larger than maximum process size ("
-                << max_proc_size << ")" << std::endl;
-      return;
-    }
-    PCB *new_process = new PCB{pid, proc_size};
+  Status OS::NewProcess(int proc_size, size_t* pid, int nice) {
+    if (proc_size <= 0 || nice < kMinNice || nice > kMaxNice)
+      return Status::invalid_params;
+    size_t new_pid = pid_count++;
+    if (pid != nullptr) *pid = new_pid;
+    if (proc_size > max_proc_size) return Status::too_large;
+    int pages = (proc_size + page_size - 1)/page_size;
+    PCB *new_process = pool->Allocate(new_pid, proc_size, pages);
+    new_process->nice = nice;
+    new_process->arrival_time = now;
+    os_metrics.arrivals++;
+    proc_index.insert(new_pid, new_process->handle);
     DispatchProcess(new_process);
+    return Status::ok;
   }
 
   void OS::DispatchProcess(PCB* p) {
-    // if the there are enough frames for the process add it to memory
-    if (p->page_table.size() <= free_frame_list.size()) {
-      // allocate frames to process
-      for (int i = 0; i < p->page_table.size(); i++) {
-        int new_frame = free_frame_list.back();
-        free_frame_list.pop_back();
-        p->page_table[i] = new_frame;
-        frame_table[new_frame] = std::make_pair(p->pid, i);
+    // if the there are enough frames for the process add it to memory, with
+    // demand paging only its first page
+    bool admitted;
+    if (replacer) {
+      admitted = frames.free_frames() > 0;
+      if (admitted) {
+        // the process starts by touching its first page
+        tables->Create(p);
+        os_metrics.page_references++;
+        *LoadPage(p, 0) |= kPageReferenced;
+      }
+    }
+    else {
+      if (admit_frames.size() < (size_t)p->pages) admit_frames.resize(p->pages);
+      admitted = frames.AllocateFrames(p->pages, admit_frames.data(),
+                                       contiguous_frames);
+      if (admitted) {
+        tables->Create(p);
+        for (int i = 0; i < p->pages; i++) {
+          int frame = admit_frames[i];
+          frame_table[frame] = std::make_pair(p->pid, i);
+          frame_entries[frame] = tables->Map(p, i, frame);
+        }
+        os_metrics.used_frames += p->pages;
       }
+    }
+    if (admitted) {
+      AccountPageTables();
+      if (p->proc_state == PCB::job_pool)
+        os_metrics.job_pool_wait.Add(now - p->arrival_time);
 
       // give process to CPU or put in ready queue
-      if (active_process == nullptr) {
-        active_process = p;
-      }
-      else {
-        ready_queue.push_back(p);
-      }
+      MakeReady(p);
     }
     // otherwise add it to the job pool
     else {
-      input_queue.insert(p);
+      p->proc_state = PCB::job_pool;
+      job_pool.push(p);
     }
   }
 
-  int OS::TimeSliceInterrupt() {
-    std::cout << "Duration of time slice process was in the CPU: ";
-    int duration = InputWithTypeCheck<int>("Duration invalid: ");
-    while (duration < 0 || duration > time_slice_length) {
-      std::cout << "Duration must be 0-" << time_slice_length << ": ";
-      duration = InputWithTypeCheck<int>("Duration invalid: ");
+  int OS::AdmissionFrames() const {
+    // with demand paging any job fits in a single free frame
+    if (replacer) {
+      int max_pages = (max_proc_size + page_size - 1)/page_size;
+      return frames.free_frames() > 0 ? max_pages : 0;
     }
-    return duration;
+    return frames.free_frames();
   }
 
-  void OS::EndOfTimeSlice() {
-    if (active_process == nullptr) {
-      std::cerr << "No active process" << std::endl;
-      return;
+  int OS::Translate(PCB* p, int page, int core, bool write) {
+    os_metrics.translations++;
+    os_metrics.page_references++;
+    TLB* tlb = cores[core].tlb.get();
+    int frame = -1;
+    if (tlb) {
+      os_metrics.tlb_lookups++;
+      frame = tlb->Lookup(p->pid, page);
     }
-    // increment CPU time by time slice length and context switch
-    active_process->cpu_time += time_slice_length;
-    ready_queue.push_back(active_process);
-    active_process = ready_queue.front();
-    ready_queue.pop_front();
-  }
-
-  void OS::Kill(int proc_id, bool terminated) {
-    PCB* kill_proc = nullptr;
-    bool stalled = false;
-    // check CPU
-    if (active_process != nullptr && active_process->pid == proc_id) {
-      kill_proc = active_process;
-    }
-    // check ready queue
-    if (kill_proc == nullptr) {
-      for (auto itr = ready_queue.begin(); itr != ready_queue.end();) {
-        if ((*itr)->pid == proc_id) {
-          kill_proc = *itr;
-          itr = ready_queue.erase(itr);
-          break;
-        }
-        else ++itr;
-      }
+    int* entry;
+    if (frame >= 0) {
+      os_metrics.tlb_hits++;
+      entry = frame_entries[frame];
     }
-    // check device queues
-    if (kill_proc == nullptr) {
-      bool found = false;
-      for (const auto& d: devices) {
-        for (const auto& p: d->AllRequests()) {
-          if (p->pid == proc_id) {
-            kill_proc = p;
-            d->RemoveRequest(proc_id);
-            stalled = true;
-            found = true;
-            break;
-          }
-        }
-        if (found) break;
+    else {
+      // walk the page table
+      os_metrics.page_walks++;
+      entry = tables->Find(p, page, &os_metrics.walk_accesses);
+      if (entry == nullptr || (*entry & kPageValid) == 0) {
+        entry = LoadPage(p, page);
+        AccountPageTables();
       }
+      frame = *entry & kPageFrame;
+      if (tlb) tlb->Insert(p->pid, page, frame);
+    }
+    *entry |= kPageReferenced | (write ? kPageDirty : 0);
+    return frame;
+  }
+
+  int* OS::LoadPage(PCB* p, int page) {
+    int frame;
+    if (frames.AllocateFrames(1, &frame, false)) {
+      os_metrics.used_frames++;
     }
-    bool job_pool = false;
-    // check job pool
-    if (kill_proc == nullptr) {
-      for (auto itr = input_queue.begin(); itr != input_queue.end();) {
-        if ((*itr)->pid == proc_id) {
-          kill_proc = *itr;
-          itr = input_queue.erase(itr);
-          job_pool = true;
-          break;
+    else {
+      frame = replacer->Victim(frame_entries.data());
+      os_metrics.evictions++;
+      if (*frame_entries[frame] & kPageDirty) os_metrics.dirty_evictions++;
+      tables->Unmap(frame, frame_entries[frame]);
+      // no TLB may keep translating to the frame
+      if (cores[0].tlb) {
+        for (auto& c: cores) {
+          c.tlb->Invalidate(frame_table[frame].first, frame_table[frame].second);
         }
-        else ++itr;
+        os_metrics.tlb_shootdowns++;
       }
     }
-    if (kill_proc == nullptr) {
-      std::cerr << "Process with pid " << proc_id << " does not exist" << std::endl;
-      return;
+    frame_table[frame] = std::make_pair(p->pid, page);
+    int* entry = tables->Map(p, page, frame);
+    frame_entries[frame] = entry;
+    replacer->Loaded(frame);
+    p->page_faults++;
+    os_metrics.page_faults++;
+    return entry;
+  }
+
+  void OS::AccountPageTables() {
+    os_metrics.page_table_bytes = tables->footprint();
+    if (os_metrics.page_table_bytes > os_metrics.peak_page_table_bytes)
+      os_metrics.peak_page_table_bytes = os_metrics.page_table_bytes;
+  }
+
+  Status OS::EndOfTimeSlice(int core) {
+    if (!IsCore(core)) return Status::invalid_cpu;
+    PCB* active_process = cores[core].active;
+    if (active_process == nullptr) return Status::no_active_process;
+    // increment CPU time by time slice length and context switch
+    active_process->cpu_time += active_process->slice;
+    ChargeCPU(active_process->slice, core);
+    int level = active_process->priority;
+    cores[core].run_queue->Expired(active_process);
+    if (active_process->priority > level) os_metrics.levels[level].demotions++;
+    Enqueue(active_process, core);
+    ScheduleNext(core);
+    return Status::ok;
+  }
+
+  Status OS::Kill(int proc_id, bool terminated, ProcessStats* stats) {
+    PCBHandle found = proc_index.find(proc_id);
+    if (found == kNullHandle) return Status::no_such_process;
+    PCB* kill_proc = pool->get(found);
+    proc_index.erase(proc_id);
+
+    // remove process from wherever it is
+    bool stalled = false;
+    bool in_job_pool = false;
+    switch (kill_proc->proc_state) {
+      case PCB::active:  // context switch to next process in the run queue
+        ScheduleNext(kill_proc->core);
+        break;
+      case PCB::ready:
+        SettleQueue(kill_proc->core);
+        cores[kill_proc->core].run_queue->Remove(kill_proc);
+        break;
+      case PCB::waiting:
+        devices[kill_proc->device]->RemoveRequest(kill_proc);
+        SettleDevice(kill_proc->device);
+        os_metrics.devices[kill_proc->device].queued--;
+        stalled = true;
+        break;
+      case PCB::job_pool:
+        job_pool.erase(kill_proc);
+        in_job_pool = true;
+        break;
     }
 
     // accounting info
@@ -299,119 +605,131 @@ namespace os_ops {
     }
     if (terminated) {
       num_of_completed++;
-    }
-    float avg_burst_time = (kill_proc->bursts == 0) ? 0 : kill_proc->cpu_time/kill_proc->bursts;
-    std::cout << "Process " << kill_proc->pid << " terminated. ";
-    std::cout << "Total CPU time: " << kill_proc->cpu_time
-              << ", avg. burst time: " << avg_burst_time << std::endl;
-
-    // free frames and add back to free frame list if process not in job pool
-    if (!job_pool) {
-      for (int i = 0; i < kill_proc->page_table.size(); i++) {
-        int freed_frame = kill_proc->page_table[i];
-        free_frame_list.push_back(freed_frame);
-        frame_table[freed_frame] = std::make_pair(-1,-1);
+      os_metrics.completed++;
+      os_metrics.turnaround.Add(now - kill_proc->arrival_time);
+      // share of the time it could run that it ran, relative to its weight
+      double running = (double)kill_proc->cpu_time*kMillisecond;
+      if (running + kill_proc->ready_time > 0)
+        os_metrics.AddShare(running/(running + kill_proc->ready_time)*
+                            1024/NiceWeight(kill_proc->nice));
+    }
+    else os_metrics.killed++;
+    if (stats != nullptr) {
+      *stats = ProcessStats{kill_proc->pid, kill_proc->cpu_time,
+                            kill_proc->bursts, kill_proc->page_faults};
+    }
+
+    // free frames if process not in job pool
+    if (!in_job_pool) {
+      for (int i = 0; i < kill_proc->pages; i++) {
+        int* entry = tables->Find(kill_proc, i);
+        if (entry == nullptr || (*entry & kPageValid) == 0) continue;
+        int frame = *entry & kPageFrame;
+        frames.FreeFrames(&frame, 1);
+        os_metrics.used_frames--;
+        tables->Unmap(frame, entry);
+        frame_table[frame] = std::make_pair(-1,-1);
+        frame_entries[frame] = nullptr;
+        if (replacer) replacer->Freed(frame);
       }
+      tables->Destroy(kill_proc);
+      AccountPageTables();
+      os_metrics.process_faults.Add(kill_proc->page_faults);
     }
-    delete kill_proc;  // reclaim PCB memory
+    pool->Release(kill_proc);  // reclaim PCB memory
 
-    // add largest processes that can fit in free memory from job pool
-    for (auto itr = input_queue.begin(); itr != input_queue.end();) {
-      if ((*itr)->page_table.size() <= free_frame_list.size()) {
-        DispatchProcess(*itr);
-        itr = input_queue.erase(itr);
-      }
-      else ++itr;
+    // add largest processes that can fit in free memory from job pool until
+    // nothing else fits
+    PCB* admit;
+    while ((admit = job_pool.LargestFitting(AdmissionFrames())) != nullptr) {
+      job_pool.erase(admit);
+      DispatchProcess(admit);
     }
+    return Status::ok;
   }
 
-  void OS::TerminateActiveProcess() {
-    if (active_process == nullptr) {
-      std::cerr << "No active process to terminate" << std::endl;
-      return;
-    }
-    active_process->cpu_time += TimeSliceInterrupt();
-    Kill(active_process->pid, true);
-    if (ready_queue.size() > 0) {
-      active_process = ready_queue.front();
-      ready_queue.pop_front();
-    }
-    else
-      active_process = nullptr;
+  Status OS::TerminateActiveProcess(int burst, ProcessStats* stats, int core) {
+    Status status = TimeSliceInterrupt(burst, core);
+    if (status != Status::ok) return status;
+    return Kill(cores[core].active->pid, true, stats);
   }
 
-  void OS::Snapshot() const {
-    std::cout << "Show r/p/d/c/m/j: ";
-    char snap_type = InputWithTypeCheck<char>("Invalid snapshot type (r/p/d/c)");
-    while (snap_type != 'r' && snap_type != 'p' && snap_type != 'd' &&
-           snap_type != 'c' && snap_type != 'm' && snap_type != 'j') {
-      std::cout << "Invalid, not r/p/d/c" << std::endl;
-      snap_type = InputWithTypeCheck<char>("Invalid snapshot type (r/p/d/c/m/j)");
-    }
-    std::cin.ignore(std::numeric_limits<std::streamsize>::max(),'\n');
+  Status OS::Snapshot(char snap_type, std::ostream& out, int page_lines) const {
+    if (snap_type != 'r' && snap_type != 'p' && snap_type != 'd' &&
+        snap_type != 'c' && snap_type != 'm' && snap_type != 'j')
+      return Status::invalid_params;
 
     int lines_printed = 0;
     if (snap_type != 'm' && snap_type != 'j') {
       float avg_CPU_time = (num_of_completed == 0) ? 0 : CPU_time_sum/num_of_completed;
-      std::cout << "Average CPU time of completed processes: "
-                << avg_CPU_time << std::endl;
+      out << "Average CPU time of completed processes: "
+          << avg_CPU_time << std::endl;
       lines_printed++;
-      std::cout << std::setw(5) <<  std::left << "PID"
-                << std::setw(10) << std::left << "Filename"
-                << std::setw(9) << std::left << "Logical"
-                << std::setw(10) << std::left << "Physical"
-                << std::setw(5) <<  std::left << "r/w"
-                << std::setw(9) << std::left << "Filelen"
-                << std::setw(11) << std::left << "Cylinder#"
-                << std::setw(10) << std::left << "CPU time"
-                << std::setw(9) <<  std::left << "Avg burst" << std::endl;
+      out << std::setw(5) <<  std::left << "PID"
+          << std::setw(10) << std::left << "Filename"
+          << std::setw(9) << std::left << "Logical"
+          << std::setw(10) << std::left << "Physical"
+          << std::setw(5) <<  std::left << "r/w"
+          << std::setw(9) << std::left << "Filelen"
+          << std::setw(11) << std::left << "Cylinder#"
+          << std::setw(10) << std::left << "CPU time"
+          << std::setw(9) <<  std::left << "Avg burst" << std::endl;
       lines_printed++;
     }
     if (snap_type == 'r') {  // ready queue id == 4
-      std::cout << "-----Ready queue-----" << std::endl;
-      lines_printed++;
-      PrintStatus(ready_queue, false, lines_printed);
+      for (size_t c = 0; c < cores.size(); c++) {
+        CheckLines(out, lines_printed, page_lines);
+        if (cores.size() == 1) out << "-----Ready queue-----" << std::endl;
+        else out << "-----Ready queue of CPU " << c << "-----" << std::endl;
+        lines_printed++;
+        cores[c].run_queue->ForEachReady([&](PCB* pcb) {
+          PrintProcess(pcb, false, out, lines_printed, page_lines);
+        });
+      }
     }
     else if (snap_type == 'j')  {  // input queue id == 5
-      std::cout << "-----Job pool-----" << std::endl;
+      out << "-----Job pool-----" << std::endl;
       lines_printed++;
-      std::cout << std::setw(6) << std::left << "PID"
-                << std::setw(73) << std::left << "Size"
-                << std::endl;
-      for (const auto& pcb: input_queue) {
-        CheckLines(lines_printed);
-        std::cout << std::setw(6) << std::left << pcb->pid;
-        std::cout << std::setw(73) << std::left << pcb->size;
-        std::cout << std::endl;
+      out << std::setw(6) << std::left << "PID"
+          << std::setw(73) << std::left << "Size"
+          << std::endl;
+      job_pool.ForEach([&](const PCB* pcb) {
+        CheckLines(out, lines_printed, page_lines);
+        out << std::setw(6) << std::left << pcb->pid;
+        out << std::setw(73) << std::left << pcb->size;
+        out << std::endl;
         lines_printed++;
-      }
+      });
     }
     else if (snap_type == 'm') {
-      std::cout << "Free frame list: ";
-      std::string free_frames;
-      for (const auto& frame: free_frame_list) {
-        std::cout << frame << " ";
-      }
-      std::cout << std::endl;
+      out << "Free frame list: ";
+      frames.ForEachFree([&out](int frame) {out << frame << " ";});
+      out << std::endl;
+      lines_printed++;
+      CheckLines(out, lines_printed, page_lines);
+      FreeRunStats runs = frames.RunStats();
+      out << "Free frames: " << runs.free_frames << ", free runs: " << runs.runs
+          << ", largest run: " << runs.largest_run
+          << ", fragmentation: " << runs.fragmentation() << std::endl;
       lines_printed++;
-      CheckLines(lines_printed);
-      std::cout << "-----Frame table----" << std::endl;
+      CheckLines(out, lines_printed, page_lines);
+      out << "-----Frame table----" << std::endl;
       lines_printed++;
-      CheckLines(lines_printed);
-      std::cout << std::setw(13) << std::left << "Frame num"
-                << std::setw(33) << std::left << "PID"
-                << std::setw(33) << std::left << "Page num"
-                << std::endl;
+      CheckLines(out, lines_printed, page_lines);
+      out << std::setw(13) << std::left << "Frame num"
+          << std::setw(33) << std::left << "PID"
+          << std::setw(33) << std::left << "Page num"
+          << std::endl;
       lines_printed++;
-      CheckLines(lines_printed);
-      for (int i = 0; i < frame_table.size(); i++) {
-        CheckLines(lines_printed);
+      CheckLines(out, lines_printed, page_lines);
+      for (size_t i = 0; i < frame_table.size(); i++) {
+        CheckLines(out, lines_printed, page_lines);
         std::string pid = frame_table[i].first == -1 ? "-" : std::to_string(frame_table[i].first);
         std::string page = frame_table[i].second == -1 ? "-" : std::to_string(frame_table[i].second);
-        std::cout << std::setw(13) << std::left << i
-                  << std::setw(33) << std::left << pid
-                  << std::setw(33) << std::left << page
-                  << std::endl;
+        out << std::setw(13) << std::left << i
+            << std::setw(33) << std::left << pid
+            << std::setw(33) << std::left << page
+            << std::endl;
         lines_printed++;
       }
     }
@@ -429,121 +747,161 @@ namespace os_ops {
         start = cd_num + disk_num;
       }
       for (int i = start; i < end; i++) {
-        std::cout << "-----" << snap_type << (i+1)-start << "-----" << std::endl;
+        out << "-----" << snap_type << (i+1)-start << "-----" << std::endl;
         lines_printed++;
-        PrintStatus(devices[i]->AllRequests(), true, lines_printed);
+        if (snap_type == 'd') {
+          const DiskStats& stats = static_cast<const Disk*>(devices[i])->stats();
+          CheckLines(out, lines_printed, page_lines);
+          out << "Policy: "
+              << PolicyName(static_cast<const Disk*>(devices[i])->get_policy())
+              << ", seek distance: " << stats.seek_distance
+              << ", serviced: " << stats.serviced
+              << ", mean wait: " << stats.mean_wait()
+              << ", max wait: " << stats.max_wait << std::endl;
+          lines_printed++;
+        }
+        devices[i]->ForEachRequest([&](PCB* pcb) {
+          PrintProcess(pcb, true, out, lines_printed, page_lines);
+        });
       }
     }
+    return Status::ok;
   }
 
-  void OS::PrintStatus(const std::deque<PCB*>& req_queue, bool print_props,
-                       int& lines_printed) const {
-    for (const auto& pcb: req_queue) {
-      CheckLines(lines_printed);
-      std::cout << std::setw(5) << std::left << pcb->pid;
-      float avg_burst_time = (pcb->bursts == 0) ? 0 : pcb->cpu_time/pcb->bursts;
-      if (print_props) {
-        std::string file_size_out = (pcb->op == 'r') ? "-" : std::to_string(pcb->file_size);
-        std::string cylinder_num = (pcb->cylinder_num < 0) ? "-" : std::to_string(pcb->cylinder_num);
-        std::cout << std::setw(10) << std::left << pcb->file_name
-                  << std::setw(9) << std::left << std::hex << pcb->start_mem_loc
-                  << std::setw(10) << std::left << std::hex << pcb->physical_loc
-                  << std::setw(5) <<  std::left << pcb->op
-                  << std::setw(9) << std::left << file_size_out
-                  << std::setw(11) << std::left << cylinder_num
-                  << std::setw(10) << std::left << pcb->cpu_time
-                  << std::setw(9) <<  std::left << avg_burst_time;
-      }
-      else {
-        std::cout << std::setw(55) << " "
-                  << std::setw(10) << std::left << pcb->cpu_time
-                  << std::setw(9)  << std::left << avg_burst_time;
-      }
-      std::cout << std::endl;
-      lines_printed++;
-      CheckLines(lines_printed);
-      std::cout << "Page table: ";
-      lines_printed++;
-      CheckLines(lines_printed);
-      for (const auto& page: pcb->page_table) {
-        std::cout << page << " ";
-      }
-      std::cout << std::endl;
-      lines_printed++;
+  void OS::PrintProcess(const PCB* pcb, bool print_props, std::ostream& out,
+                        int& lines_printed, int page_lines) const {
+    CheckLines(out, lines_printed, page_lines);
+    out << std::setw(5) << std::left << pcb->pid;
+    float avg_burst_time = (pcb->bursts == 0) ? 0 : pcb->cpu_time/pcb->bursts;
+    if (print_props) {
+      std::string file_size_out = (pcb->op == 'r') ? "-" : std::to_string(pcb->file_size);
+      std::string cylinder_num = (pcb->cylinder_num < 0) ? "-" : std::to_string(pcb->cylinder_num);
+      out << std::setw(10) << std::left << pcb->file_name
+          << std::setw(9) << std::left << std::hex << pcb->start_mem_loc
+          << std::setw(10) << std::left << std::hex << pcb->physical_loc
+          << std::dec
+          << std::setw(5) <<  std::left << pcb->op
+          << std::setw(9) << std::left << file_size_out
+          << std::setw(11) << std::left << cylinder_num
+          << std::setw(10) << std::left << pcb->cpu_time
+          << std::setw(9) <<  std::left << avg_burst_time;
     }
+    else {
+      out << std::setw(55) << " "
+          << std::setw(10) << std::left << pcb->cpu_time
+          << std::setw(9)  << std::left << avg_burst_time;
+    }
+    out << std::endl;
+    lines_printed++;
+    CheckLines(out, lines_printed, page_lines);
+    out << "Page table: ";
+    lines_printed++;
+    CheckLines(out, lines_printed, page_lines);
+    for (int i = 0; i < pcb->pages; i++) {
+      const int* entry = tables->Find(pcb, i);
+      if (entry != nullptr && (*entry & kPageValid))
+        out << (*entry & kPageFrame) << " ";
+      else out << "- ";
+    }
+    out << std::endl;
+    lines_printed++;
   }
 
-  void OS::CheckLines(int& lines_printed) const {
-    if (lines_printed >= 22) {
-      std::cout << "Press ENTER to continue output";
-      std::cin.ignore(std::numeric_limits<std::streamsize>::max(),'\n');
-      lines_printed = 0;
-    }
+  void OS::Save(CheckpointWriter& out) const {
+    out.Put<uint64_t>(pid_count);
+    out.Put(CPU_time_sum);
+    out.Put<int32_t>(num_of_completed);
+    out.Put(next_boost);
+    out.Put(now);
+    out.Put<uint8_t>(external_clock);
+
+    pool->Save(out);
+    proc_index.Save(out);
+    // page tables of the processes in memory
+    uint64_t num_of_tables = 0;
+    proc_index.ForEach([&](size_t pid, PCBHandle handle) {
+      if (pool->get(handle)->proc_state != PCB::job_pool) num_of_tables++;
+    });
+    out.Put(num_of_tables);
+    proc_index.ForEach([&](size_t pid, PCBHandle handle) {
+      const PCB* p = pool->get(handle);
+      if (p->proc_state == PCB::job_pool) return;
+      out.Put(handle);
+      tables->SaveTable(p, out);
+    });
+    tables->Save(out);
+
+    frames.Save(out);
+    out.Put<uint64_t>(frame_table.size());
+    out.Write(frame_table.data(), frame_table.size()*sizeof(frame_table[0]));
+    if (replacer) replacer->Save(out);
+    job_pool.Save(out);
+
+    for (const auto& c: cores) {
+      out.Put(c.active == nullptr ? kNullHandle : c.active->handle);
+      out.Put<uint64_t>(c.tlb_pid);
+      c.run_queue->Save(out);
+      if (c.tlb) c.tlb->Save(out);
+    }
+    for (const Device* device: devices) device->Save(out);
+    os_metrics.Save(out);
   }
 
-  OS Sysgen() {
-    std::cout << "SYSGEN" << std::endl;
-    std::cout << "Num of printer devices: ";
-    int printer_num = InputWithTypeCheck<int>("Invalid number of printers");
-    while (printer_num < 0) {
-      std::cout << "Number of printers must be >= 0: ";
-      printer_num = InputWithTypeCheck<int>("Invalid number of printers");
-    }
-
-    std::cout << "Num of disk devices: ";
-    int disk_num = InputWithTypeCheck<int>("Invalid number of disk devices");
-    while (disk_num < 0) {
-      std::cout << "Number of disk devices must be >= 0: ";
-      disk_num = InputWithTypeCheck<int>("Invalid number of disk devices");
-    }
-    std::vector<int> cyl_nums;
-    for (int i = 0; i < disk_num; i++) {
-      std::cout << "Num of disk " << i+1 << " cylinders: ";
-      int num_of_cylinders = InputWithTypeCheck<int>("Invalid number of cylinders");
-      while (num_of_cylinders < 0) {
-        std::cout << "Number of cylinders must be >= 0: ";
-        num_of_cylinders = InputWithTypeCheck<int>("Invalid number of cylinders");
-      }
-      cyl_nums.push_back(num_of_cylinders);
-    }
-
-    std::cout << "Num of cd-rw devices: ";
-    int cd_num = InputWithTypeCheck<int>("Invalid number of cd-rw devices");
-    while (cd_num < 0) {
-      std::cout << "Number of cd-rw devices must be >= 0: ";
-      cd_num = InputWithTypeCheck<int>("Invalid number of cd-rw devices");
-    }
-
-    std::cout << "Length of time slice (ms): ";
-    int time_slice = InputWithTypeCheck<int>("Invalid time slice length");
-    while (time_slice <= 0) {
-      std::cout << "Length of time slice must be > 0: ";
-      cd_num = InputWithTypeCheck<int>("Invalid time slice length");
-    }
-
-    std::cout << "Page size: ";
-    int page_size = InputWithTypeCheck<int>("Invalid page size");
-    while (page_size <= 0 || (page_size & (~page_size+1)) != page_size) {
-      std::cout << "Page size must be > 0 and a power of 2: ";
-      page_size = InputWithTypeCheck<int>("Invalid page size");
-    }
-
-    std::cout << "Size of memory: ";
-    int memory_size = InputWithTypeCheck<int>("Invalid memory size");
-    while (memory_size <= 0 || memory_size % page_size != 0) {
-      std::cout << "Memory size must be > 0 and multiple of page size: ";
-      memory_size = InputWithTypeCheck<int>("Invalid memory size");
-    }
+  bool OS::Restore(CheckpointReader& in) {
+    pid_count = in.Get<uint64_t>();
+    CPU_time_sum = in.Get<float>();
+    num_of_completed = in.Get<int32_t>();
+    next_boost = in.Get<SimTime>();
+    now = in.Get<SimTime>();
+    external_clock = in.Get<uint8_t>();
+
+    pool->Restore(in);
+    proc_index.Restore(in);
+    if (!in.ok()) return false;
+    uint64_t num_of_tables = in.Get<uint64_t>();
+    for (uint64_t i = 0; i < num_of_tables && in.ok(); i++) {
+      PCB* p = pool->ReadPCB(in);
+      if (p == nullptr || p->page_table != nullptr) return false;
+      tables->RestoreTable(p, in);
+    }
+    tables->Restore(in);
+
+    frames.Restore(in);
+    if (in.Get<uint64_t>() != frame_table.size()) return false;
+    in.Read(frame_table.data(), frame_table.size()*sizeof(frame_table[0]));
+    if (replacer) replacer->Restore(in);
+    job_pool.Restore(in);
+    if (!in.ok()) return false;
+
+    for (auto& c: cores) {
+      c.active = pool->ReadPCB(in);
+      c.tlb_pid = in.Get<uint64_t>();
+      c.run_queue->Restore(in);
+      if (c.tlb) c.tlb->Restore(in);
+    }
+    for (Device* device: devices) device->Restore(in, pool.get());
+    os_metrics.Restore(in);
+    if (!in.ok()) return false;
+
+    // entries of the loaded pages, now in the restored page tables
+    for (size_t frame = 0; frame < frame_table.size(); frame++) {
+      if (frame_table[frame].first < 0) continue;
+      PCBHandle handle = proc_index.find(frame_table[frame].first);
+      if (handle == kNullHandle) return false;
+      frame_entries[frame] = tables->Find(pool->get(handle),
+                                          frame_table[frame].second);
+      if (frame_entries[frame] == nullptr) return false;
+    }
+    return true;
+  }
 
-    std::cout << "Max process size: ";
-    int max_proc_size = InputWithTypeCheck<int>("Invalid max process size");
-    while (max_proc_size <= 0 || max_proc_size > memory_size) {
-      std::cout << "Max process size must be > 0 and <= " << memory_size << ": ";
-      max_proc_size = InputWithTypeCheck<int>("Invalid max process size");
+  void OS::CheckLines(std::ostream& out, int& lines_printed,
+                      int page_lines) const {
+    if (page_lines > 0 && lines_printed >= page_lines) {
+      out << "Press ENTER to continue output";
+      std::cin.ignore(std::numeric_limits<std::streamsize>::max(),'\n');
+      lines_printed = 0;
     }
-
-    return OS{printer_num, disk_num, cd_num, time_slice, cyl_nums,
-              page_size, memory_size, max_proc_size};
   }
 
 }
@@ -10,44 +10,130 @@
 #include <string>
 #include <vector>
 #include <deque>
-#include <set>
+#include <memory>
 #include <utility>
 
 #include "pcb.h"
+#include "pcb_pool.h"
 #include "device.h"
+#include "cpu_scheduler.h"
+#include "frame_allocator.h"
+#include "page_replacement.h"
+#include "page_table.h"
+#include "tlb.h"
+#include "metrics.h"
 
 namespace os_ops {
 
+// Result of an OS operation
+enum class Status {ok, no_active_process, invalid_device, invalid_params,
+                   queue_empty, too_large, no_such_process, invalid_cpu};
+
+// Human readable description of status
+const char* StatusMessage(Status status);
+
+// I/O parameters of a request. file_name must stay valid during the call.
+struct IOParams {
+  const char* file_name;  // max 20 characters
+  int start_mem_loc;      // logical address, 0 <= start_mem_loc < process size
+  char op;                // r/w, printers only write
+  int cylinder;           // disks only, 0 <= cylinder < num_of_cylinders
+  int file_size;          // writes only, > 0
+};
+
+// Accounting info of a terminated process
+struct ProcessStats {
+  size_t pid;
+  float cpu_time;
+  int bursts;
+  int page_faults;
+};
+
+// Sysgen parameters of an OS
+struct SysgenParams {
+  int printer_num, disk_num, cd_num;
+  std::vector<int> cyl_nums;  // one per disk
+  std::vector<DiskPolicy> disk_policies;  // one per disk, FSCAN if empty
+  int time_slice;             // ms
+  int page_size, mem_size, max_proc_size;
+  bool contiguous_frames;  // give processes contiguous frames when possible
+  int cpu_num;             // >= 1
+  bool cpu_affinity;       // return processes to the CPU they last ran on
+  // demand paging with this policy, all pages loaded at admission if none
+  ReplacementPolicy page_replacement;
+  TLBParams tlb;           // TLB of every CPU, none if tlb.entries == 0
+  PageTableKind page_tables;  // organization of the page tables
+  SchedulerParams scheduler;  // run queues of every CPU
+  // service times of the devices, left to the caller if not enabled
+  DeviceTimings device_timings;
+};
+
+// Most disks of an OS
+const int kMaxDisks = 1 << 20;
+
+// Check params against the rules Sysgen enforces. Returns false and stores
+// the violated rule in error if params are invalid.
+bool ValidSysgen(const SysgenParams& params, std::string* error);
+
 // Basic OS class for managing processes
 class OS {
   public:
-    OS(int num_of_printers, int num_of_disks, int num_of_cd_drives,
-       int time_slice, const std::vector<int>& cyl_nums,
-       int process_page_size, int memory_size, int max_process_size) :
-        printer_num{num_of_printers}, disk_num{num_of_disks},
-        cd_num{num_of_cd_drives}, active_process{nullptr},
-        time_slice_length{time_slice}, page_size{process_page_size},
-        mem_size{memory_size}, max_proc_size{max_process_size},
-        frame_table{(size_t)mem_size/page_size, std::make_pair(-1,-1)} {
-      // add all frames to free frame list
-      for (int i = 0; i < mem_size/page_size; i++) {
-        free_frame_list.push_back(i);
+    explicit OS(const SysgenParams& params) :
+        config(params),
+        time_slice_length{params.time_slice},
+        boost_interval{params.scheduler.boost_interval},
+        affinity{params.cpu_affinity},
+        printer_num{params.printer_num}, disk_num{params.disk_num},
+        cd_num{params.cd_num}, page_size{params.page_size},
+        mem_size{params.mem_size}, max_proc_size{params.max_proc_size},
+        contiguous_frames{params.contiguous_frames},
+        timings(params.device_timings),
+        frames{mem_size/page_size},
+        frame_table{(size_t)mem_size/page_size, std::make_pair(-1,-1)},
+        replacement{params.page_replacement},
+        replacer{PageReplacer::make_replacer(params.page_replacement,
+                                             mem_size/page_size)},
+        pool{new PCBPool},
+        tables{PageTables::make_page_tables(
+            params.page_tables, pool.get(),
+            (max_proc_size + page_size - 1)/page_size, frame_table)},
+        job_pool{pool.get()} {
+      // create CPUs and devices
+      for (int i = 0; i < params.cpu_num; i++) {
+        cores.emplace_back(pool.get(), params.tlb, params.scheduler,
+                           params.time_slice);
+        os_metrics.cores.push_back(CoreMetrics{});
       }
-
-      PCB::page_size = page_size;  // set page size for all PCBs
-
-      // create devices
+      if (params.scheduler.policy == CPUPolicy::mlfq) {
+        os_metrics.levels.resize(params.scheduler.levels);
+        for (int l = 0; l < params.scheduler.levels; l++)
+          os_metrics.levels[l].quantum = params.time_slice << l;
+      }
+      next_boost = boost_interval*kMillisecond;
       for (int i = 0; i < cd_num; i++) {
-        devices.push_back(Device::make_device('c'));
+        devices.push_back(Device::make_device('c', pool.get()));
       }
       for (int i = 0; i < disk_num; i++) {
-        Device* new_device = Device::make_device('d');
+        Device* new_device = Device::make_device('d', pool.get());
         Disk* new_disk = static_cast<Disk*>(new_device);
-        new_disk->num_of_cylinders = cyl_nums[i];
+        new_disk->num_of_cylinders = params.cyl_nums[i];
+        if (!params.disk_policies.empty())
+          new_disk->set_policy(params.disk_policies[i]);
         devices.push_back(new_disk);
       }
       for (int i = 0; i < printer_num; i++) {
-        devices.push_back(Device::make_device('p'));
+        devices.push_back(Device::make_device('p', pool.get()));
+      }
+      os_metrics.frames = frames.size();
+      frame_entries.assign(frames.size(), nullptr);
+      const int counts[] = {cd_num, disk_num, printer_num};
+      for (int t = 0; t < 3; t++) {
+        for (int i = 1; i <= counts[t]; i++) {
+          DeviceMetrics d;
+          d.type = "cdp"[t];
+          d.num = i;
+          os_metrics.devices.push_back(d);
+        }
       }
     }
     ~OS();
@@ -63,38 +149,120 @@ class OS {
     size_t get_disk_num() const {return disk_num;}
     size_t get_cd_num() const {return cd_num;}
 
-    // Remove active process from CPU and add it to device queue of device_type.
-    // Request I/O parameters from process.
-    void IORequest(char device_type, int device_num);
+    int cpu_num() const {return cores.size();}
+    // Process currently on CPU core (0-based, nullptr if idle)
+    const PCB* active(int core = 0) const {return cores[core].active;}
+    // Time slice of the highest priority processes in ms
+    int time_slice() const {return time_slice_length;}
+    // Time slice of the process on CPU core in ms, 0 if it is idle
+    int quantum(int core = 0) const {
+      return cores[core].active ? cores[core].active->slice : 0;
+    }
+    int get_page_size() const {return page_size;}
+    int max_process_size() const {return max_proc_size;}
+    size_t next_pid() const {return pid_count;}
+    int completed() const {return num_of_completed;}
+    // Number of cylinders of disk disk_num (1-based), -1 if no such disk
+    int disk_cylinders(int disk_num) const;
+    // Disk disk_num (1-based), nullptr if no such disk
+    const Disk* disk(int disk_num) const;
+    // Index of device device_num (1-based) of device_type (c/d/p or C/D/P)
+    // in the order cd/rws, disks, printers, -1 if no such device
+    int DeviceIndex(char device_type, int device_num) const;
+    const FrameAllocator& frame_allocator() const {return frames;}
+    ReplacementPolicy page_replacement() const {return replacement;}
+    const DeviceTimings& device_timings() const {return timings;}
+    // Sysgen parameters the OS was created with
+    const SysgenParams& sysgen() const {return config;}
+    const Metrics& metrics() const {
+      SettleDepths();
+      return os_metrics;
+    }
+
+    // OS clock metrics are measured on, in microseconds
+    SimTime clock() const {return now;}
+    // Move the clock forward to time (e.g. simulation time). Until the first
+    // call the clock advances by the CPU time charged to processes.
+    void AdvanceClock(SimTime time);
+
+    // Charge duration ms (at most its quantum) of CPU time to the active
+    // process of CPU core (system call or termination before the end of its
+    // time slice).
+    Status TimeSliceInterrupt(int duration, int core = 0);
+
+    // Remove active process from CPU core and add it to device queue of
+    // device_type after it ran for burst ms. Physical address of the request
+    // is stored in physical_loc if given.
+    Status IORequest(char device_type, int device_num, int burst,
+                     const IOParams& params, size_t* physical_loc = nullptr,
+                     int core = 0);
 
     // Pop first process from device queue of device_type and add it to the
-    // ready queue (I/O request completed).
-    void HandleInterrupt(char device_type, int device_num);
+    // run queue of CPU core, which takes the interrupt (I/O request
+    // completed). With affinity the process returns to the CPU it last ran
+    // on instead, core < 0 picks the least loaded CPU. Its pid is stored in
+    // pid if given.
+    Status HandleInterrupt(char device_type, int device_num,
+                           size_t* pid = nullptr, int core = -1);
+
+    // Start servicing the next request of device_type (c/d/p) device_num,
+    // which the next interrupt of the device completes, and store the time
+    // the device timings give it in duration if given (0 without timings).
+    // Call it once per request, before the interrupt completing it.
+    Status StartService(char device_type, int device_num,
+                        SimTime* duration = nullptr);
 
-    // Ask for duration of time slice process was in CPU until system call.
-    // Return duration.
-    int TimeSliceInterrupt();
+    // Add new process of proc_size with nice value nice (kMinNice to
+    // kMaxNice) to the run queue of the least loaded CPU. Its pid is stored
+    // in pid if given (a pid is used up even if the process is too large).
+    Status NewProcess(int proc_size, size_t* pid = nullptr, int nice = 0);
 
-    // Add new process to the ready queue.
-    void NewProcess();
+    // Remove active process from CPU core after it used its whole time slice
+    // and put it back in the core's run queue (at the back for round robin,
+    // a level down for multilevel queues).
+    Status EndOfTimeSlice(int core = 0);
 
-    // Remove active process from the CPU and push it to the back of the ready
-    // queue (round robin).
-    void EndOfTimeSlice();
+    // Kill process with pid == proc_id. Accounting info of the killed process
+    // is stored in stats if given.
+    Status Kill(int proc_id, bool terminated = false,
+                ProcessStats* stats = nullptr);
 
-    // Kill process with pid == proc_id
-    void Kill(int proc_id, bool terminated=false);
+    // Remove active process from CPU core after it ran for burst ms and free
+    // its PCB memory.
+    Status TerminateActiveProcess(int burst, ProcessStats* stats = nullptr,
+                                  int core = 0);
 
-    // Remove active process from the CPU and free its PCB memory.
-    void TerminateActiveProcess();
+    // Write the complete state of the OS: processes with their page tables,
+    // run, device and job queues, memory, clock, counters and metrics.
+    void Save(CheckpointWriter& out) const;
+    // Restore what Save wrote into a new OS created with the same Sysgen
+    // parameters. Returns false if the state does not fit this OS, which
+    // must then be discarded.
+    bool Restore(CheckpointReader& in);
 
-    // Print contents of device queues or ready queue.
-    void Snapshot() const;
+    // Print contents of device queues, run queues (r/p/d/c), frame table (m)
+    // or job pool (j) to out. Pause for ENTER every page_lines lines if
+    // page_lines > 0.
+    Status Snapshot(char snap_type, std::ostream& out, int page_lines = 0) const;
 
   private:
-    //CPU
-    PCB* active_process;
+    //CPUs, each with the process it runs, its own run queue and its TLB
+    struct Core {
+      PCB* active = nullptr;
+      std::unique_ptr<RunQueue> run_queue;
+      std::unique_ptr<TLB> tlb;
+      size_t tlb_pid = SIZE_MAX;  // process the TLB was last used by
+      Core(const PCBPool* pool, const TLBParams& tlb_params,
+           const SchedulerParams& scheduler, int time_slice) :
+          run_queue{RunQueue::make_run_queue(scheduler, time_slice, pool)},
+          tlb{tlb_params.entries > 0 ? new TLB{tlb_params} : nullptr} {}
+    };
+    SysgenParams config;
+    std::vector<Core> cores;
     int time_slice_length;
+    int boost_interval;       // ms, no priority boosts if 0
+    SimTime next_boost = 0;
+    bool affinity;
     float CPU_time_sum = 0;
     int num_of_completed = 0;
 
@@ -102,38 +270,96 @@ class OS {
     int printer_num, disk_num, cd_num;
 
     int page_size, mem_size, max_proc_size;
-    std::vector<int> free_frame_list;
+    bool contiguous_frames;
+    DeviceTimings timings;
+    FrameAllocator frames;
     std::vector<std::pair<int,int>> frame_table;  // pair of (pid, page #)
+    // demand paging: replacement policy, none if all pages are loaded at
+    // admission
+    ReplacementPolicy replacement;
+    std::unique_ptr<PageReplacer> replacer;
+    // page table entry of the page in each frame (nullptr if free)
+    std::vector<int*> frame_entries;
 
     // all devices are stored in one array in order cd/rw->disks->printers
     std::vector<Device*> devices;
-    std::deque<PCB*> ready_queue;
+    // all PCBs, heap allocated so queues keep a stable pointer to it
+    std::unique_ptr<PCBPool> pool;
+    // page tables of all processes in memory
+    std::unique_ptr<PageTables> tables;
+    // frames of a process being admitted without demand paging, grown to the
+    // largest process admission was tried for
+    std::vector<int> admit_frames;
 
-    // store job pool in set ordered by process size so iteration
-    // from largest to smallest is fast
-    struct LargerSize {
-      bool operator()(const PCB* p1, const PCB* p2) const {
-        return p2->size < p1->size;
-      }
-    };
-    std::multiset<PCB*, LargerSize> input_queue;
+    // processes waiting for frames, admitted largest first
+    JobPool job_pool;
+
+    // every live process by pid, PCB::proc_state tells where it is
+    PidIndex proc_index;
+
+    SimTime now = 0;
+    bool external_clock = false;
+    // mutable since the queue depth integrals are brought up to the clock
+    // when read
+    mutable Metrics os_metrics;
+
+    // Move clock to time, accumulating time weighted metrics
+    void SetClock(SimTime time);
+    // Whether core is the number of a CPU
+    bool IsCore(int core) const {
+      return core >= 0 && static_cast<size_t>(core) < cores.size();
+    }
+    // Integrate the depths of the run queue of core, or of the device at
+    // index, up to the clock. Called before they change.
+    void SettleQueue(int core) const;
+    void SettleDevice(int index) const;
+    // Integrate the depths of all queues up to the clock
+    void SettleDepths() const;
+    // Account duration ms of CPU time of core
+    void ChargeCPU(int duration, int core);
+
+    // Put p on CPU core (nullptr for idle)
+    void SetActive(int core, PCB* p);
+
+    // Give p to CPU core, with affinity to the CPU it last ran on, or if
+    // core < 0 to the least loaded CPU. p runs right away if the CPU is idle,
+    // otherwise it is put in the CPU's run queue and idle CPUs steal work.
+    void MakeReady(PCB* p, int core = -1);
+
+    // Move the next process of the run queue of core to the CPU. An empty
+    // run queue steals from the longest run queue.
+    void ScheduleNext(int core);
+    // Move every ready process to the top priority level if a boost is due
+    void BoostPriorities();
+    // Put p in the run queue of core
+    void Enqueue(PCB* p, int core);
+
+    // Idle CPU, or the one with the shortest run queue
+    int LeastLoaded() const;
 
     // Dispatch process p to CPU, ready queue or job pool depending on size
     void DispatchProcess(PCB* p);
+    // Frames a job must fit in to be admitted from the job pool
+    int AdmissionFrames() const;
+    // Frame of page of p running on CPU core, looked up in the core's TLB
+    // or in the page table, where a missing page is loaded. Marks the page
+    // referenced and if write dirty.
+    int Translate(PCB* p, int page, int core, bool write);
+    // Load page of p into a free frame or the frame of a page evicted by the
+    // replacement policy (page fault). Returns its page table entry.
+    int* LoadPage(PCB* p, int page);
+    // Record the page table footprint after it changed
+    void AccountPageTables();
 
-    // Check if output exceeded 22 lines
-    void CheckLines(int& lines_printed) const;
+    // Check if output exceeded page_lines lines
+    void CheckLines(std::ostream& out, int& lines_printed, int page_lines) const;
 
-    // Print content of a device queue or the ready queue in 24 line chunks.
+    // Print a process of a device queue or the ready queue.
     // print_props == true to print process I/O parameters.
-    void PrintStatus(const std::deque<PCB*>& device, bool print_props,
-                     int& lines_printed) const;
+    void PrintProcess(const PCB* pcb, bool print_props, std::ostream& out,
+                      int& lines_printed, int page_lines) const;
 };
 
-// Generate an operating system with numbers of devices taken from user input.
-// Returns created OS
-OS Sysgen();
-
 }
 
 #endif
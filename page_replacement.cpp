@@ -0,0 +1,94 @@
+#include "page_replacement.h"
+
+const char* kReplacementNames[] = {"none", "fifo", "second-chance", "clock"};
+
+const char* ReplacementName(ReplacementPolicy policy) {
+  return kReplacementNames[static_cast<int>(policy)];
+}
+bool ParseReplacement(const std::string& name, ReplacementPolicy* policy) {
+  for (int i = 0; i < 4; i++) {
+    if (name == kReplacementNames[i]) {
+      *policy = static_cast<ReplacementPolicy>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+PageReplacer::~PageReplacer() {}
+PageReplacer* PageReplacer::make_replacer(ReplacementPolicy policy,
+                                          int num_of_frames) {
+  switch (policy) {
+    case ReplacementPolicy::none: return nullptr;
+    case ReplacementPolicy::fifo: return new FIFOReplacer{num_of_frames};
+    case ReplacementPolicy::second_chance:
+      return new SecondChanceReplacer{num_of_frames};
+    case ReplacementPolicy::clock: return new ClockReplacer{num_of_frames};
+  }
+  return nullptr;
+}
+
+void FrameList::push_back(int frame) {
+  prev[frame] = tail;
+  next[frame] = -1;
+  if (tail >= 0) next[tail] = frame;
+  else head = frame;
+  tail = frame;
+}
+
+void FrameList::erase(int frame) {
+  if (prev[frame] >= 0) next[prev[frame]] = next[frame];
+  else head = next[frame];
+  if (next[frame] >= 0) prev[next[frame]] = prev[frame];
+  else tail = prev[frame];
+  prev[frame] = next[frame] = -1;
+}
+
+void FrameList::Save(CheckpointWriter& out) const {
+  out.PutVector(prev);
+  out.PutVector(next);
+  out.Put<int32_t>(head);
+  out.Put<int32_t>(tail);
+}
+
+void FrameList::Restore(CheckpointReader& in) {
+  size_t num_of_frames = prev.size();
+  in.GetVector(&prev);
+  in.GetVector(&next);
+  head = in.Get<int32_t>();
+  tail = in.Get<int32_t>();
+  if (prev.size() != num_of_frames || next.size() != num_of_frames) in.Fail();
+}
+
+int FIFOReplacer::Victim(int* const* entries) {
+  int frame = loaded.front();
+  loaded.erase(frame);
+  return frame;
+}
+
+int SecondChanceReplacer::Victim(int* const* entries) {
+  // ends after one lap at most, when every referenced bit is cleared
+  while (true) {
+    int frame = loaded.front();
+    loaded.erase(frame);
+    if ((*entries[frame] & kPageReferenced) == 0) return frame;
+    *entries[frame] &= ~kPageReferenced;
+    loaded.push_back(frame);
+  }
+}
+
+int ClockReplacer::Victim(int* const* entries) {
+  // the second pass clears every referenced bit, so the first pass of the
+  // second round finds a page at the latest
+  while (true) {
+    for (int i = 0; i < num_of_frames; i++) {
+      int frame = Advance();
+      if ((*entries[frame] & (kPageReferenced | kPageDirty)) == 0) return frame;
+    }
+    for (int i = 0; i < num_of_frames; i++) {
+      int frame = Advance();
+      if ((*entries[frame] & kPageReferenced) == 0) return frame;
+      *entries[frame] &= ~kPageReferenced;
+    }
+  }
+}
@@ -0,0 +1,110 @@
+// Page replacement for demand paging. A PageReplacer tracks the frames that
+// hold pages and picks the frame to evict when memory is full, using the
+// referenced and dirty bits of the page table entry of each frame.
+#ifndef PAGE_REPLACEMENT_H
+#define PAGE_REPLACEMENT_H
+
+#include <string>
+#include <vector>
+
+#include "checkpoint_io.h"
+#include "pcb.h"
+
+// Replacement policy, none loads every page of a process when it is admitted
+// instead of paging on demand
+enum class ReplacementPolicy {none, fifo, second_chance, clock};
+
+// Name of policy as used in options, e.g. second-chance
+const char* ReplacementName(ReplacementPolicy policy);
+// Store the policy called name in policy. Returns false if there is none.
+bool ParseReplacement(const std::string& name, ReplacementPolicy* policy);
+
+class PageReplacer {
+  public:
+    // Replacer of policy for num_of_frames frames, nullptr for none
+    static PageReplacer* make_replacer(ReplacementPolicy policy,
+                                       int num_of_frames);
+    virtual ~PageReplacer();
+
+    // A page was loaded into frame
+    virtual void Loaded(int frame) = 0;
+    // frame was freed by the process that held it
+    virtual void Freed(int frame) = 0;
+    // Frame to evict when every frame is in use. entries[f] is the page table
+    // entry of the page in frame f, whose referenced bit may be cleared.
+    virtual int Victim(int* const* entries) = 0;
+
+    // Restore into a replacer of the same policy and frames
+    virtual void Save(CheckpointWriter& out) const = 0;
+    virtual void Restore(CheckpointReader& in) = 0;
+};
+
+// Frames in the order they were loaded, linked through per frame arrays so a
+// freed frame is unlinked in O(1)
+class FrameList {
+  public:
+    explicit FrameList(int num_of_frames) :
+        prev(num_of_frames, -1), next(num_of_frames, -1) {}
+
+    int front() const {return head;}
+    void push_back(int frame);
+    void erase(int frame);
+
+    void Save(CheckpointWriter& out) const;
+    void Restore(CheckpointReader& in);
+
+  private:
+    std::vector<int> prev, next;
+    int head = -1;
+    int tail = -1;
+};
+
+// Evict the page loaded first
+class FIFOReplacer: public PageReplacer {
+  public:
+    explicit FIFOReplacer(int num_of_frames) : loaded{num_of_frames} {}
+    void Loaded(int frame) {loaded.push_back(frame);}
+    void Freed(int frame) {loaded.erase(frame);}
+    int Victim(int* const* entries);
+    void Save(CheckpointWriter& out) const {loaded.Save(out);}
+    void Restore(CheckpointReader& in) {loaded.Restore(in);}
+  protected:
+    FrameList loaded;
+};
+
+// FIFO, but a referenced page has its bit cleared and goes to the back
+// instead of being evicted
+class SecondChanceReplacer: public FIFOReplacer {
+  public:
+    explicit SecondChanceReplacer(int num_of_frames) :
+        FIFOReplacer{num_of_frames} {}
+    int Victim(int* const* entries);
+};
+
+// LRU approximation: a hand sweeps the frames in order and evicts the first
+// page that is neither referenced nor dirty, then the first unreferenced
+// dirty page while clearing referenced bits (enhanced clock), so clean pages
+// are preferred over pages that must be written back
+class ClockReplacer: public PageReplacer {
+  public:
+    explicit ClockReplacer(int num_of_frames) : num_of_frames{num_of_frames} {}
+    void Loaded(int frame) {}
+    void Freed(int frame) {}
+    int Victim(int* const* entries);
+    void Save(CheckpointWriter& out) const {out.Put<int32_t>(hand);}
+    void Restore(CheckpointReader& in) {
+      hand = in.Get<int32_t>();
+      if (hand < 0 || hand >= num_of_frames) in.Fail();
+    }
+  private:
+    int num_of_frames;
+    int hand = 0;
+
+    int Advance() {
+      int frame = hand;
+      hand = (hand + 1 == num_of_frames) ? 0 : hand + 1;
+      return frame;
+    }
+};
+
+#endif
@@ -0,0 +1,230 @@
+#include "page_table.h"
+
+#include <algorithm>
+
+const char* kPageTableNames[] = {"dense", "2-level", "3-level", "inverted"};
+
+const char* PageTableName(PageTableKind kind) {
+  return kPageTableNames[static_cast<int>(kind)];
+}
+bool ParsePageTable(const std::string& name, PageTableKind* kind) {
+  for (int i = 0; i < 4; i++) {
+    if (name == kPageTableNames[i]) {
+      *kind = static_cast<PageTableKind>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+PageTables::~PageTables() {}
+PageTables* PageTables::make_page_tables(
+    PageTableKind kind, PCBPool* pool, int max_pages,
+    const std::vector<std::pair<int,int>>& frame_table) {
+  switch (kind) {
+    case PageTableKind::dense: return new DensePageTables{pool};
+    case PageTableKind::two_level: return new RadixPageTables{pool, 2, max_pages};
+    case PageTableKind::three_level: return new RadixPageTables{pool, 3, max_pages};
+    case PageTableKind::inverted:
+      return new InvertedPageTable{frame_table.data(), (int)frame_table.size()};
+  }
+  return nullptr;
+}
+
+
+void DensePageTables::Create(PCB* p) {
+  p->page_table = pool->AllocateTable(p->pages);
+  std::fill(p->page_table, p->page_table + p->pages, 0);
+  bytes += PCBPool::TableCapacity(p->pages)*sizeof(int);
+}
+
+void DensePageTables::Destroy(PCB* p) {
+  pool->ReleaseTable(p->page_table, p->pages);
+  p->page_table = nullptr;
+  bytes -= PCBPool::TableCapacity(p->pages)*sizeof(int);
+}
+
+int* DensePageTables::Find(const PCB* p, int page, size_t* accesses) {
+  if (accesses != nullptr) (*accesses)++;
+  return &p->page_table[page];
+}
+
+int* DensePageTables::Map(PCB* p, int page, int frame) {
+  p->page_table[page] = frame | kPageValid;
+  return &p->page_table[page];
+}
+
+void DensePageTables::SaveTable(const PCB* p, CheckpointWriter& out) const {
+  out.Write(p->page_table, p->pages*sizeof(int));
+}
+
+void DensePageTables::RestoreTable(PCB* p, CheckpointReader& in) {
+  Create(p);
+  in.Read(p->page_table, p->pages*sizeof(int));
+}
+
+
+RadixPageTables::RadixPageTables(PCBPool* pool, int levels, int max_pages) :
+    pool{pool}, levels{levels} {
+  // split the page number bits evenly over the levels
+  int page_bits = 0;
+  while ((1 << page_bits) < max_pages) page_bits++;
+  bits = std::max(1, (page_bits + levels - 1)/levels);
+  fanout = 1 << bits;
+}
+
+RadixPageTables::~RadixPageTables() {
+  for (auto& chunk: chunks) delete[] chunk;
+}
+
+int RadixPageTables::NewNode() {
+  if (free_nodes.empty()) {
+    int first = chunks.size()*kChunkNodes;
+    chunks.push_back(new int[kChunkNodes*fanout]);
+    for (int i = kChunkNodes - 1; i >= 0; i--) free_nodes.push_back(first + i);
+  }
+  int id = free_nodes.back();
+  free_nodes.pop_back();
+  nodes_used++;
+  int* node = Node(id);
+  std::fill(node, node + fanout, 0);
+  return id;
+}
+
+void RadixPageTables::Create(PCB* p) {
+  p->page_table = pool->AllocateTable(fanout);
+  std::fill(p->page_table, p->page_table + fanout, 0);
+  roots++;
+}
+
+void RadixPageTables::FreeSubtree(int* node, int level) {
+  // entries of the last level are page table entries
+  if (level == levels - 1) return;
+  for (int i = 0; i < fanout; i++) {
+    if (node[i] == 0) continue;
+    FreeSubtree(Node(node[i] - 1), level + 1);
+    free_nodes.push_back(node[i] - 1);
+    nodes_used--;
+  }
+}
+
+void RadixPageTables::Destroy(PCB* p) {
+  FreeSubtree(p->page_table, 0);
+  pool->ReleaseTable(p->page_table, fanout);
+  p->page_table = nullptr;
+  roots--;
+}
+
+int* RadixPageTables::Find(const PCB* p, int page, size_t* accesses) {
+  int* node = p->page_table;
+  for (int level = 0; level < levels - 1; level++) {
+    if (accesses != nullptr) (*accesses)++;
+    int child = node[Index(page, level)];
+    if (child == 0) return nullptr;
+    node = Node(child - 1);
+  }
+  if (accesses != nullptr) (*accesses)++;
+  return &node[Index(page, levels - 1)];
+}
+
+int* RadixPageTables::Map(PCB* p, int page, int frame) {
+  int* node = p->page_table;
+  for (int level = 0; level < levels - 1; level++) {
+    // node stays valid across NewNode since chunks never move
+    int& child = node[Index(page, level)];
+    if (child == 0) child = NewNode() + 1;
+    node = Node(child - 1);
+  }
+  int* entry = &node[Index(page, levels - 1)];
+  *entry = frame | kPageValid;
+  return entry;
+}
+
+void RadixPageTables::SaveSubtree(const int* node, int level,
+                                  CheckpointWriter& out) const {
+  if (level == levels - 1) {
+    out.Write(node, fanout*sizeof(int));
+    return;
+  }
+  for (int i = 0; i < fanout; i++) out.Put<int32_t>(node[i] != 0);
+  for (int i = 0; i < fanout; i++) {
+    if (node[i] != 0) SaveSubtree(Node(node[i] - 1), level + 1, out);
+  }
+}
+
+void RadixPageTables::RestoreSubtree(int* node, int level,
+                                     CheckpointReader& in) {
+  in.Read(node, fanout*sizeof(int));
+  if (level == levels - 1) return;
+  for (int i = 0; i < fanout; i++) {
+    if (node[i] == 0 || !in.ok()) continue;
+    node[i] = NewNode() + 1;
+    RestoreSubtree(Node(node[i] - 1), level + 1, in);
+  }
+}
+
+void RadixPageTables::SaveTable(const PCB* p, CheckpointWriter& out) const {
+  SaveSubtree(p->page_table, 0, out);
+}
+
+void RadixPageTables::RestoreTable(PCB* p, CheckpointReader& in) {
+  Create(p);
+  RestoreSubtree(p->page_table, 0, in);
+}
+
+
+InvertedPageTable::InvertedPageTable(const std::pair<int,int>* frame_table,
+                                     int num_of_frames) :
+    frame_table{frame_table}, next(num_of_frames, -1),
+    entries(num_of_frames, 0) {
+  // at most one frame per bucket on average
+  size_t num_of_buckets = 1;
+  while (num_of_buckets < (size_t)num_of_frames) num_of_buckets *= 2;
+  buckets.assign(num_of_buckets, -1);
+}
+
+int* InvertedPageTable::Find(const PCB* p, int page, size_t* accesses) {
+  int frame = buckets[Bucket(p->pid, page)];
+  if (accesses != nullptr) (*accesses)++;
+  while (frame >= 0) {
+    if (accesses != nullptr) (*accesses)++;
+    if (frame_table[frame].first == (int)p->pid &&
+        frame_table[frame].second == page)
+      return &entries[frame];
+    frame = next[frame];
+  }
+  return nullptr;
+}
+
+int* InvertedPageTable::Map(PCB* p, int page, int frame) {
+  int& bucket = buckets[Bucket(p->pid, page)];
+  next[frame] = bucket;
+  bucket = frame;
+  entries[frame] = frame | kPageValid;
+  return &entries[frame];
+}
+
+void InvertedPageTable::Unmap(int frame, int* entry) {
+  int* link = &buckets[Bucket(frame_table[frame].first,
+                              frame_table[frame].second)];
+  while (*link != frame) link = &next[*link];
+  *link = next[frame];
+  next[frame] = -1;
+  *entry = 0;
+}
+
+void InvertedPageTable::Save(CheckpointWriter& out) const {
+  out.PutVector(buckets);
+  out.PutVector(next);
+  out.PutVector(entries);
+}
+
+void InvertedPageTable::Restore(CheckpointReader& in) {
+  size_t num_of_buckets = buckets.size(), num_of_frames = entries.size();
+  in.GetVector(&buckets);
+  in.GetVector(&next);
+  in.GetVector(&entries);
+  if (buckets.size() != num_of_buckets || next.size() != num_of_frames ||
+      entries.size() != num_of_frames)
+    in.Fail();
+}
@@ -0,0 +1,158 @@
+// Page table organizations behind one translation interface. Entries use the
+// PCB page table entry format (frame, valid/referenced/dirty bits) in every
+// organization:
+// - dense: one entry per page of a process, allocated at admission
+// - two/three level: a radix tree per process whose nodes are allocated when
+//   a page in their range is first mapped, so sparse use stays small
+// - inverted: one entry per frame shared by all processes, found by hashing
+//   pid and page, with the (pid, page) of each frame kept in the OS frame
+//   table
+#ifndef PAGE_TABLE_H
+#define PAGE_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "checkpoint_io.h"
+#include "pcb.h"
+#include "pcb_pool.h"
+
+enum class PageTableKind {dense, two_level, three_level, inverted};
+
+// Name of kind as used in options, e.g. 2-level
+const char* PageTableName(PageTableKind kind);
+// Store the kind called name in kind. Returns false if there is none.
+bool ParsePageTable(const std::string& name, PageTableKind* kind);
+
+class PageTables {
+  public:
+    // Page tables of kind for processes of at most max_pages pages in
+    // frame_table.size() frames. pool and the storage of frame_table (which
+    // moves with the vector) must outlive them.
+    static PageTables* make_page_tables(
+        PageTableKind kind, PCBPool* pool, int max_pages,
+        const std::vector<std::pair<int,int>>& frame_table);
+    virtual ~PageTables();
+
+    // Give p an empty page table when it is admitted to memory
+    virtual void Create(PCB* p) = 0;
+    // Free the page table of p, which has no pages mapped any more
+    virtual void Destroy(PCB* p) = 0;
+
+    // Entry of page of p, nullptr if there is none (the page is not mapped).
+    // Memory accesses the lookup took are added to accesses if given.
+    virtual int* Find(const PCB* p, int page, size_t* accesses = nullptr) = 0;
+    // Map page of p to frame, whose frame table slot already holds
+    // (p->pid, page). Returns its entry, valid and not referenced or dirty.
+    virtual int* Map(PCB* p, int page, int frame) = 0;
+    // Unmap the page in frame whose entry is entry, before its frame table
+    // slot is cleared
+    virtual void Unmap(int frame, int* entry) {*entry = 0;}
+
+    // Bytes of page table memory in use
+    virtual size_t footprint() const = 0;
+
+    // Write the page table of p, which has one. RestoreTable gives p, which
+    // has none, the table SaveTable wrote.
+    virtual void SaveTable(const PCB* p, CheckpointWriter& out) const = 0;
+    virtual void RestoreTable(PCB* p, CheckpointReader& in) = 0;
+    // Write the tables shared by all processes. Restore reads them back into
+    // page tables of the same kind and frames, after the processes' tables.
+    virtual void Save(CheckpointWriter& out) const {}
+    virtual void Restore(CheckpointReader& in) {}
+};
+
+// Page tables with an entry for every page of a process
+class DensePageTables: public PageTables {
+  public:
+    explicit DensePageTables(PCBPool* pool) : pool{pool} {}
+    void Create(PCB* p);
+    void Destroy(PCB* p);
+    int* Find(const PCB* p, int page, size_t* accesses);
+    int* Map(PCB* p, int page, int frame);
+    size_t footprint() const {return bytes;}
+    void SaveTable(const PCB* p, CheckpointWriter& out) const;
+    void RestoreTable(PCB* p, CheckpointReader& in);
+  private:
+    PCBPool* pool;
+    size_t bytes = 0;
+};
+
+// Radix tree of levels levels per process. Interior nodes hold the id + 1 of
+// their children (0 if none yet), leaves hold page table entries.
+class RadixPageTables: public PageTables {
+  public:
+    RadixPageTables(PCBPool* pool, int levels, int max_pages);
+    ~RadixPageTables();
+    void Create(PCB* p);
+    void Destroy(PCB* p);
+    int* Find(const PCB* p, int page, size_t* accesses);
+    int* Map(PCB* p, int page, int frame);
+    size_t footprint() const {
+      return (nodes_used + roots)*(size_t)fanout*sizeof(int);
+    }
+    // Nodes in preorder, with 1 for every child of interior nodes
+    void SaveTable(const PCB* p, CheckpointWriter& out) const;
+    void RestoreTable(PCB* p, CheckpointReader& in);
+
+  private:
+    static const int kChunkNodes = 64;
+
+    PCBPool* pool;  // roots come from the page table pool
+    int levels;
+    int bits;       // page number bits per level
+    int fanout;     // entries per node
+    // nodes below the roots, in chunks so they never move
+    std::vector<int*> chunks;
+    std::vector<int> free_nodes;
+    size_t nodes_used = 0;
+    size_t roots = 0;
+
+    int* Node(int id) const {
+      return chunks[id/kChunkNodes] + (id % kChunkNodes)*fanout;
+    }
+    int Index(int page, int level) const {
+      return (page >> (bits*(levels - 1 - level))) & (fanout - 1);
+    }
+    int NewNode();
+    void FreeSubtree(int* node, int level);
+    void SaveSubtree(const int* node, int level, CheckpointWriter& out) const;
+    void RestoreSubtree(int* node, int level, CheckpointReader& in);
+};
+
+// Hashed inverted page table: the entry of frame f belongs to the page in
+// frame_table[f], chained from the bucket of hash(pid, page)
+class InvertedPageTable: public PageTables {
+  public:
+    InvertedPageTable(const std::pair<int,int>* frame_table, int num_of_frames);
+    void Create(PCB* p) {}
+    void Destroy(PCB* p) {}
+    int* Find(const PCB* p, int page, size_t* accesses);
+    int* Map(PCB* p, int page, int frame);
+    void Unmap(int frame, int* entry);
+    size_t footprint() const {
+      return buckets.size()*sizeof(int) +
+             entries.size()*(sizeof(int)*2 + sizeof(std::pair<int,int>));
+    }
+    void SaveTable(const PCB* p, CheckpointWriter& out) const {}
+    void RestoreTable(PCB* p, CheckpointReader& in) {}
+    void Save(CheckpointWriter& out) const;
+    void Restore(CheckpointReader& in);
+
+  private:
+    const std::pair<int,int>* frame_table;
+    std::vector<int> buckets;  // first frame of each chain, -1 if empty
+    std::vector<int> next;     // next frame in the chain of each frame
+    std::vector<int> entries;  // page table entry of each frame
+
+    size_t Bucket(size_t pid, int page) const {
+      uint64_t key = ((uint64_t)pid << 32) ^ (uint32_t)page;
+      key *= 0x9e3779b97f4a7c15ull;
+      return (key >> 32) & (buckets.size() - 1);
+    }
+};
+
+#endif
@@ -1,34 +1,82 @@
 #ifndef PCB_H
 #define PCB_H
 
-#include <string>
-#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// Compact reference to a PCB in its PCBPool
+typedef uint32_t PCBHandle;
+const PCBHandle kNullHandle = UINT32_MAX;
+
+// Page table entries hold the frame of a page in the low bits and its state
+// in the bits above
+const int kPageValid = 1 << 30;       // page is in memory
+const int kPageReferenced = 1 << 29;  // accessed since the bit was cleared
+const int kPageDirty = 1 << 28;       // written since it was loaded
+const int kPageFrame = kPageDirty - 1;
 
 // Process Control Block struct with all process information
 struct PCB {
-  enum state {active, waiting};  // unused
+  // where the process currently is
+  enum state {active, ready, waiting, job_pool};
   size_t pid;
   int size;
-  static int page_size;
   int pages;
-  std::vector<int> page_table;
+  // root of the page table while in memory (see PageTables), storage owned
+  // by the PCBPool
+  int* page_table = nullptr;
+  int page_faults = 0;
 
-  std::string file_name;
+  char file_name[21];
   size_t start_mem_loc, physical_loc;
   char op;
   size_t file_size;
   // disks
   int cylinder_num;
+  size_t disk_arrival = 0;  // requests the disk had serviced when queued
 
   float cpu_time = 0;
   int bursts = 0;
+  int priority = 0;  // run queue level, 0 is the highest
+  int slice = 0;     // ms of the time slice it was last dispatched with
+  int nice = 0;
+  int64_t vruntime = 0;  // us of CPU time weighted by nice (fair scheduling)
+
+  // OS clock times for metrics
+  int64_t arrival_time = 0;
+  int64_t queued_time = 0;  // entered the queue it is in
+  int64_t ready_time = 0;   // spent in run queues
+
+  state proc_state = active;
+  int device = -1;  // index of device while waiting for I/O
+  int core = -1;       // CPU running the process or holding it in its run queue
+  int last_core = -1;  // CPU the process last ran on
+
+  // own handle and links of the PCBQueue the process is in
+  PCBHandle handle;
+  PCBHandle prev = kNullHandle;
+  PCBHandle next = kNullHandle;
+
+  PCB(size_t new_pid, int new_size, int new_pages, PCBHandle new_handle) :
+      pid{new_pid}, size{new_size}, pages{new_pages}, file_name{""},
+      start_mem_loc{0}, physical_loc{0}, op{'-'}, file_size{0},
+      cylinder_num{-1}, handle{new_handle} {}
+};
+
+// Callback for visiting the requests of a queue in service order
+struct RequestVisitor {
+  virtual void Visit(PCB* request) = 0;
+  protected:
+    ~RequestVisitor() {}
+};
 
-  PCB(size_t new_pid, int new_size) : pid{new_pid}, size{new_size},
-                                      file_name{""}, start_mem_loc{0},
-                                      physical_loc{0}, op{'-'},
-                                      file_size{0}, cylinder_num{-1} {
-                                        page_table.resize(ceil((float)size/(float)page_size));
-                                      }
+// RequestVisitor calling a function object, so lambdas can be used without
+// allocating
+template<typename F>
+struct FunctionVisitor: RequestVisitor {
+  explicit FunctionVisitor(F& f) : f_(f) {}
+  void Visit(PCB* request) {f_(request);}
+  F& f_;
 };
 
 #endif
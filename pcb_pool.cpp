@@ -0,0 +1,201 @@
+#include "pcb_pool.h"
+#include <cstring>
+#include <new>
+
+PCBPool::~PCBPool() {
+  // slabs restored from a checkpoint go with its mapping
+  for (size_t i = mapped_slabs; i < slabs.size(); i++) ::operator delete(slabs[i]);
+  for (auto& chunk: chunks) delete[] chunk;
+}
+
+int PCBPool::SizeClass(int entries) {
+  int size_class = 0;
+  while ((1 << size_class) < entries) size_class++;
+  return size_class;
+}
+
+int* PCBPool::AllocateTable(int entries) {
+  int size_class = SizeClass(entries);
+  std::vector<int*>& free_list = free_tables[size_class];
+  if (!free_list.empty()) {
+    int* table = free_list.back();
+    free_list.pop_back();
+    return table;
+  }
+  int capacity = 1 << size_class;
+  if (chunk_end - chunk_pos < capacity) {
+    int chunk_entries = (capacity > kChunkEntries) ? capacity : kChunkEntries;
+    chunk_pos = new int[chunk_entries];
+    chunk_end = chunk_pos + chunk_entries;
+    chunks.push_back(chunk_pos);
+  }
+  int* table = chunk_pos;
+  chunk_pos += capacity;
+  return table;
+}
+
+PCB* PCBPool::Allocate(size_t pid, int size, int pages) {
+  if (free_handles.empty()) {
+    // add a slab and make all its PCBs free, lowest handle used first
+    if (slabs.size() == kMaxSlabs) throw std::bad_alloc();
+    PCBHandle first = slabs.size() << kSlabBits;
+    slabs.push_back(static_cast<PCB*>(::operator new(sizeof(PCB)*kSlabSize)));
+    free_handles.reserve(free_handles.size() + kSlabSize);
+    for (int i = kSlabSize - 1; i >= 0; i--) free_handles.push_back(first + i);
+  }
+  PCBHandle handle = free_handles.back();
+  free_handles.pop_back();
+  live_count++;
+  PCB* slot = slabs[handle >> kSlabBits] + (handle & (kSlabSize-1));
+  return new (slot) PCB{pid, size, pages, handle};
+}
+
+void PCBPool::Release(PCB* p) {
+  free_handles.push_back(p->handle);
+  live_count--;
+  p->~PCB();
+}
+
+void PCBPool::Save(CheckpointWriter& out) const {
+  out.Put<uint64_t>(slabs.size());
+  out.PutVector(free_handles);
+  out.Put<uint64_t>(live_count);
+  // whole slabs so they can be used in place, free PCBs zeroed and page
+  // table pointers cleared so the file only depends on the processes
+  std::vector<char> is_free(capacity(), 0);
+  for (PCBHandle h: free_handles) is_free[h] = 1;
+  std::vector<char> buffer(sizeof(PCB)*kSlabSize);
+  out.Align();
+  for (size_t i = 0; i < slabs.size(); i++) {
+    std::fill(buffer.begin(), buffer.end(), 0);
+    PCB* copy = reinterpret_cast<PCB*>(buffer.data());
+    for (int j = 0; j < kSlabSize; j++) {
+      if (is_free[(i << kSlabBits) + j]) continue;
+      memcpy(static_cast<void*>(&copy[j]), &slabs[i][j], sizeof(PCB));
+      copy[j].page_table = nullptr;
+    }
+    out.Write(buffer.data(), buffer.size());
+  }
+}
+
+void PCBPool::Restore(CheckpointReader& in) {
+  uint64_t num_of_slabs = in.Get<uint64_t>();
+  in.GetVector(&free_handles);
+  live_count = in.Get<uint64_t>();
+  size_t handles = num_of_slabs << kSlabBits;
+  if (num_of_slabs > kMaxSlabs || free_handles.size() + live_count != handles) {
+    in.Fail();
+    return;
+  }
+  for (PCBHandle h: free_handles) {
+    if (h >= handles) in.Fail();
+  }
+  char* span = in.Span(handles*sizeof(PCB));
+  if (!in.ok()) return;
+  image = in.image();
+  for (size_t i = 0; i < num_of_slabs; i++) {
+    slabs.push_back(reinterpret_cast<PCB*>(span) + i*kSlabSize);
+  }
+  mapped_slabs = num_of_slabs;
+}
+
+
+void PidIndex::insert(size_t pid, PCBHandle handle) {
+  // keep the table at most half full
+  if (2*(count + 1) > slots.size()) {
+    std::vector<Slot> old_slots(2*slots.size(), Slot{0, kNullHandle});
+    old_slots.swap(slots);
+    bits++;
+    count = 0;
+    for (const auto& slot: old_slots) {
+      if (slot.handle != kNullHandle) insert(slot.pid, slot.handle);
+    }
+  }
+  size_t i = Home(pid);
+  while (slots[i].handle != kNullHandle) i = Next(i);
+  slots[i] = Slot{pid, handle};
+  count++;
+}
+
+void PidIndex::erase(size_t pid) {
+  size_t i = Home(pid);
+  while (slots[i].handle != kNullHandle && slots[i].pid != pid) i = Next(i);
+  if (slots[i].handle == kNullHandle) return;
+
+  // shift following entries of the probe run back into the hole, unless
+  // their home slot lies after the hole
+  size_t j = i;
+  while (true) {
+    j = Next(j);
+    if (slots[j].handle == kNullHandle) break;
+    size_t home = Home(slots[j].pid);
+    bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+    if (!stays) {
+      slots[i] = slots[j];
+      i = j;
+    }
+  }
+  slots[i].handle = kNullHandle;
+  count--;
+}
+
+
+void PidIndex::Save(CheckpointWriter& out) const {
+  out.PutVector(slots);
+  out.Put<int32_t>(bits);
+  out.Put<uint64_t>(count);
+}
+
+void PidIndex::Restore(CheckpointReader& in) {
+  in.GetVector(&slots);
+  bits = in.Get<int32_t>();
+  count = in.Get<uint64_t>();
+  if (bits < 1 || bits > 62 || slots.size() != (size_t)1 << bits) in.Fail();
+}
+
+
+void JobPool::push(PCB* p) {
+  auto bucket = buckets.find(p->pages);
+  if (bucket == buckets.end())
+    bucket = buckets.emplace(p->pages, PCBQueue{pool}).first;
+  bucket->second.push_back(p);
+  count++;
+}
+
+void JobPool::erase(PCB* p) {
+  auto bucket = buckets.find(p->pages);
+  bucket->second.erase(p);
+  if (bucket->second.empty()) buckets.erase(bucket);
+  count--;
+}
+
+PCB* JobPool::LargestFitting(int free_frames) const {
+  // the bucket below the first one too large for free_frames
+  auto bucket = buckets.upper_bound(free_frames);
+  if (bucket == buckets.begin()) return nullptr;
+  return std::prev(bucket)->second.front();
+}
+
+void JobPool::Save(CheckpointWriter& out) const {
+  out.Put<uint64_t>(buckets.size());
+  for (const auto& bucket: buckets) {
+    out.Put<int32_t>(bucket.first);
+    bucket.second.Save(out);
+  }
+}
+
+void JobPool::Restore(CheckpointReader& in) {
+  buckets.clear();
+  count = 0;
+  uint64_t num_of_buckets = in.Get<uint64_t>();
+  int last_pages = 0;
+  for (uint64_t i = 0; i < num_of_buckets && in.ok(); i++) {
+    // buckets were saved by increasing page count, none empty
+    int pages = in.Get<int32_t>();
+    PCBQueue& bucket = buckets.emplace(pages, PCBQueue{pool}).first->second;
+    bucket.Restore(in);
+    if (pages <= last_pages || bucket.empty()) in.Fail();
+    last_pages = pages;
+    count += bucket.size();
+  }
+}
@@ -0,0 +1,248 @@
+// Allocation of PCBs and their page tables from slabs that are reused when
+// processes terminate, so process creation and teardown do not call malloc
+// once the pool has grown to the working set. Queues link PCBs by 32-bit
+// PCBHandle instead of pointers.
+#ifndef PCB_POOL_H
+#define PCB_POOL_H
+
+#include <cstddef>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "checkpoint_io.h"
+#include "pcb.h"
+
+// Slab allocator for PCBs with stable addresses and handles
+class PCBPool {
+  public:
+    PCBPool() = default;
+    ~PCBPool();
+    PCBPool(const PCBPool&) = delete;
+    PCBPool& operator=(const PCBPool&) = delete;
+
+    // Create a PCB of pages pages, without a page table yet
+    PCB* Allocate(size_t pid, int size, int pages);
+    // Return p to the pool
+    void Release(PCB* p);
+
+    // Page table of at least entries entries (uninitialized)
+    int* AllocateTable(int entries);
+    // Return a table allocated for entries entries
+    void ReleaseTable(int* table, int entries) {
+      free_tables[SizeClass(entries)].push_back(table);
+    }
+    // Entries actually reserved for a table of entries entries
+    static int TableCapacity(int entries) {return 1 << SizeClass(entries);}
+
+    PCB* get(PCBHandle handle) const {
+      return slabs[handle >> kSlabBits] + (handle & (kSlabSize-1));
+    }
+    size_t live() const {return live_count;}
+    // Number of handles that have been given out, live or free
+    size_t capacity() const {return slabs.size() << kSlabBits;}
+
+    // Write the PCBs with their handles. Page tables are not part of it,
+    // they are saved by their PageTables.
+    void Save(CheckpointWriter& out) const;
+    // Restore the PCBs of Save into an empty pool, without page tables. The
+    // slabs stay in the checkpoint mapping, so only PCBs that are used are
+    // read from the file.
+    void Restore(CheckpointReader& in);
+    // PCB of a handle written with out.Put(handle) after the PCBs were
+    // restored, nullptr for kNullHandle or a handle outside the pool (which
+    // makes in fail)
+    PCB* ReadPCB(CheckpointReader& in) const {
+      PCBHandle handle = in.Get<PCBHandle>();
+      if (handle == kNullHandle) return nullptr;
+      if (handle >= capacity()) {
+        in.Fail();
+        return nullptr;
+      }
+      return get(handle);
+    }
+
+  private:
+    static const int kSlabBits = 10;
+    static const int kSlabSize = 1 << kSlabBits;
+    static const int kChunkEntries = 1 << 16;  // page table entries per chunk
+    static const int kSizeClasses = 32;
+    // most slabs a pool grows to, also a bound on restored checkpoints
+    static const int kMaxSlabs = 1 << 14;
+
+    std::vector<PCB*> slabs;
+    std::vector<PCBHandle> free_handles;
+    size_t live_count = 0;
+    // slabs[0, mapped_slabs) are in the checkpoint mapping image
+    size_t mapped_slabs = 0;
+    std::shared_ptr<CheckpointImage> image;
+
+    // page tables are kept in power of two size classes carved from chunks
+    std::vector<int*> chunks;
+    int* chunk_pos = nullptr;
+    int* chunk_end = nullptr;
+    std::vector<int*> free_tables[kSizeClasses];
+
+    static int SizeClass(int entries);
+};
+
+// FIFO queue of PCBs linked through PCB::prev and PCB::next, so any PCB can be
+// removed in O(1) without searching. A PCB can only be in one queue at a time.
+class PCBQueue {
+  public:
+    class iterator {
+      public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef PCB* value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef PCB* const* pointer;
+        typedef PCB* reference;
+
+        iterator(const PCBPool* pool, PCBHandle h) : pool_{pool}, h_{h} {}
+        PCB* operator*() const {return pool_->get(h_);}
+        iterator& operator++() {h_ = pool_->get(h_)->next; return *this;}
+        bool operator!=(const iterator& other) const {return h_ != other.h_;}
+        bool operator==(const iterator& other) const {return h_ == other.h_;}
+      private:
+        const PCBPool* pool_;
+        PCBHandle h_;
+    };
+
+    explicit PCBQueue(const PCBPool* pool) : pool{pool} {}
+    PCBQueue(PCBQueue&& other) : pool{other.pool}, head{other.head},
+                                 tail{other.tail}, count{other.count} {
+      other.head = other.tail = kNullHandle;
+      other.count = 0;
+    }
+    PCBQueue(const PCBQueue&) = delete;
+    PCBQueue& operator=(const PCBQueue&) = delete;
+
+    bool empty() const {return count == 0;}
+    size_t size() const {return count;}
+    PCB* front() const {return empty() ? nullptr : pool->get(head);}
+    PCB* back() const {return empty() ? nullptr : pool->get(tail);}
+    iterator begin() const {return iterator{pool, head};}
+    iterator end() const {return iterator{pool, kNullHandle};}
+
+    void push_back(PCB* p) {
+      p->prev = tail;
+      p->next = kNullHandle;
+      if (tail != kNullHandle) pool->get(tail)->next = p->handle;
+      else head = p->handle;
+      tail = p->handle;
+      count++;
+    }
+    void pop_front() {erase(pool->get(head));}
+    void pop_back() {erase(pool->get(tail));}
+
+    // Unlink p, which must be in this queue
+    void erase(PCB* p) {
+      if (p->prev != kNullHandle) pool->get(p->prev)->next = p->next;
+      else head = p->next;
+      if (p->next != kNullHandle) pool->get(p->next)->prev = p->prev;
+      else tail = p->prev;
+      p->prev = p->next = kNullHandle;
+      count--;
+    }
+
+    // Links of the PCBs are saved with them by the PCBPool
+    void Save(CheckpointWriter& out) const {
+      out.Put(head);
+      out.Put(tail);
+      out.Put<uint64_t>(count);
+    }
+    void Restore(CheckpointReader& in) {
+      head = in.Get<PCBHandle>();
+      tail = in.Get<PCBHandle>();
+      count = in.Get<uint64_t>();
+    }
+
+  private:
+    const PCBPool* pool;
+    PCBHandle head = kNullHandle;
+    PCBHandle tail = kNullHandle;
+    size_t count = 0;
+};
+
+// Hash index from pid to PCBHandle using open addressing, so inserting and
+// erasing do not allocate once the table has grown to the number of processes
+class PidIndex {
+  public:
+    PidIndex() : slots(16, Slot{0, kNullHandle}), bits{4} {}
+
+    size_t size() const {return count;}
+    // Handle of process pid, kNullHandle if there is none
+    PCBHandle find(size_t pid) const {
+      for (size_t i = Home(pid); slots[i].handle != kNullHandle; i = Next(i)) {
+        if (slots[i].pid == pid) return slots[i].handle;
+      }
+      return kNullHandle;
+    }
+    void insert(size_t pid, PCBHandle handle);
+    void erase(size_t pid);
+
+    // Call f(pid, handle) for every process in slot order
+    template<typename F>
+    void ForEach(F f) const {
+      for (const auto& slot: slots) {
+        if (slot.handle != kNullHandle) f(slot.pid, slot.handle);
+      }
+    }
+
+    void Save(CheckpointWriter& out) const;
+    void Restore(CheckpointReader& in);
+
+  private:
+    struct Slot {
+      size_t pid;
+      PCBHandle handle;  // kNullHandle for an empty slot
+    };
+    std::vector<Slot> slots;
+    int bits;  // slots.size() == 1 << bits
+    size_t count = 0;
+
+    size_t Home(size_t pid) const {
+      return (pid*0x9E3779B97F4A7C15ull) >> (64 - bits);
+    }
+    size_t Next(size_t i) const {return (i + 1) & (slots.size() - 1);}
+};
+
+// Job pool of processes waiting for memory, bucketed by page count with a
+// FIFO PCBQueue per bucket. Only page counts with waiting jobs have a bucket,
+// kept in a map by page count, so the largest job that fits in a number of
+// free frames is found in O(log n) of the page counts waiting.
+class JobPool {
+  public:
+    explicit JobPool(const PCBPool* pool) : pool{pool} {}
+
+    bool empty() const {return count == 0;}
+    size_t size() const {return count;}
+
+    // Add p, which must have p->pages >= 1
+    void push(PCB* p);
+    // Remove p, which must be in the pool
+    void erase(PCB* p);
+
+    // Longest waiting of the largest jobs with at most free_frames pages,
+    // nullptr if no job fits
+    PCB* LargestFitting(int free_frames) const;
+
+    // Call f(PCB*) for all jobs, largest first and FIFO within a page count
+    template<typename F>
+    void ForEach(F f) const {
+      for (auto it = buckets.rbegin(); it != buckets.rend(); ++it) {
+        for (PCB* p: it->second) f(p);
+      }
+    }
+
+    void Save(CheckpointWriter& out) const;
+    void Restore(CheckpointReader& in);
+
+  private:
+    const PCBPool* pool;
+    std::map<int, PCBQueue> buckets;  // by page count, none empty
+    size_t count = 0;
+};
+
+#endif
@@ -2,13 +2,567 @@
 // 8 Oct 2017
 // Main file for running a basic OS
 
-#include "os.h"
+#include "checkpoint.h"
+#include "config.h"
+#include "console.h"
+#include "sweep.h"
+#include "trace.h"
+#include "workload.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 using namespace std;
 using namespace os_ops;
 
-int main() {
-  OS os = Sysgen();
+// Replay trace at path without console I/O, on the OS of checkpoint
+// restore_path if given, and save the OS afterwards to checkpoint
+// checkpoint_path if given. Print summary if asked to. Returns exit status.
+int Replay(const char* path, bool print_summary, const char* restore_path,
+           const char* checkpoint_path) {
+  ReplaySummary summary;
+  string error;
+  unique_ptr<OS> os;
+  if (restore_path != nullptr) {
+    auto start = chrono::steady_clock::now();
+    if (!LoadCheckpoint(restore_path, &os, &error)) {
+      cerr << error << endl;
+      return 1;
+    }
+    if (print_summary)
+      cout << "Restored checkpoint in "
+           << chrono::duration<double>(chrono::steady_clock::now() -
+                                       start).count() << " s" << endl;
+  }
+  if (!ReplayTrace(path, &summary, &error, &os)) {
+    cerr << error << endl;
+    return 1;
+  }
+  if (checkpoint_path != nullptr && !SaveCheckpoint(*os, checkpoint_path, &error)) {
+    cerr << error << endl;
+    return 1;
+  }
+  if (print_summary) {
+    cout << "Events: " << summary.events
+         << ", rejected: " << summary.failed
+         << ", completed processes: " << summary.completed
+         << ", time: " << summary.seconds << " s"
+         << ", events/s: " << summary.events/summary.seconds << endl;
+    cout << "Free frames: " << summary.frames.free_frames
+         << ", free runs: " << summary.frames.runs
+         << ", largest run: " << summary.frames.largest_run
+         << ", fragmentation: " << summary.frames.fragmentation() << endl;
+    for (int i = 0; i < 7; i++) {
+      const PolicySummary& policy = summary.policies[i];
+      if (policy.disks == 0) continue;
+      cout << "Disk policy " << PolicyName(static_cast<DiskPolicy>(i))
+           << " (" << policy.disks << " disks): seek distance: "
+           << policy.stats.seek_distance
+           << ", serviced: " << policy.stats.serviced
+           << ", mean wait: " << policy.stats.mean_wait()
+           << ", max wait: " << policy.stats.max_wait << endl;
+    }
+  }
+  return 0;
+}
+
+// Print count, mean and tail latency of h in ms
+void PrintLatency(const char* name, const Histogram& h) {
+  double ms = kMillisecond;
+  cout << name << ": " << h.count() << ", mean: " << h.mean()/ms
+       << " ms, p50: " << h.Quantile(0.5)/ms << " ms, p99: "
+       << h.Quantile(0.99)/ms << " ms, max: " << h.max()/ms << " ms" << endl;
+}
+
+// Write metrics of os to out as JSON lines or CSV depending on the file name
+void DumpMetrics(const OS& os, const string& path, ostream& out, bool first) {
+  if (path.size() >= 4 && path.compare(path.size()-4, 4, ".csv") == 0)
+    WriteMetricsCSV(os.metrics(), os.clock(), out, first);
+  else WriteMetricsJSON(os.metrics(), os.clock(), out);
+}
+
+// Service times of simulated devices
+const ServiceTimes kServiceTimes{20*kMillisecond, 10*kMillisecond,
+                                 15*kMillisecond};
+
+// Apply workload option with value to params. Returns false if option is not
+// a workload option, otherwise stores whether value is valid in valid.
+bool WorkloadOption(const string& option, const char* value,
+                    WorkloadParams* params, bool* valid) {
+  char* end = nullptr;
+  *valid = true;
+  if (option == "--processes") params->processes = strtoull(value, &end, 10);
+  else if (option == "--seed") params->seed = strtoull(value, &end, 10);
+  else if (option == "--interarrival") params->mean_interarrival = strtod(value, &end);
+  else if (option == "--burst") params->mean_burst = strtod(value, &end);
+  else if (option == "--max-slices") params->max_burst_slices = strtol(value, &end, 10);
+  else if (option == "--max-nice") params->max_nice = strtol(value, &end, 10);
+  else if (option == "--arrivals") *valid = ParsePattern(value, &params->arrivals);
+  else if (option == "--cylinders") *valid = ParsePattern(value, &params->cylinders);
+  else return false;
+  // numeric options
+  if (end != nullptr) *valid = (*value != '\0' && *end == '\0');
+  return true;
+}
+
+// Apply TLB option with value to tlb. Returns false if option is not a TLB
+// option, otherwise stores whether value is valid in valid.
+bool TLBOption(const string& option, const char* value, TLBParams* tlb,
+               bool* valid) {
+  char* end = nullptr;
+  *valid = true;
+  if (option == "--tlb") tlb->entries = strtol(value, &end, 10);
+  else if (option == "--tlb-ways") tlb->ways = strtol(value, &end, 10);
+  else if (option == "--tlb-policy") *valid = ParseTLBPolicy(value, &tlb->policy);
+  else return false;
+  if (end != nullptr) *valid = (*value != '\0' && *end == '\0');
+  return true;
+}
+
+// Apply CPU scheduling option with value to scheduler. Returns false if
+// option is not a scheduling option, otherwise stores whether value is valid
+// in valid.
+bool SchedulerOption(const string& option, const char* value,
+                     SchedulerParams* scheduler, bool* valid) {
+  char* end = nullptr;
+  *valid = true;
+  if (option == "--scheduler") *valid = ParseCPUPolicy(value, &scheduler->policy);
+  else if (option == "--levels") scheduler->levels = strtol(value, &end, 10);
+  else if (option == "--boost") scheduler->boost_interval = strtol(value, &end, 10);
+  else if (option == "--latency") scheduler->target_latency = strtol(value, &end, 10);
+  else if (option == "--granularity") scheduler->min_granularity = strtol(value, &end, 10);
+  else return false;
+  if (end != nullptr) *valid = (*value != '\0' && *end == '\0');
+  return true;
+}
+
+// Default run queues: round robin; 4 levels boosted every second for
+// multilevel queues; 40 ms target latency and 5 ms slices at least for
+// completely fair scheduling
+const SchedulerParams kDefaultScheduler{CPUPolicy::round_robin, 4, 1000, 40, 5};
+
+// Default device timings when enabled: 4 KB reads; disks seeking in 1 ms
+// plus 0.1 ms per square root of the cylinders, at 7200 rpm and 100 MB/s;
+// printers taking 5 ms per job and printing 2 KB/ms; CD/RWs reaching the
+// track in 50 ms, reading 7.2 MB/s (48x) and writing 1.8 MB/s (12x)
+const DeviceTimings kDefaultTimings{false, 4096, 1000, 100, 7200, 100000,
+                                    5000, 2000, 50000, 7200, 1800};
+
+// Apply device timing option with value to timings, which any of them
+// enables. Returns false if option is not a timing option, otherwise stores
+// whether value is valid in valid.
+bool TimingOption(const string& option, const char* value,
+                  DeviceTimings* timings, bool* valid) {
+  char* end = nullptr;
+  if (option == "--read-size") timings->read_size = strtol(value, &end, 10);
+  else if (option == "--seek-settle") timings->seek_settle = strtol(value, &end, 10);
+  else if (option == "--seek-time") timings->seek_per_cylinder = strtol(value, &end, 10);
+  else if (option == "--rpm") timings->rpm = strtol(value, &end, 10);
+  else if (option == "--disk-rate") timings->disk_rate = strtol(value, &end, 10);
+  else if (option == "--printer-rate") timings->printer_rate = strtol(value, &end, 10);
+  else if (option == "--cd-read-rate") timings->cd_read_rate = strtol(value, &end, 10);
+  else if (option == "--cd-write-rate") timings->cd_write_rate = strtol(value, &end, 10);
+  else return false;
+  timings->enabled = true;
+  *valid = (*value != '\0' && *end == '\0');
+  return true;
+}
+
+// Read the Sysgen parameters of the configuration file (.ini) or at the start
+// of the text file at path into sysgen, with a single CPU. Returns false after
+// printing the error if the file can not be read or parsed.
+bool LoadSysgen(const char* path, SysgenParams* sysgen) {
+  size_t len = strlen(path);
+  if (len >= 4 && strcmp(path + len - 4, ".ini") == 0) {
+    string error;
+    if (!LoadConfig(path, sysgen, &error)) {
+      cerr << error << endl;
+      return false;
+    }
+    return true;
+  }
+  MappedFile file{path};
+  if (!file.is_open()) {
+    cerr << "Can not open " << path << endl;
+    return false;
+  }
+  Tokenizer tokens{file.data(), file.data() + file.size()};
+  string error;
+  if (!ParseSysgen(tokens, sysgen, &error)) {
+    cerr << error << endl;
+    return false;
+  }
+  return true;
+}
+
+// Simulate a synthetic workload on the system described by the Sysgen
+// parameters at the start of the text file at path. options are the
+// remaining command line arguments. Returns exit status.
+int Simulate(const char* path, int num_options, char* options[]) {
+  WorkloadParams params;
+  int cpu_num = 1;
+  bool cpu_affinity = false;
+  ReplacementPolicy page_replacement = ReplacementPolicy::none;
+  PageTableKind page_tables = PageTableKind::dense;
+  TLBParams tlb{};  // fully associative unless ways are given
+  SchedulerParams scheduler = kDefaultScheduler;
+  DeviceTimings timings = kDefaultTimings;
+  string metrics_path;
+  double metrics_interval = 0;  // ms, only at the end if 0
+  for (int i = 0; i < num_options; i++) {
+    string option = options[i];
+    if (option == "--affinity" || option == "--asid" ||
+        option == "--device-timings") {
+      if (option == "--affinity") cpu_affinity = true;
+      else if (option == "--asid") tlb.asid = true;
+      else timings.enabled = true;
+      continue;
+    }
+    bool valid = (i+1 < num_options);
+    if (valid) {
+      const char* value = options[++i];
+      char* end = nullptr;
+      if (WorkloadOption(option, value, &params, &valid) ||
+          TLBOption(option, value, &tlb, &valid) ||
+          SchedulerOption(option, value, &scheduler, &valid) ||
+          TimingOption(option, value, &timings, &valid)) {}
+      else if (option == "--cpus") cpu_num = strtol(value, &end, 10);
+      else if (option == "--metrics-interval") metrics_interval = strtod(value, &end);
+      else if (option == "--metrics") metrics_path = value;
+      else if (option == "--paging") valid = ParseReplacement(value, &page_replacement);
+      else if (option == "--page-table") valid = ParsePageTable(value, &page_tables);
+      else valid = false;
+      // numeric options
+      if (end != nullptr) valid = (*value != '\0' && *end == '\0');
+    }
+    if (!valid || metrics_interval < 0) {
+      cerr << "Invalid option: " << option << endl;
+      return 1;
+    }
+  }
+  string error;
+  if (!ValidWorkload(params, &error)) {
+    cerr << error << endl;
+    return 1;
+  }
+
+  SysgenParams sysgen{};
+  if (!LoadSysgen(path, &sysgen)) return 1;
+  sysgen.cpu_num = cpu_num;
+  sysgen.cpu_affinity = cpu_affinity;
+  sysgen.page_replacement = page_replacement;
+  sysgen.page_tables = page_tables;
+  sysgen.scheduler = scheduler;
+  sysgen.device_timings = timings;
+  sysgen.tlb = tlb;
+  if (tlb.ways == 0) sysgen.tlb.ways = tlb.entries;
+  if (!ValidSysgen(sysgen, &error)) {
+    cerr << error << endl;
+    return 1;
+  }
+
+  ofstream metrics_out;
+  if (!metrics_path.empty()) {
+    metrics_out.open(metrics_path);
+    if (!metrics_out) {
+      cerr << "Can not write " << metrics_path << endl;
+      return 1;
+    }
+  }
+
+  OS os{sysgen};
+  SyntheticWorkload workload{params, os};
+  Simulator sim{os, workload, kServiceTimes};
+  auto start = chrono::steady_clock::now();
+  bool first_dump = true;
+  if (metrics_out.is_open() && metrics_interval > 0) {
+    SimTime interval = max<SimTime>(1, metrics_interval*kMillisecond);
+    while (!sim.idle()) {
+      sim.RunUntil(sim.now() + interval);
+      DumpMetrics(os, metrics_path, metrics_out, first_dump);
+      first_dump = false;
+    }
+  }
+  else {
+    sim.RunUntilIdle();
+    if (metrics_out.is_open()) DumpMetrics(os, metrics_path, metrics_out, true);
+  }
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() -
+                                            start).count();
+
+  const SimStats& stats = sim.stats();
+  cout << "Simulated time: " << (double)sim.now()/kMillisecond << " ms"
+       << ", events: " << stats.events
+       << ", time: " << seconds << " s"
+       << ", events/s: " << stats.events/seconds << endl;
+  cout << "Processes: " << stats.arrivals
+       << ", rejected: " << stats.rejected
+       << ", completed: " << stats.completed
+       << ", I/O requests: " << stats.io_requests
+       << ", CPU utilization: " << os.metrics().cpu_utilization(os.clock())
+       << ", frame utilization: "
+       << os.metrics().frame_utilization(os.clock()) << endl;
+  if (os.cpu_num() > 1) {
+    for (int c = 0; c < os.cpu_num(); c++) {
+      const CoreMetrics& core = os.metrics().cores[c];
+      cout << "CPU " << c << " utilization: "
+           << (os.clock() == 0 ? 0 : (double)core.busy/os.clock())
+           << ", migrations: " << core.migrations
+           << ", steals: " << core.steals << endl;
+    }
+  }
+  if (page_replacement != ReplacementPolicy::none) {
+    const Metrics& m = os.metrics();
+    cout << "Page references: " << m.page_references
+         << ", faults: " << m.page_faults
+         << ", fault rate: " << m.fault_rate()
+         << ", evictions: " << m.evictions
+         << ", dirty evictions: " << m.dirty_evictions
+         << ", mean faults per process: " << m.process_faults.mean() << endl;
+  }
+  if (tlb.entries > 0) {
+    const Metrics& m = os.metrics();
+    cout << "TLB lookups: " << m.tlb_lookups
+         << ", hit rate: " << m.tlb_hit_rate()
+         << ", flushes: " << m.tlb_flushes
+         << ", shootdowns: " << m.tlb_shootdowns
+         << ", effective access time: " << m.effective_access_ns() << " ns"
+         << endl;
+  }
+  cout << "Page tables (" << PageTableName(page_tables) << ") walks: "
+       << os.metrics().page_walks << ", accesses per walk: "
+       << os.metrics().walk_cost() << ", peak bytes: "
+       << os.metrics().peak_page_table_bytes << endl;
+  PrintLatency("Ready queue waits", os.metrics().ready_wait);
+  cout << "Fairness of weighted CPU shares: " << os.metrics().fairness() << endl;
+  if (scheduler.policy == CPUPolicy::mlfq) {
+    cout << "Priority boosts: " << os.metrics().boosts << endl;
+    for (size_t l = 0; l < os.metrics().levels.size(); l++) {
+      const LevelMetrics& level = os.metrics().levels[l];
+      cout << "Level " << l << " (" << level.quantum << " ms): mean depth: "
+           << (os.clock() == 0 ? 0 : (double)level.depth_time/os.clock())
+           << ", demotions: " << level.demotions
+           << ", promotions: " << level.promotions << endl;
+      PrintLatency(("Level " + to_string(l) + " waits").c_str(), level.wait);
+    }
+  }
+  PrintLatency("Job pool waits", os.metrics().job_pool_wait);
+  PrintLatency("Turnaround", os.metrics().turnaround);
+  for (const auto& d: os.metrics().devices) {
+    PrintLatency((DeviceName(d) + " waits").c_str(), d.wait);
+    if (!timings.enabled) continue;
+    PrintLatency((DeviceName(d) + " service").c_str(), d.service);
+    cout << DeviceName(d) << " utilization: "
+         << (os.clock() == 0 ? 0 : (double)d.busy/os.clock());
+    if (d.type == 'd') cout << ", seek distance: " << d.seek_distance;
+    cout << endl;
+  }
+  return 0;
+}
+
+// Store the comma separated integers of value in list. Returns false if
+// value is not such a list.
+bool ParseList(const char* value, vector<int>* list) {
+  list->clear();
+  while (true) {
+    char* end = nullptr;
+    long n = strtol(value, &end, 10);
+    if (end == value) return false;
+    list->push_back(n);
+    if (*end == '\0') return true;
+    if (*end != ',') return false;
+    value = end + 1;
+  }
+}
+
+// Store the comma separated names of value in list, each looked up with
+// parse (e.g. ParseReplacement). Returns false if value is not such a list.
+template<typename T>
+bool ParseNames(const char* value, bool (*parse)(const string&, T*),
+                vector<T>* list) {
+  list->clear();
+  string names = value;
+  size_t start = 0;
+  while (true) {
+    size_t comma = names.find(',', start);
+    T item;
+    if (!parse(names.substr(start, comma - start), &item)) return false;
+    list->push_back(item);
+    if (comma == string::npos) return true;
+    start = comma + 1;
+  }
+}
+
+// Simulate a synthetic workload on every combination of Sysgen parameters
+// swept by options around the parameters in the text file at path, on a pool
+// of threads, and write the results as a CSV table. Returns exit status.
+int Sweep(const char* path, int num_options, char* options[]) {
+  WorkloadParams params;
+  SweepGrid grid;
+  TLBParams tlb{};
+  SchedulerParams scheduler = kDefaultScheduler;
+  DeviceTimings timings = kDefaultTimings;
+  long threads = 0;
+  string out_path;
+  for (int i = 0; i < num_options; i++) {
+    string option = options[i];
+    if (option == "--asid" || option == "--device-timings") {
+      if (option == "--asid") tlb.asid = true;
+      else timings.enabled = true;
+      continue;
+    }
+    bool valid = (i+1 < num_options);
+    if (valid) {
+      const char* value = options[++i];
+      char* end = nullptr;
+      if (WorkloadOption(option, value, &params, &valid) ||
+          TLBOption(option, value, &tlb, &valid) ||
+          SchedulerOption(option, value, &scheduler, &valid) ||
+          TimingOption(option, value, &timings, &valid)) {}
+      else if (option == "--time-slices") valid = ParseList(value, &grid.time_slices);
+      else if (option == "--page-sizes") valid = ParseList(value, &grid.page_sizes);
+      else if (option == "--mem-sizes") valid = ParseList(value, &grid.mem_sizes);
+      else if (option == "--max-proc-sizes") valid = ParseList(value, &grid.max_proc_sizes);
+      else if (option == "--cpus") valid = ParseList(value, &grid.cpu_nums);
+      else if (option == "--printers") valid = ParseList(value, &grid.printer_nums);
+      else if (option == "--disks") valid = ParseList(value, &grid.disk_nums);
+      else if (option == "--cds") valid = ParseList(value, &grid.cd_nums);
+      else if (option == "--paging")
+        valid = ParseNames(value, ParseReplacement, &grid.page_replacements);
+      else if (option == "--page-tables")
+        valid = ParseNames(value, ParsePageTable, &grid.page_tables);
+      else if (option == "--schedulers")
+        valid = ParseNames(value, ParseCPUPolicy, &grid.schedulers);
+      else if (option == "--threads") threads = strtol(value, &end, 10);
+      else if (option == "--out") out_path = value;
+      else valid = false;
+      if (end != nullptr) valid = (*value != '\0' && *end == '\0');
+    }
+    if (!valid || threads < 0) {
+      cerr << "Invalid option: " << option << endl;
+      return 1;
+    }
+  }
+  string error;
+  if (!ValidWorkload(params, &error)) {
+    cerr << error << endl;
+    return 1;
+  }
+  SysgenParams base{};
+  if (!LoadSysgen(path, &base)) return 1;
+  base.tlb = tlb;
+  if (tlb.ways == 0) base.tlb.ways = tlb.entries;
+  base.scheduler = scheduler;
+  base.device_timings = timings;
+
+  ofstream file_out;
+  if (!out_path.empty()) {
+    file_out.open(out_path);
+    if (!file_out) {
+      cerr << "Can not write " << out_path << endl;
+      return 1;
+    }
+  }
+  ostream& out = out_path.empty() ? cout : file_out;
+
+  vector<SysgenParams> configs = ExpandGrid(base, grid);
+  auto start = chrono::steady_clock::now();
+  vector<SweepResult> results = RunSweep(configs, params, kServiceTimes, threads);
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() -
+                                            start).count();
+  WriteSweepCSV(results, out);
+  size_t invalid = 0;
+  for (const auto& r: results) invalid += !r.error.empty();
+  cerr << "Configurations: " << configs.size() << ", invalid: " << invalid
+       << ", time: " << seconds << " s" << endl;
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  // run.me --replay <trace> [--summary] [--restore <checkpoint>]
+  //        [--checkpoint <checkpoint>]
+  // run.me --restore <checkpoint>
+  // run.me --config <configuration file>
+  // run.me --convert <text trace> <binary trace>
+  // run.me --simulate <sysgen file> [workload options]
+  // run.me --sweep <sysgen file> [workload and grid options]
+  // OS of a checkpoint or configuration file, Sysgen() asks for one otherwise
+  unique_ptr<OS> loaded;
+  if (argc > 1) {
+    if (argc >= 3 && strcmp(argv[1], "--replay") == 0) {
+      bool print_summary = false;
+      const char* restore_path = nullptr;
+      const char* checkpoint_path = nullptr;
+      bool valid = true;
+      for (int i = 3; i < argc && valid; i++) {
+        if (strcmp(argv[i], "--summary") == 0) print_summary = true;
+        else if (i+1 < argc && strcmp(argv[i], "--restore") == 0)
+          restore_path = argv[++i];
+        else if (i+1 < argc && strcmp(argv[i], "--checkpoint") == 0)
+          checkpoint_path = argv[++i];
+        else valid = false;
+      }
+      if (valid) return Replay(argv[2], print_summary, restore_path, checkpoint_path);
+    }
+    if (argc == 4 && strcmp(argv[1], "--convert") == 0) {
+      string error;
+      if (!ConvertTrace(argv[2], argv[3], &error)) {
+        cerr << error << endl;
+        return 1;
+      }
+      return 0;
+    }
+    if (argc >= 3 && strcmp(argv[1], "--simulate") == 0) {
+      return Simulate(argv[2], argc-3, argv+3);
+    }
+    if (argc >= 3 && strcmp(argv[1], "--sweep") == 0) {
+      return Sweep(argv[2], argc-3, argv+3);
+    }
+    if (argc == 3 && strcmp(argv[1], "--restore") == 0) {
+      string error;
+      if (!LoadCheckpoint(argv[2], &loaded, &error)) {
+        cerr << error << endl;
+        return 1;
+      }
+    }
+    else if (argc == 3 && strcmp(argv[1], "--config") == 0) {
+      SysgenParams sysgen{};
+      if (!LoadSysgen(argv[2], &sysgen)) return 1;
+      loaded.reset(new OS{sysgen});
+    }
+    else {
+      cerr << "Usage: " << argv[0] << " [--replay <trace> [--summary]"
+           << " [--restore <checkpoint>] [--checkpoint <checkpoint>]]" << endl
+           << "       " << argv[0] << " [--restore <checkpoint>]" << endl
+           << "       " << argv[0] << " [--config <configuration file>]" << endl
+           << "       " << argv[0] << " [--convert <text trace> <binary trace>]"
+           << endl
+           << "       " << argv[0] << " [--simulate <sysgen file> [--processes n]"
+           << " [--seed n] [--cpus n] [--affinity]"
+           << " [--paging none/fifo/second-chance/clock]"
+           << " [--page-table dense/2-level/3-level/inverted]"
+           << " [--scheduler rr/mlfq/cfs [--levels n] [--boost ms]"
+           << " [--latency ms] [--granularity ms]]"
+           << " [--tlb entries [--tlb-ways n] [--tlb-policy lru/fifo/random] [--asid]]"
+           << " [--device-timings] [--seek-settle us] [--seek-time us] [--rpm n]"
+           << " [--disk-rate/--printer-rate/--cd-read-rate/--cd-write-rate bytes/ms]"
+           << " [--read-size bytes]"
+           << " [--arrivals poisson/bursty] [--interarrival ms]"
+           << " [--burst ms] [--max-slices n] [--max-nice n]"
+           << " [--cylinders uniform/hot-spot/sequential]"
+           << " [--metrics <json/csv file> [--metrics-interval ms]]]" << endl
+           << "       " << argv[0] << " [--sweep <sysgen file> [workload options]"
+           << " [--time-slices/--page-sizes/--mem-sizes/--max-proc-sizes/--cpus/"
+           << "--printers/--disks/--cds n,n,...] [--paging policy,...]"
+           << " [--page-tables kind,...] [--schedulers policy,...]"
+           << " [TLB, scheduler and device timing options]"
+           << " [--threads n] [--out <csv file>]]"
+           << endl;
+      return 1;
+    }
+  }
+
+  OS os = loaded ? std::move(*loaded) : Sysgen();
 
   while (true) {
     cout << "Waiting for input: ";
@@ -20,10 +574,10 @@ int main() {
       invalid = false;
       cin >> input;
       if (input.size() == 1) {
-        if (input[0] == 'A') os.NewProcess();
-        else if (input[0] == 't') os.TerminateActiveProcess();
-        else if (input[0] == 'S') os.Snapshot();
-        else if (input[0] == 'T') os.EndOfTimeSlice();
+        if (input[0] == 'A') PromptNewProcess(os);
+        else if (input[0] == 't') PromptTerminate(os);
+        else if (input[0] == 'S') PromptSnapshot(os);
+        else if (input[0] == 'T') PromptEndOfTimeSlice(os);
         else invalid = true;
       }
       // all input of length 2 is upper/lowercase letter followed by number
@@ -33,7 +587,7 @@ int main() {
             string proc_num_str = input.substr(1, input.size()-1);
             char *p;
             int proc_num = strtoul(proc_num_str.c_str(), &p, 10);
-            if (!*p) os.Kill(proc_num);
+            if (!*p) PromptKill(os, proc_num);
             else invalid = true;
           }
           else {
@@ -48,7 +602,7 @@ int main() {
                   (device_type == 'D' && device_num > os.get_disk_num()) ||
                   (device_type == 'C' && device_num > os.get_cd_num()))
                 invalid = true;
-              else os.HandleInterrupt(device_type, device_num);
+              else PromptInterrupt(os, device_type, device_num);
             }
             else invalid = true;
           }
@@ -66,7 +620,7 @@ int main() {
                 (device_type == 'd' && device_num > os.get_disk_num()) ||
                 (device_type == 'c' && device_num > os.get_cd_num()))
               invalid = true;
-            else os.IORequest(device_type, device_num);
+            else PromptIORequest(os, device_type, device_num);
           }
           else invalid = true;
         }
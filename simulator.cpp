@@ -0,0 +1,187 @@
+#include "simulator.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace os_ops {
+
+  void EventQueue::push(const Event& e) {
+    heap.push_back(e);
+    size_t i = heap.size() - 1;
+    while (i > 0) {
+      size_t parent = (i - 1)/4;
+      if (!Earlier(e, heap[parent])) break;
+      heap[i] = heap[parent];
+      i = parent;
+    }
+    heap[i] = e;
+  }
+
+  void EventQueue::pop() {
+    Event last = heap.back();
+    heap.pop_back();
+    if (heap.empty()) return;
+    size_t n = heap.size(), i = 0;
+    while (true) {
+      size_t first = 4*i + 1;
+      if (first >= n) break;
+      size_t last_child = std::min(first + 4, n);
+      size_t min = first;
+      for (size_t c = first + 1; c < last_child; c++) {
+        if (Earlier(heap[c], heap[min])) min = c;
+      }
+      if (!Earlier(heap[min], last)) break;
+      heap[i] = heap[min];
+      i = min;
+    }
+    heap[i] = last;
+  }
+
+  Simulator::Simulator(OS& os, Workload& workload, const ServiceTimes& service) :
+      os(os), workload(workload), service{service} {
+    // same device order as the OS
+    const char types[] = {'c', 'd', 'p'};
+    const size_t counts[] = {os.get_cd_num(), os.get_disk_num(),
+                             os.get_printer_num()};
+    for (int t = 0; t < 3; t++) {
+      for (size_t n = 1; n <= counts[t]; n++) {
+        device_types.push_back(types[t]);
+        device_nums.push_back(n);
+      }
+    }
+    device_queued.assign(device_types.size(), 0);
+    cpu_scheduled.assign(os.cpu_num(), false);
+    ScheduleArrival();
+    CheckCPU();
+  }
+
+  size_t Simulator::RunUntil(SimTime end) {
+    size_t handled = 0;
+    while (!events.empty() && events.top().time <= end) {
+      Step();
+      handled++;
+    }
+    clock = std::max(clock, end);
+    os.AdvanceClock(clock);
+    return handled;
+  }
+
+  size_t Simulator::RunUntilIdle() {
+    size_t handled = 0;
+    while (!events.empty()) {
+      Step();
+      handled++;
+    }
+    return handled;
+  }
+
+  void Simulator::Schedule(SimTime time, EventType type, int arg) {
+    events.push(Event{time, next_seq++, type, arg});
+  }
+
+  void Simulator::Step() {
+    Event e = events.top();
+    events.pop();
+    clock = e.time;
+    os.AdvanceClock(clock);
+    sim_stats.events++;
+    switch (e.type) {
+      case EventType::arrival: HandleArrival(e.arg); break;
+      case EventType::cpu:     HandleCPU(e.arg); break;
+      case EventType::device:  HandleDevice(e.arg); break;
+    }
+    CheckCPU();
+  }
+
+  void Simulator::ScheduleArrival() {
+    SimTime time;
+    int size;
+    if (workload.NextArrival(time, size)) {
+      Schedule(std::max(time, clock), EventType::arrival, size);
+    }
+  }
+
+  void Simulator::CheckCPU() {
+    for (int core = 0; core < os.cpu_num(); core++) {
+      const PCB* active = os.active(core);
+      if (cpu_scheduled[core] || active == nullptr) continue;
+      auto found = pending.find(active->pid);
+      if (found == pending.end()) {
+        ProcessAction action = workload.NextAction(active);
+        found = pending.emplace(active->pid,
+                                Pending{action, std::max(action.burst, 0)}).first;
+      }
+      int run = std::min(found->second.remaining, os.quantum(core));
+      Schedule(clock + run*kMillisecond, EventType::cpu, core);
+      cpu_scheduled[core] = true;
+    }
+  }
+
+  void Simulator::StartService(int index) {
+    SimTime duration = 0;
+    // with timings the device takes its next request now and the time
+    // depends on it, otherwise every request of a device type takes as long
+    // and the device picks one when it completes
+    if (os.device_timings().enabled) {
+      os.StartService(device_types[index], device_nums[index], &duration);
+    }
+    else {
+      switch (device_types[index]) {
+        case 'c': duration = service.cd; break;
+        case 'd': duration = service.disk; break;
+        case 'p': duration = service.printer; break;
+      }
+    }
+    Schedule(clock + duration, EventType::device, index);
+  }
+
+  void Simulator::HandleArrival(int size) {
+    if (os.NewProcess(size, nullptr, workload.ArrivalNice()) == Status::ok)
+      sim_stats.arrivals++;
+    else sim_stats.rejected++;
+    ScheduleArrival();
+  }
+
+  void Simulator::HandleCPU(int core) {
+    cpu_scheduled[core] = false;
+    const PCB* active = os.active(core);
+    auto found = pending.find(active->pid);
+    Pending& p = found->second;
+
+    // time slice ran out before the action
+    int quantum = os.quantum(core);
+    if (p.remaining > quantum) {
+      p.remaining -= quantum;
+      sim_stats.cpu_busy += quantum*kMillisecond;
+      os.EndOfTimeSlice(core);
+      return;
+    }
+
+    sim_stats.cpu_busy += p.remaining*kMillisecond;
+    const ProcessAction& action = p.action;
+    if (action.device_type != 0) {
+      int index = os.DeviceIndex(action.device_type, action.device_num);
+      if (index >= 0 && os.IORequest(action.device_type, action.device_num,
+                                     p.remaining, action.io, nullptr,
+                                     core) == Status::ok) {
+        // next action is asked for when the process gets the CPU again
+        pending.erase(found);
+        if (device_queued[index]++ == 0) StartService(index);
+        return;
+      }
+      sim_stats.rejected++;
+    }
+    // terminate, also if the OS rejected the I/O request so the process
+    // does not retry forever
+    os.TerminateActiveProcess(p.remaining, nullptr, core);
+    pending.erase(found);
+    sim_stats.completed++;
+  }
+
+  void Simulator::HandleDevice(int index) {
+    os.HandleInterrupt(toupper(device_types[index]), device_nums[index]);
+    sim_stats.io_requests++;
+    if (--device_queued[index] > 0) StartService(index);
+  }
+
+}
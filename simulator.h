@@ -0,0 +1,143 @@
+// Discrete-event simulation around the headless OS API. A virtual clock
+// advances from event to event: process arrivals, CPU bursts ending or
+// running out their time slice on each CPU, and device completions after a
+// service time. What processes do is decided by a Workload.
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "os.h"
+
+namespace os_ops {
+
+enum class EventType : uint8_t {arrival, cpu, device};
+
+// Timestamped event. Events at the same time are handled in the order they
+// were scheduled (seq), so a simulation is deterministic.
+struct Event {
+  SimTime time;
+  uint64_t seq;
+  EventType type;
+  int arg;  // process size of arrivals, CPU of CPU events, device index of
+            // device completions
+};
+
+// Min-heap of events with 4 children per node, which halves the depth of a
+// binary heap and keeps the children of a node in one cache line
+class EventQueue {
+  public:
+    bool empty() const {return heap.empty();}
+    size_t size() const {return heap.size();}
+    const Event& top() const {return heap.front();}
+    void push(const Event& e);
+    void pop();
+
+  private:
+    std::vector<Event> heap;
+
+    static bool Earlier(const Event& e1, const Event& e2) {
+      return e1.time < e2.time || (e1.time == e2.time && e1.seq < e2.seq);
+    }
+};
+
+// What a process does after its next CPU burst
+struct ProcessAction {
+  int burst;         // ms of CPU time until the action
+  char device_type;  // c/d/p for an I/O request, 0 to terminate
+  int device_num;
+  IOParams io;       // file_name must stay valid until the request completes
+};
+
+// Source of process arrivals and behaviour for a Simulator
+class Workload {
+  public:
+    virtual ~Workload() = default;
+    // Store time and size of the next arrival. Returns false if there are no
+    // more arrivals. Times must not decrease.
+    virtual bool NextArrival(SimTime& time, int& size) = 0;
+    // Nice value of a process arriving now
+    virtual int ArrivalNice() {return 0;}
+    // Next action of process, called whenever it gets the CPU after arriving
+    // or completing an I/O request
+    virtual ProcessAction NextAction(const PCB* process) = 0;
+};
+
+// Time a device takes to service one request, unless the OS has device
+// timings
+struct ServiceTimes {
+  SimTime printer, disk, cd;
+};
+
+// Counters of a simulation
+struct SimStats {
+  size_t events = 0;
+  size_t arrivals = 0;      // processes created
+  size_t rejected = 0;      // arrivals and I/O requests the OS rejected
+  size_t completed = 0;     // processes terminated
+  size_t io_requests = 0;   // I/O requests completed
+  SimTime cpu_busy = 0;     // time CPUs ran a process, summed over CPUs
+};
+
+class Simulator {
+  public:
+    Simulator(OS& os, Workload& workload, const ServiceTimes& service);
+
+    // disable copy constructor and assignment operator
+    Simulator(const Simulator&) = delete;
+    Simulator& operator=(const Simulator&) = delete;
+
+    SimTime now() const {return clock;}
+    const SimStats& stats() const {return sim_stats;}
+    // true when no more events are scheduled
+    bool idle() const {return events.empty();}
+
+    // Handle all events up to time end and advance the clock to end.
+    // Returns the number of events handled.
+    size_t RunUntil(SimTime end);
+    // Handle events until none are left (no more arrivals and all processes
+    // terminated). Returns the number of events handled.
+    size_t RunUntilIdle();
+
+  private:
+    // CPU demand of a process until its pending action
+    struct Pending {
+      ProcessAction action;
+      int remaining;  // ms
+    };
+
+    OS& os;
+    Workload& workload;
+    ServiceTimes service;
+
+    EventQueue events;
+    SimTime clock = 0;
+    uint64_t next_seq = 0;
+    SimStats sim_stats;
+
+    std::unordered_map<size_t, Pending> pending;  // by pid
+    std::vector<char> cpu_scheduled;  // per CPU, burst end event pending
+    // per device in OS order cd/rw->disks->printers
+    std::vector<char> device_types;
+    std::vector<int> device_nums;
+    std::vector<int> device_queued;  // requests queued incl. one in service
+
+    void Schedule(SimTime time, EventType type, int arg = 0);
+    void Step();
+    void ScheduleArrival();
+    // Start a CPU burst on every CPU a process got
+    void CheckCPU();
+    // Start servicing the next request of device index if it has one
+    void StartService(int index);
+
+    void HandleArrival(int size);
+    void HandleCPU(int core);
+    void HandleDevice(int index);
+};
+
+}
+
+#endif
@@ -0,0 +1,169 @@
+#include "sweep.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace os_ops {
+
+  namespace {
+    // Combinations of the integer parameters of grid applied to base
+    void ExpandIntegers(const SysgenParams& base, const SweepGrid& grid,
+                        std::vector<SysgenParams>* configs) {
+      const std::vector<int>* axes[] = {
+          &grid.time_slices, &grid.page_sizes, &grid.mem_sizes,
+          &grid.max_proc_sizes, &grid.cpu_nums, &grid.printer_nums,
+          &grid.disk_nums, &grid.cd_nums};
+      const int num_of_axes = sizeof(axes)/sizeof(axes[0]);
+
+      // position in every non-empty axis, advanced like an odometer
+      std::vector<size_t> pos(num_of_axes, 0);
+      while (true) {
+        SysgenParams params = base;
+        int* fields[] = {&params.time_slice, &params.page_size, &params.mem_size,
+                         &params.max_proc_size, &params.cpu_num,
+                         &params.printer_num, &params.disk_num, &params.cd_num};
+        for (int a = 0; a < num_of_axes; a++) {
+          if (!axes[a]->empty()) *fields[a] = (*axes[a])[pos[a]];
+        }
+        if (params.disk_num >= 0) {
+          int cylinders = base.cyl_nums.empty() ? 0 : base.cyl_nums.back();
+          params.cyl_nums.resize(params.disk_num, cylinders);
+          if (!base.disk_policies.empty())
+            params.disk_policies.resize(params.disk_num, base.disk_policies.back());
+        }
+        configs->push_back(params);
+
+        int a = num_of_axes - 1;
+        for (; a >= 0; a--) {
+          if (axes[a]->empty()) continue;
+          if (++pos[a] < axes[a]->size()) break;
+          pos[a] = 0;
+        }
+        if (a < 0) return;
+      }
+    }
+  }
+
+  std::vector<SysgenParams> ExpandGrid(const SysgenParams& base,
+                                       const SweepGrid& grid) {
+    std::vector<SysgenParams> configs;
+    std::vector<ReplacementPolicy> policies = grid.page_replacements;
+    if (policies.empty()) policies.push_back(base.page_replacement);
+    std::vector<PageTableKind> kinds = grid.page_tables;
+    if (kinds.empty()) kinds.push_back(base.page_tables);
+    std::vector<CPUPolicy> schedulers = grid.schedulers;
+    if (schedulers.empty()) schedulers.push_back(base.scheduler.policy);
+    for (ReplacementPolicy policy: policies) {
+      for (PageTableKind kind: kinds) {
+        for (CPUPolicy scheduler: schedulers) {
+          SysgenParams params = base;
+          params.page_replacement = policy;
+          params.page_tables = kind;
+          params.scheduler.policy = scheduler;
+          ExpandIntegers(params, grid, &configs);
+        }
+      }
+    }
+    return configs;
+  }
+
+  namespace {
+    void Simulate(const WorkloadParams& params, const ServiceTimes& service,
+                  SweepResult* result) {
+      if (!ValidSysgen(result->sysgen, &result->error)) return;
+      auto start = std::chrono::steady_clock::now();
+      OS os{result->sysgen};
+      SyntheticWorkload workload{params, os};
+      Simulator sim{os, workload, service};
+      sim.RunUntilIdle();
+      result->stats = sim.stats();
+      result->time = sim.now();
+      result->metrics = os.metrics();
+      result->seconds = std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - start).count();
+    }
+  }
+
+  std::vector<SweepResult> RunSweep(const std::vector<SysgenParams>& configs,
+                                    const WorkloadParams& workload,
+                                    const ServiceTimes& service,
+                                    int num_of_threads) {
+    std::vector<SweepResult> results(configs.size());
+    for (size_t i = 0; i < configs.size(); i++) results[i].sysgen = configs[i];
+
+    if (num_of_threads <= 0) num_of_threads = std::thread::hardware_concurrency();
+    if ((size_t)num_of_threads > configs.size()) num_of_threads = configs.size();
+    // threads take the next parameter set until none are left, so long runs
+    // do not hold up a statically assigned share
+    std::atomic<size_t> next{0};
+    auto work = [&]() {
+      size_t i;
+      while ((i = next++) < results.size()) {
+        Simulate(workload, service, &results[i]);
+      }
+    };
+    std::vector<std::thread> threads;
+    for (int t = 1; t < num_of_threads; t++) threads.emplace_back(work);
+    work();
+    for (auto& thread: threads) thread.join();
+    return results;
+  }
+
+  void WriteSweepCSV(const std::vector<SweepResult>& results, std::ostream& out) {
+    std::streamsize precision = out.precision(12);
+    double ms = kMillisecond;
+    out << "printers,disks,cds,cpus,time_slice,page_size,mem_size,max_proc_size,"
+           "page_replacement,page_table,scheduler,simulated_ms,arrivals,rejected,completed,io_requests,"
+           "cpu_utilization,frame_utilization,mean_ready_depth,"
+           "ready_wait_mean_ms,ready_wait_p99_ms,fairness,turnaround_mean_ms,"
+           "turnaround_p50_ms,turnaround_p99_ms,job_pool_wait_mean_ms,"
+           "job_pool_wait_p99_ms,page_faults,fault_rate,evictions,tlb_hit_rate,"
+           "effective_access_ns,walk_cost,peak_page_table_bytes,"
+           "disk_service_mean_ms,disk_utilization,seek_distance,wall_s,error\n";
+    for (const auto& r: results) {
+      const SysgenParams& s = r.sysgen;
+      out << s.printer_num << ',' << s.disk_num << ',' << s.cd_num << ','
+          << s.cpu_num << ',' << s.time_slice << ',' << s.page_size << ','
+          << s.mem_size << ',' << s.max_proc_size << ','
+          << ReplacementName(s.page_replacement) << ','
+          << PageTableName(s.page_tables) << ','
+          << CPUPolicyName(s.scheduler.policy) << ',';
+      if (!r.error.empty()) {
+        out << std::string(27, ',') << '"' << r.error << "\"\n";
+        continue;
+      }
+      const Metrics& m = r.metrics;
+      // disks together
+      SimTime disk_busy = 0;
+      size_t disk_requests = 0;
+      long long seek_distance = 0;
+      for (const auto& d: m.devices) {
+        if (d.type != 'd') continue;
+        disk_busy += d.busy;
+        disk_requests += d.service.count();
+        seek_distance += d.seek_distance;
+      }
+      out << r.time/ms << ',' << r.stats.arrivals << ',' << r.stats.rejected
+          << ',' << r.stats.completed << ',' << r.stats.io_requests << ','
+          << m.cpu_utilization(r.time) << ',' << m.frame_utilization(r.time)
+          << ',' << (r.time == 0 ? 0 : (double)m.ready_depth_time/r.time) << ','
+          << m.ready_wait.mean()/ms << ',' << m.ready_wait.Quantile(0.99)/ms
+          << ',' << m.fairness() << ',' << m.turnaround.mean()/ms << ','
+          << m.turnaround.Quantile(0.5)/ms << ','
+          << m.turnaround.Quantile(0.99)/ms << ','
+          << m.job_pool_wait.mean()/ms << ','
+          << m.job_pool_wait.Quantile(0.99)/ms << ',' << m.page_faults << ','
+          << m.fault_rate() << ',' << m.evictions << ',' << m.tlb_hit_rate()
+          << ',' << m.effective_access_ns() << ',' << m.walk_cost() << ','
+          << m.peak_page_table_bytes << ','
+          << (disk_requests == 0 ? 0 : (double)disk_busy/disk_requests/ms) << ','
+          << (r.time == 0 || s.disk_num == 0 ? 0
+                                              : (double)disk_busy/r.time/s.disk_num)
+          << ',' << seek_distance << ',' << r.seconds << ",\n";
+    }
+    out.flush();
+    out.precision(precision);
+  }
+
+}
@@ -0,0 +1,58 @@
+// Parameter sweeps: every Sysgen parameter set of a grid is simulated with the
+// same synthetic workload on its own OS instance, spread over a pool of
+// threads, and the metrics are gathered into one table. Instances share no
+// state, so the results do not depend on the number of threads.
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "os.h"
+#include "simulator.h"
+#include "workload.h"
+
+namespace os_ops {
+
+// Values of the swept Sysgen parameters, every combination is simulated. An
+// empty list keeps the value of the base parameters.
+struct SweepGrid {
+  std::vector<int> time_slices, page_sizes, mem_sizes, max_proc_sizes;
+  std::vector<int> cpu_nums, printer_nums, disk_nums, cd_nums;
+  std::vector<ReplacementPolicy> page_replacements;
+  std::vector<PageTableKind> page_tables;
+  std::vector<CPUPolicy> schedulers;
+};
+
+// Combinations of grid applied to base, the page replacement policy varying
+// slowest, then the page table kind and the CPU scheduler, and cd/rws
+// fastest. Disks added to base get the cylinders and
+// policy of its last disk.
+std::vector<SysgenParams> ExpandGrid(const SysgenParams& base,
+                                     const SweepGrid& grid);
+
+// Outcome of simulating one parameter set
+struct SweepResult {
+  SysgenParams sysgen;
+  std::string error;    // rule violated by sysgen, empty if it was simulated
+  SimStats stats;
+  SimTime time = 0;     // simulated time
+  Metrics metrics;
+  double seconds = 0;   // wall clock time of the simulation
+};
+
+// Simulate workload on every parameter set in configs with num_of_threads
+// threads (one per hardware thread if <= 0). Results are in configs order.
+std::vector<SweepResult> RunSweep(const std::vector<SysgenParams>& configs,
+                                  const WorkloadParams& workload,
+                                  const ServiceTimes& service,
+                                  int num_of_threads);
+
+// Write results as CSV with a header line and one row per parameter set,
+// times in ms
+void WriteSweepCSV(const std::vector<SweepResult>& results, std::ostream& out);
+
+}
+
+#endif
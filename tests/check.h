@@ -0,0 +1,43 @@
+// Minimal checks shared by the tests. Every test is a program that runs its
+// cases, reports each failed CHECK with its line and returns TestResult()
+// from main, so make test stops at the first failing program.
+#ifndef TESTS_CHECK_H
+#define TESTS_CHECK_H
+
+#include <cstdint>
+#include <iostream>
+
+static int check_failures = 0;
+
+#define CHECK(condition)                                                    \
+  do {                                                                      \
+    if (!(condition)) {                                                     \
+      if (check_failures++ < 20)                                            \
+        std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition  \
+                  << ") failed" << std::endl;                               \
+    }                                                                       \
+  } while (false)
+
+// Exit status of a test program, with a summary line
+inline int TestResult(const char* name) {
+  if (check_failures == 0) std::cout << name << ": ok" << std::endl;
+  else std::cout << name << ": " << check_failures << " failed" << std::endl;
+  return check_failures == 0 ? 0 : 1;
+}
+
+// Random numbers of a fixed sequence on every platform (xorshift64*)
+class TestRandom {
+  public:
+    explicit TestRandom(uint64_t seed) : state{seed | 1} {}
+    // Uniform in [0, n) for n >= 1 (modulo bias is irrelevant here)
+    int Below(int n) {
+      state ^= state >> 12;
+      state ^= state << 25;
+      state ^= state >> 27;
+      return (int)((state*0x2545F4914F6CDD1Dull >> 33) % n);
+    }
+  private:
+    uint64_t state;
+};
+
+#endif
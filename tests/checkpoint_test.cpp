@@ -0,0 +1,179 @@
+// Checkpoints of systems with every kind of scheduler, memory and device
+// configuration, taken after random operations. The restored OS must print
+// the same snapshots and metrics as the saved one and keep behaving the same
+// under the same further operations. Truncated checkpoints and files that
+// are not checkpoints must be refused.
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+#include "checkpoint.h"
+#include "tests/check.h"
+
+using namespace os_ops;
+
+// One CPU and all pages loaded at admission, like traces
+static SysgenParams Simple() {
+  SysgenParams params{};
+  params.printer_num = 2;
+  params.disk_num = 2;
+  params.cd_num = 2;
+  params.cyl_nums = {50, 80};
+  params.disk_policies = {DiskPolicy::sstf, DiskPolicy::c_look};
+  params.time_slice = 10;
+  params.page_size = 4;
+  params.mem_size = 64;
+  params.max_proc_size = 32;
+  params.cpu_num = 1;
+  params.scheduler = SchedulerParams{CPUPolicy::round_robin, 1, 0, 0, 0};
+  return params;
+}
+
+// Several CPUs, demand paging, TLBs and multilevel page tables
+static SysgenParams Multilevel() {
+  SysgenParams params = Simple();
+  params.cpu_num = 3;
+  params.cpu_affinity = true;
+  params.page_replacement = ReplacementPolicy::clock;
+  params.tlb = TLBParams{16, 4, TLBPolicy::lru, true};
+  params.page_tables = PageTableKind::two_level;
+  params.scheduler = SchedulerParams{CPUPolicy::mlfq, 4, 100, 0, 0};
+  return params;
+}
+
+// Fair scheduling, an inverted page table and device timings
+static SysgenParams Fair() {
+  SysgenParams params = Simple();
+  params.cpu_num = 2;
+  params.contiguous_frames = true;
+  params.page_replacement = ReplacementPolicy::fifo;
+  params.tlb = TLBParams{8, 2, TLBPolicy::random, true};
+  params.page_tables = PageTableKind::inverted;
+  params.scheduler = SchedulerParams{CPUPolicy::cfs, 1, 0, 20, 4};
+  params.device_timings = DeviceTimings{true, 4096, 500, 100, 7200, 50000,
+                                        1000, 10000, 2000, 5000, 2000};
+  return params;
+}
+
+// Everything os prints about its state
+static std::string State(const OS& os) {
+  std::ostringstream out;
+  for (char snap_type: std::string("rpdcjm")) os.Snapshot(snap_type, out);
+  WriteMetricsJSON(os.metrics(), os.clock(), out);
+  return out.str();
+}
+
+// Apply a random operation to os, returning what it gave
+static std::string RandomOperation(OS& os, TestRandom& random) {
+  std::ostringstream out;
+  int core = random.Below(os.cpu_num());
+  const PCB* active = os.active(core);
+  int action = random.Below(10);
+  if (action < 3) {
+    size_t pid = 0;
+    int nice = random.Below(11);
+    Status status = os.NewProcess(1 + random.Below(os.max_process_size() + 4),
+                                  &pid, nice - 5);
+    out << StatusMessage(status) << " " << pid;
+  }
+  else if (action < 5 && active != nullptr) {
+    const char types[] = {'p', 'd', 'c'};
+    char device_type = types[random.Below(3)];
+    int device_num = 1 + random.Below(2);
+    IOParams io{"file", static_cast<int>(random.Below(active->size)), 'w', 0,
+                static_cast<int>(1 + random.Below(10000))};
+    if (device_type == 'd')
+      io.cylinder = random.Below(os.disk_cylinders(device_num));
+    size_t physical = 0;
+    int burst = 1 + random.Below(os.quantum(core));
+    out << StatusMessage(os.IORequest(device_type, device_num, burst, io,
+                                      &physical, core))
+        << " " << physical;
+  }
+  else if (action < 6) {
+    const char types[] = {'p', 'd', 'c'};
+    char device_type = types[random.Below(3)];
+    int device_num = 1 + random.Below(2);
+    SimTime duration = 0;
+    size_t pid = 0;
+    out << StatusMessage(os.StartService(device_type, device_num, &duration))
+        << " " << duration << " ";
+    out << StatusMessage(os.HandleInterrupt(device_type - 'a' + 'A',
+                                            device_num, &pid))
+        << " " << pid;
+  }
+  else if (action < 7) {
+    out << StatusMessage(os.EndOfTimeSlice(core));
+  }
+  else if (action < 8 && active != nullptr) {
+    int duration = 1 + random.Below(os.quantum(core));
+    out << StatusMessage(os.TimeSliceInterrupt(duration, core));
+  }
+  else if (action < 9 && active != nullptr) {
+    int burst = 1 + random.Below(os.quantum(core));
+    out << StatusMessage(os.TerminateActiveProcess(burst, nullptr, core));
+  }
+  else {
+    out << StatusMessage(os.Kill(random.Below(os.next_pid() + 3)));
+  }
+  return out.str();
+}
+
+static void RoundTrip(uint64_t seed, const SysgenParams& params,
+                      int operations) {
+  TestRandom random{seed};
+  OS os{params};
+  for (int i = 0; i < operations; i++) RandomOperation(os, random);
+
+  char path[] = "/tmp/checkpoint_testXXXXXX";
+  int fd = mkstemp(path);
+  CHECK(fd >= 0);
+  if (fd < 0) return;
+  close(fd);
+  std::string error;
+  CHECK(SaveCheckpoint(os, path, &error));
+  std::unique_ptr<OS> restored;
+  CHECK(LoadCheckpoint(path, &restored, &error));
+  if (restored == nullptr) {
+    unlink(path);
+    return;
+  }
+  CHECK(State(*restored) == State(os));
+
+  // both go on the same way
+  TestRandom random_restored = random;
+  for (int i = 0; i < operations; i++) {
+    std::string result = RandomOperation(os, random);
+    CHECK(RandomOperation(*restored, random_restored) == result);
+  }
+  CHECK(State(*restored) == State(os));
+
+  // a truncated checkpoint is refused
+  std::unique_ptr<OS> truncated;
+  FILE* file = fopen(path, "rb");
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fclose(file);
+  CHECK(truncate(path, size/2) == 0);
+  CHECK(!LoadCheckpoint(path, &truncated, &error));
+  CHECK(truncated == nullptr);
+  unlink(path);
+}
+
+int main() {
+  const SysgenParams configurations[] = {Simple(), Multilevel(), Fair()};
+  uint64_t seed = 1;
+  for (const SysgenParams& params: configurations) {
+    for (int run = 0; run < 3; run++) RoundTrip(seed++, params, 2000);
+  }
+
+  // neither a missing file nor one that is not a checkpoint is restored
+  std::unique_ptr<OS> os;
+  std::string error;
+  CHECK(!LoadCheckpoint("/nonexistent/checkpoint", &os, &error));
+  CHECK(!LoadCheckpoint("tests/data/replay.txt", &os, &error));
+  CHECK(os == nullptr);
+  return TestResult("checkpoint_test");
+}
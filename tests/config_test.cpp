@@ -0,0 +1,159 @@
+// Configuration files with random cylinder and policy settings for every
+// disk, as single values, lists with repeats and disk ranges, against the
+// settings applied one by one in file order. Files breaking a rule must be
+// refused with the reason and the line it is on.
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "tests/check.h"
+
+using namespace os_ops;
+
+static const char kScalars[] =
+    "[devices]\n"
+    "printers = 2   # two\n"
+    "cds = 1\n"
+    "[cpu]\n"
+    "time_slice = 10 ; ms\n"
+    "[memory]\n"
+    "page_size = 4\n"
+    "memory_size = 512\n"
+    "max_process_size = 64\n";
+
+static bool Parse(const std::string& text, SysgenParams* params,
+                  std::string* error) {
+  return ParseConfig(text.data(), text.size(), params, error);
+}
+
+// Write a random setting of key for num_of_disks disks to out and apply it
+// to values: one value for every disk, a list of runs or a disk range
+template<typename T, typename Random>
+static void RandomSetting(const char* key, int num_of_disks, bool all,
+                          Random random_value, TestRandom& random,
+                          std::ostream& out, std::vector<T>* values) {
+  int form = all ? random.Below(2) : 2;
+  if (form == 0) {
+    T value = random_value();
+    out << key << " = " << value << "\n";
+    values->assign(num_of_disks, value);
+  }
+  else if (form == 1) {
+    out << key << " =";
+    values->clear();
+    while ((int)values->size() < num_of_disks) {
+      int count = 1 + random.Below(num_of_disks - values->size());
+      T value = random_value();
+      out << (values->empty() ? " " : ", ") << value;
+      if (count > 1 || random.Below(2)) out << "*" << count;
+      values->insert(values->end(), count, value);
+    }
+    out << "\n";
+  }
+  else {
+    int first = 1 + random.Below(num_of_disks);
+    int last = first + random.Below(num_of_disks - first + 1);
+    T value = random_value();
+    out << key << "[" << first;
+    if (last != first || random.Below(2)) out << "-" << last;
+    out << "] = " << value << "\n";
+    for (int disk = first; disk <= last; disk++) (*values)[disk - 1] = value;
+  }
+}
+
+static void RandomDisks(uint64_t seed) {
+  TestRandom random{seed};
+  int num_of_disks = 1 + random.Below(20);
+  std::ostringstream text;
+  text << kScalars;
+  // disks follows from the first list of cylinders if not given
+  if (random.Below(2)) text << "disks = " << num_of_disks << "\ncylinders = 1\n";
+  else text << "cylinders = 1*" << num_of_disks << "\n";
+  text << "[disks]\n";
+
+  auto cylinders = [&random]() {return (int)random.Below(1000);};
+  auto policy = [&random]() {
+    return PolicyName(static_cast<DiskPolicy>(random.Below(7)));
+  };
+  std::vector<int> cyl_nums(num_of_disks, 1);
+  std::vector<std::string> policies(num_of_disks, "fscan");
+  for (int settings = random.Below(6); settings >= 0; settings--) {
+    bool all = settings == 0 || random.Below(3) == 0;
+    if (random.Below(2)) {
+      RandomSetting("cylinders", num_of_disks, all, cylinders, random, text,
+                    &cyl_nums);
+    }
+    else {
+      RandomSetting("policy", num_of_disks, all, policy, random, text,
+                    &policies);
+    }
+  }
+
+  SysgenParams params{};
+  std::string error;
+  CHECK(Parse(text.str(), &params, &error));
+  CHECK(params.printer_num == 2 && params.cd_num == 1);
+  CHECK(params.time_slice == 10 && params.page_size == 4);
+  CHECK(params.mem_size == 512 && params.max_proc_size == 64);
+  CHECK(params.disk_num == num_of_disks);
+  CHECK(params.cyl_nums == cyl_nums);
+  CHECK(params.disk_policies.size() == (size_t)num_of_disks);
+  for (size_t disk = 0; disk < params.disk_policies.size(); disk++)
+    CHECK(PolicyName(params.disk_policies[disk]) == policies[disk]);
+}
+
+// Configuration of the scalars and extra refused with an error containing
+// reason
+static void Refused(const std::string& extra, const std::string& reason) {
+  SysgenParams params{};
+  std::string error;
+  CHECK(!Parse(std::string(kScalars) + extra, &params, &error));
+  if (error.find(reason) == std::string::npos) {
+    std::cerr << "expected \"" << reason << "\", got \"" << error << "\""
+              << std::endl;
+    CHECK(false);
+  }
+}
+
+int main() {
+  for (uint64_t seed = 1; seed <= 500; seed++) RandomDisks(seed);
+
+  // no disks unless some are given
+  SysgenParams params{};
+  std::string error;
+  CHECK(Parse(kScalars, &params, &error));
+  CHECK(params.disk_num == 0 && params.cyl_nums.empty());
+
+  // kScalars has 9 lines
+  Refused("bogus = 1\n", "line 10: unknown key bogus");
+  Refused("disks\n", "line 10: expected <key> = <value>");
+  Refused("cds = 2\n", "line 10: cds given twice");
+  Refused("disks = two\n", "line 10: disks is not a number");
+  Refused("disks = 99999999999\n", "disks is not a number");
+  Refused("disks = -1\n", "Number of disk devices must be 0-2^20");
+  Refused("cylinders = 100*2000000\n", "line 10: invalid cylinders");
+  Refused("cylinders = 100*1048576, 100\n", "line 10: invalid cylinders");
+  Refused("disks = 2\ncylinders = 100\ncylinders[3] = 50\n", "line 12: no disk 3");
+  Refused("disks = 2\ncylinders = 100, 200, 300\n", "line 11: 3 values for 2 disks");
+  Refused("disks = 3\ncylinders[1-2] = 100\n", "no cylinders for disk 3");
+  Refused("cylinders = 100\npolicy = zigzag\n", "line 11: invalid policy zigzag");
+  Refused("cylinders = 100*0\n", "line 10: invalid cylinders");
+  Refused("cylinders = 100*\n", "line 10: invalid cylinders");
+  Refused("cylinders[2-1] = 100\n", "line 10: invalid disk range");
+  Refused("cylinders[0] = 100\n", "invalid disk range");
+  Refused("cylinders[1] = 100, 200\n", "invalid cylinders[1]");
+  Refused("cylinders = -5\n", "Number of cylinders must be >= 0");
+
+  // missing scalars and the rules of ValidSysgen
+  std::string scalars = kScalars;
+  std::string no_slice = scalars;
+  no_slice.erase(no_slice.find("time_slice"), scalars.find("[memory]") -
+                                                 scalars.find("time_slice"));
+  CHECK(!Parse(no_slice, &params, &error) && error == "missing time_slice");
+  std::string odd_page = scalars;
+  odd_page.replace(odd_page.find("page_size = 4"), 13, "page_size = 3");
+  CHECK(!Parse(odd_page, &params, &error) &&
+        error.find("Page size must be") == 0);
+  return TestResult("config_test");
+}
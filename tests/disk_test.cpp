@@ -0,0 +1,212 @@
+// Disks of every scheduling policy against a naive model that keeps the
+// queued requests in arrival order and searches them linearly. The order of
+// service and the seek of every request and of the disk must match, with
+// requests added and removed between services, and the disk must list the
+// requests left in the order it would service them.
+#include <cstdlib>
+#include <vector>
+
+#include "device.h"
+#include "tests/check.h"
+
+// Disk scheduling the way the policies are defined, in O(queued) per request.
+// Requests at the same cylinder are ordered by pid like CylinderQueue does.
+class NaiveDisk {
+  public:
+    NaiveDisk(DiskPolicy policy, int num_of_cylinders) :
+        policy{policy}, num_of_cylinders{num_of_cylinders} {}
+
+    bool empty() const {return queues[0].empty() && queues[1].empty();}
+
+    void Add(const PCB* request) {
+      // FSCAN defers requests to the waiting queue unless the disk is idle
+      int queue = (policy == DiskPolicy::fscan && !empty()) ? 1 - running : running;
+      queues[queue].push_back(Request{request->cylinder_num, request->pid});
+    }
+
+    void Remove(size_t pid) {
+      for (int q = 0; q < 2; q++) {
+        for (size_t i = 0; i < queues[q].size(); i++) {
+          if (queues[q][i].pid != pid) continue;
+          queues[q].erase(queues[q].begin() + i);
+          if (policy == DiskPolicy::fscan && q == running && queues[q].empty())
+            running = 1 - running;
+          return;
+        }
+      }
+    }
+
+    // Pid of the request serviced next and the cylinders the head travels
+    // to it, false if no request is queued
+    bool Next(size_t* pid, int* seek) {
+      if (empty()) return false;
+      if (queues[running].empty()) running = 1 - running;
+      std::vector<Request>& queue = queues[running];
+      int next = -1;
+      switch (policy) {
+        case DiskPolicy::fcfs:
+          next = 0;
+          *seek = abs(queue[next].cylinder - head);
+          break;
+        case DiskPolicy::sstf:
+        case DiskPolicy::fscan: {
+          int above = Lowest(queue, head, true), below = Highest(queue, head - 1);
+          next = above;
+          if (below >= 0 && (above < 0 || head - queue[below].cylinder <
+                                              queue[above].cylinder - head))
+            next = below;
+          *seek = abs(queue[next].cylinder - head);
+          break;
+        }
+        case DiskPolicy::scan:
+        case DiskPolicy::look:
+          next = up ? Lowest(queue, head, true) : Highest(queue, head);
+          if (next >= 0) {
+            *seek = abs(queue[next].cylinder - head);
+          }
+          else {
+            int turn = up ? num_of_cylinders - 1 : 0;
+            up = !up;
+            next = up ? Lowest(queue, 0, false) : Highest(queue, num_of_cylinders);
+            if (policy == DiskPolicy::scan)
+              *seek = abs(turn - head) + abs(turn - queue[next].cylinder);
+            else *seek = abs(queue[next].cylinder - head);
+          }
+          break;
+        case DiskPolicy::c_scan:
+        case DiskPolicy::c_look:
+          next = Lowest(queue, head, true);
+          if (next >= 0) {
+            *seek = queue[next].cylinder - head;
+          }
+          else {
+            next = Lowest(queue, 0, false);
+            if (policy == DiskPolicy::c_scan)
+              *seek = (num_of_cylinders - 1 - head) + (num_of_cylinders - 1) +
+                      queue[next].cylinder;
+            else *seek = head - queue[next].cylinder;
+          }
+          break;
+      }
+      *pid = queue[next].pid;
+      head = queue[next].cylinder;
+      queue.erase(queue.begin() + next);
+      if (queue.empty() && policy == DiskPolicy::fscan) running = 1 - running;
+      return true;
+    }
+
+  private:
+    struct Request {
+      int cylinder;
+      size_t pid;
+      bool before(const Request& other) const {
+        return cylinder < other.cylinder ||
+               (cylinder == other.cylinder && pid < other.pid);
+      }
+    };
+    DiskPolicy policy;
+    int num_of_cylinders;
+    int head = 0;
+    bool up = true;
+    std::vector<Request> queues[2];  // FSCAN: running and waiting
+    int running = 0;
+
+    // Index of the lowest request at or above cylinder (any if !bounded),
+    // -1 if there is none
+    static int Lowest(const std::vector<Request>& queue, int cylinder,
+                      bool bounded) {
+      int found = -1;
+      for (size_t i = 0; i < queue.size(); i++) {
+        if (bounded && queue[i].cylinder < cylinder) continue;
+        if (found < 0 || queue[i].before(queue[found])) found = i;
+      }
+      return found;
+    }
+    // Index of the highest request at or below cylinder, -1 if there is none
+    static int Highest(const std::vector<Request>& queue, int cylinder) {
+      int found = -1;
+      for (size_t i = 0; i < queue.size(); i++) {
+        if (queue[i].cylinder > cylinder) continue;
+        if (found < 0 || queue[found].before(queue[i])) found = i;
+      }
+      return found;
+    }
+};
+
+// Most requests queued at once, so the linear searches of the model stay fast
+static const size_t kMaxQueued = 256;
+
+static void RandomRequests(uint64_t seed, DiskPolicy policy,
+                           int num_of_cylinders, int operations) {
+  TestRandom random{seed};
+  PCBPool pool;
+  Disk* disk = static_cast<Disk*>(Device::make_device('d', &pool));
+  disk->num_of_cylinders = num_of_cylinders;
+  disk->set_policy(policy);
+  NaiveDisk naive{policy, num_of_cylinders};
+  std::vector<PCB*> queued;
+  size_t next_pid = 0;
+  long long seek_distance = 0;
+  for (int i = 0; i < operations; i++) {
+    int action = random.Below(10);
+    if (action < 5 && queued.size() < kMaxQueued) {
+      // bursts of requests, often on the same cylinders
+      for (int n = 1 + random.Below(4); n > 0; n--) {
+        PCB* request = pool.Allocate(next_pid++, 1, 1);
+        request->cylinder_num = (random.Below(3) == 0 && !queued.empty())
+            ? queued[random.Below(queued.size())]->cylinder_num
+            : random.Below(num_of_cylinders);
+        disk->AddRequest(request);
+        naive.Add(request);
+        queued.push_back(request);
+      }
+    }
+    else if (action < 6 && !queued.empty()) {
+      size_t victim = random.Below(queued.size());
+      disk->RemoveRequest(queued[victim]);
+      naive.Remove(queued[victim]->pid);
+      pool.Release(queued[victim]);
+      queued.erase(queued.begin() + victim);
+    }
+    else {
+      size_t pid;
+      int seek;
+      bool expected = naive.Next(&pid, &seek);
+      PCB* finished = disk->PopFinished();
+      CHECK((finished != nullptr) == expected);
+      if (finished == nullptr || !expected) continue;
+      CHECK(finished->pid == pid);
+      CHECK(disk->service_seek() == seek);
+      seek_distance += seek;
+      for (size_t k = 0; k < queued.size(); k++) {
+        if (queued[k] != finished) continue;
+        queued.erase(queued.begin() + k);
+        break;
+      }
+      pool.Release(finished);
+    }
+    CHECK(disk->stats().seek_distance == seek_distance);
+  }
+  // the disk lists what is left in the order it would service it
+  std::vector<size_t> listed, serviced;
+  disk->ForEachRequest([&](PCB* p) {listed.push_back(p->pid);});
+  size_t pid;
+  int seek;
+  while (naive.Next(&pid, &seek)) serviced.push_back(pid);
+  CHECK(listed == serviced);
+  delete disk;
+}
+
+int main() {
+  const DiskPolicy policies[] = {DiskPolicy::fcfs, DiskPolicy::sstf,
+                                 DiskPolicy::scan, DiskPolicy::c_scan,
+                                 DiskPolicy::look, DiskPolicy::c_look,
+                                 DiskPolicy::fscan};
+  const int cylinders[] = {1, 2, 200};
+  uint64_t seed = 1;
+  for (DiskPolicy policy: policies) {
+    for (int num_of_cylinders: cylinders)
+      RandomRequests(seed++, policy, num_of_cylinders, 20000);
+  }
+  return TestResult("disk_test");
+}
@@ -0,0 +1,94 @@
+// FrameAllocator against a plain array of free flags. Contiguous allocations
+// must take the first run of free frames (found a word at a time by FindRun
+// and RunStarts), and free run statistics must match a frame by frame count.
+#include <algorithm>
+#include <vector>
+
+#include "frame_allocator.h"
+#include "tests/check.h"
+
+// First frame of the lowest run of n free frames, -1 if there is none
+static int NaiveFindRun(const std::vector<bool>& free, int n) {
+  int length = 0;
+  for (int frame = 0; frame < (int)free.size(); frame++) {
+    length = free[frame] ? length + 1 : 0;
+    if (length == n) return frame - n + 1;
+  }
+  return -1;
+}
+
+static FreeRunStats NaiveRunStats(const std::vector<bool>& free) {
+  FreeRunStats stats;
+  int length = 0;
+  for (size_t frame = 0; frame <= free.size(); frame++) {
+    if (frame < free.size() && free[frame]) {
+      if (length == 0) stats.runs++;
+      length++;
+      stats.free_frames++;
+    }
+    else {
+      stats.largest_run = std::max(stats.largest_run, length);
+      length = 0;
+    }
+  }
+  return stats;
+}
+
+static void CheckSame(const FrameAllocator& frames, const std::vector<bool>& free) {
+  int free_count = std::count(free.begin(), free.end(), true);
+  CHECK(frames.free_frames() == free_count);
+  for (size_t frame = 0; frame < free.size(); frame++)
+    CHECK(frames.is_free(frame) == free[frame]);
+  std::vector<int> visited;
+  frames.ForEachFree([&](int frame) {visited.push_back(frame);});
+  CHECK((int)visited.size() == free_count);
+  CHECK(std::is_sorted(visited.begin(), visited.end()));
+  FreeRunStats stats = frames.RunStats(), expected = NaiveRunStats(free);
+  CHECK(stats.free_frames == expected.free_frames);
+  CHECK(stats.runs == expected.runs);
+  CHECK(stats.largest_run == expected.largest_run);
+}
+
+static void RandomOperations(uint64_t seed, int num_of_frames, int operations) {
+  TestRandom random{seed};
+  FrameAllocator frames{num_of_frames};
+  std::vector<bool> free(num_of_frames, true);
+  std::vector<std::vector<int>> allocations;
+  for (int i = 0; i < operations; i++) {
+    if (random.Below(2) == 0 || allocations.empty()) {
+      // runs within a word, up to a word and across several words
+      int limit = (random.Below(4) == 0) ? 200 : 64;
+      int n = 1 + random.Below(std::min(limit, num_of_frames));
+      bool contiguous = random.Below(4) != 0;
+      int free_count = frames.free_frames();
+      int expected_start = contiguous ? NaiveFindRun(free, n) : -1;
+      std::vector<int> taken(n, -1);
+      bool allocated = frames.AllocateFrames(n, taken.data(), contiguous);
+      CHECK(allocated == (n <= free_count));
+      if (!allocated) continue;
+      for (int k = 0; k < n; k++) {
+        if (expected_start >= 0) CHECK(taken[k] == expected_start + k);
+        CHECK(taken[k] >= 0 && taken[k] < num_of_frames);
+        if (taken[k] < 0 || taken[k] >= num_of_frames) return;
+        CHECK(free[taken[k]]);
+        free[taken[k]] = false;
+      }
+      allocations.push_back(taken);
+    }
+    else {
+      size_t victim = random.Below(allocations.size());
+      const std::vector<int>& block = allocations[victim];
+      frames.FreeFrames(block.data(), block.size());
+      for (int frame: block) free[frame] = true;
+      allocations.erase(allocations.begin() + victim);
+    }
+    if (i % 53 == 0) CheckSame(frames, free);
+  }
+  CheckSame(frames, free);
+}
+
+int main() {
+  const int sizes[] = {1, 63, 64, 100, 1000, 4096 + 13};
+  for (int i = 0; i < 6; i++) RandomOperations(i + 1, sizes[i], 5000);
+  return TestResult("frame_allocator_test");
+}
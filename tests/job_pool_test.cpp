@@ -0,0 +1,78 @@
+// JobPool against a list of jobs in arrival order, searched linearly for the
+// longest waiting of the largest jobs that fit. Jobs of up to max_pages pages
+// come and go, so buckets are created and dropped as their page counts empty.
+#include <algorithm>
+#include <vector>
+
+#include "pcb_pool.h"
+#include "tests/check.h"
+
+// Longest waiting of the largest jobs with at most free_frames pages
+static PCB* NaiveLargestFitting(const std::vector<PCB*>& jobs, int free_frames) {
+  PCB* best = nullptr;
+  for (PCB* p: jobs) {
+    if (p->pages <= free_frames && (best == nullptr || p->pages > best->pages))
+      best = p;
+  }
+  return best;
+}
+
+static void CheckOrder(const JobPool& job_pool, std::vector<PCB*> jobs) {
+  // largest first, FIFO within a page count
+  std::stable_sort(jobs.begin(), jobs.end(), [](const PCB* a, const PCB* b) {
+    return a->pages > b->pages;
+  });
+  std::vector<PCB*> visited;
+  job_pool.ForEach([&](PCB* p) {visited.push_back(p);});
+  CHECK(visited == jobs);
+}
+
+static void RandomOperations(uint64_t seed, int max_pages, int operations) {
+  TestRandom random{seed};
+  PCBPool pool;
+  JobPool job_pool{&pool};
+  std::vector<PCB*> jobs;  // in arrival order
+  size_t next_pid = 0;
+  for (int i = 0; i < operations; i++) {
+    int action = random.Below(10);
+    if (action < 4 || jobs.empty()) {
+      // small jobs more often, so buckets hold several
+      int pages = 1 + random.Below(1 + random.Below(max_pages));
+      PCB* p = pool.Allocate(next_pid++, pages, pages);
+      job_pool.push(p);
+      jobs.push_back(p);
+    }
+    else if (action < 6) {
+      size_t victim = random.Below(jobs.size());
+      job_pool.erase(jobs[victim]);
+      pool.Release(jobs[victim]);
+      jobs.erase(jobs.begin() + victim);
+    }
+    else {
+      // admit the job the OS would take for a random amount of free memory
+      int free_frames = random.Below(max_pages + 6) - 2;
+      PCB* expected = NaiveLargestFitting(jobs, free_frames);
+      PCB* found = job_pool.LargestFitting(free_frames);
+      CHECK(found == expected);
+      if (found != nullptr && action < 8) {
+        job_pool.erase(found);
+        jobs.erase(std::find(jobs.begin(), jobs.end(), found));
+        pool.Release(found);
+      }
+    }
+    CHECK(job_pool.size() == jobs.size());
+    CHECK(job_pool.empty() == jobs.empty());
+    if (i % 101 == 0) CheckOrder(job_pool, jobs);
+  }
+  // every amount of free memory on the final pool
+  for (int free_frames = 0; free_frames <= max_pages + 1; free_frames++)
+    CHECK(job_pool.LargestFitting(free_frames) ==
+          NaiveLargestFitting(jobs, free_frames));
+  CheckOrder(job_pool, jobs);
+}
+
+int main() {
+  const int sizes[] = {1, 2, 7, 16, 100, 1024};
+  for (int i = 0; i < 6; i++) RandomOperations(i + 1, sizes[i], 20000);
+  return TestResult("job_pool_test");
+}
@@ -0,0 +1,100 @@
+// Kill against the set of live pids, with processes on the CPU, in the ready
+// queue, in every device queue and in the job pool. Killing a live process
+// must succeed once, anything else must be refused, and killing every
+// remaining process must leave the OS as empty as a new one.
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "os.h"
+#include "tests/check.h"
+
+using namespace os_ops;
+
+static SysgenParams Params() {
+  SysgenParams params{};
+  params.printer_num = 2;
+  params.disk_num = 2;
+  params.cd_num = 2;
+  params.cyl_nums = {50, 80};
+  params.time_slice = 10;
+  params.page_size = 4;
+  params.mem_size = 64;  // room for a few processes, the rest wait for frames
+  params.max_proc_size = 32;
+  params.cpu_num = 1;
+  return params;
+}
+
+// Snapshots of os without the lines that depend on its history (CPU time of
+// completed processes, disk statistics, order of the free frames)
+static std::string Snapshots(const OS& os) {
+  std::ostringstream out;
+  for (char snap_type: std::string("rpdcjm")) os.Snapshot(snap_type, out);
+  std::istringstream in{out.str()};
+  std::string kept, line;
+  while (std::getline(in, line)) {
+    if (line.compare(0, 7, "Average") != 0 && line.compare(0, 6, "Policy") != 0 &&
+        line.compare(0, 4, "Free") != 0)
+      kept += line + "\n";
+  }
+  return kept;
+}
+
+static void RandomOperations(uint64_t seed, int operations) {
+  TestRandom random{seed};
+  SysgenParams params = Params();
+  OS os{params};
+  std::set<size_t> live;
+  for (int i = 0; i < operations; i++) {
+    int action = random.Below(10);
+    if (action < 3) {
+      // some processes too large to be admitted
+      size_t pid;
+      Status status = os.NewProcess(1 + random.Below(params.max_proc_size + 4),
+                                    &pid);
+      if (status == Status::ok) live.insert(pid);
+    }
+    else if (action < 5 && os.active() != nullptr) {
+      const char types[] = {'p', 'd', 'c'};
+      char device_type = types[random.Below(3)];
+      int device_num = 1 + random.Below(2);
+      IOParams io{"file", random.Below(os.active()->size), 'w', 0, 10};
+      if (device_type == 'd')
+        io.cylinder = random.Below(os.disk_cylinders(device_num));
+      CHECK(os.IORequest(device_type, device_num, 1, io) == Status::ok);
+    }
+    else if (action < 6) {
+      const char types[] = {'P', 'D', 'C'};
+      size_t pid;
+      if (os.HandleInterrupt(types[random.Below(3)], 1 + random.Below(2),
+                             &pid) == Status::ok)
+        CHECK(live.count(pid) == 1);
+    }
+    else if (action < 7) {
+      os.EndOfTimeSlice();
+    }
+    else if (action < 8 && os.active() != nullptr) {
+      live.erase(os.active()->pid);
+      CHECK(os.TerminateActiveProcess(1) == Status::ok);
+    }
+    else {
+      // live pids, pids of rejected or killed processes and unused pids
+      size_t pid = random.Below(os.next_pid() + 3);
+      Status expected = live.count(pid) ? Status::ok : Status::no_such_process;
+      CHECK(os.Kill(pid) == expected);
+      live.erase(pid);
+      CHECK(os.Kill(pid) == Status::no_such_process);
+    }
+    if (os.active() != nullptr) CHECK(live.count(os.active()->pid) == 1);
+  }
+  for (size_t pid: live) CHECK(os.Kill(pid) == Status::ok);
+  CHECK(os.active() == nullptr);
+  OS empty{params};
+  CHECK(Snapshots(os) == Snapshots(empty));
+}
+
+int main() {
+  for (uint64_t seed = 1; seed <= 5; seed++) RandomOperations(seed, 20000);
+  return TestResult("kill_test");
+}
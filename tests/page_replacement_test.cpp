@@ -0,0 +1,145 @@
+// Page replacers against models of their policies: FIFO and second chance
+// keep the frames in a list in load order, clock is stated by the class of
+// page it evicts (clean and unreferenced first, then unreferenced, then any
+// after clearing every referenced bit). Victims and the referenced bits left
+// behind must match, with pages referenced, written and freed in between.
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "page_replacement.h"
+#include "tests/check.h"
+
+class NaiveReplacer {
+  public:
+    NaiveReplacer(ReplacementPolicy policy, int num_of_frames) :
+        policy{policy}, num_of_frames{num_of_frames} {}
+
+    void Loaded(int frame) {loaded.push_back(frame);}
+    void Freed(int frame) {
+      for (size_t i = 0; i < loaded.size(); i++) {
+        if (loaded[i] != frame) continue;
+        loaded.erase(loaded.begin() + i);
+        return;
+      }
+    }
+
+    // Frame to evict with every frame in use, clearing referenced bits of
+    // entries the way the policy does
+    int Victim(std::vector<int>& entries) {
+      int victim = -1;
+      switch (policy) {
+        case ReplacementPolicy::none:
+          break;
+        case ReplacementPolicy::fifo:
+          victim = loaded.front();
+          break;
+        case ReplacementPolicy::second_chance:
+          // referenced pages lose their bit and go to the back
+          while (entries[loaded.front()] & kPageReferenced) {
+            entries[loaded.front()] &= ~kPageReferenced;
+            loaded.push_back(loaded.front());
+            loaded.pop_front();
+          }
+          victim = loaded.front();
+          break;
+        case ReplacementPolicy::clock: {
+          victim = First(entries, kPageReferenced | kPageDirty);
+          if (victim >= 0) break;
+          victim = First(entries, kPageReferenced);
+          if (victim >= 0) {
+            // the hand cleared the bits of the frames it passed
+            for (int frame = hand; frame != victim; frame = (frame + 1) % num_of_frames)
+              entries[frame] &= ~kPageReferenced;
+            break;
+          }
+          // two laps clear every bit, then the clean pages come first
+          for (int& entry: entries) entry &= ~kPageReferenced;
+          victim = First(entries, kPageDirty);
+          if (victim < 0) victim = hand;
+          break;
+        }
+      }
+      hand = (victim + 1) % num_of_frames;
+      Freed(victim);
+      return victim;
+    }
+
+  private:
+    ReplacementPolicy policy;
+    int num_of_frames;
+    std::deque<int> loaded;  // in load order
+    int hand = 0;
+
+    // First frame from the hand on with none of bits set, -1 if none
+    int First(const std::vector<int>& entries, int bits) const {
+      for (int i = 0; i < num_of_frames; i++) {
+        int frame = (hand + i) % num_of_frames;
+        if ((entries[frame] & bits) == 0) return frame;
+      }
+      return -1;
+    }
+};
+
+static void RandomReferences(uint64_t seed, ReplacementPolicy policy,
+                             int num_of_frames, int operations) {
+  TestRandom random{seed};
+  std::unique_ptr<PageReplacer> replacer{
+      PageReplacer::make_replacer(policy, num_of_frames)};
+  NaiveReplacer naive{policy, num_of_frames};
+  // entries[f] is the page table entry of the page in frame f, 0 if free
+  std::vector<int> entries(num_of_frames, 0), expected(num_of_frames, 0);
+  std::vector<int*> pointers(num_of_frames);
+  for (int frame = 0; frame < num_of_frames; frame++)
+    pointers[frame] = &entries[frame];
+  std::vector<int> free_frames;
+  for (int frame = num_of_frames - 1; frame >= 0; frame--)
+    free_frames.push_back(frame);
+
+  for (int i = 0; i < operations; i++) {
+    int action = random.Below(10);
+    int frame = random.Below(num_of_frames);
+    if (action < 5 && entries[frame] != 0) {
+      // reference, sometimes a write
+      int bits = kPageReferenced | (random.Below(4) == 0 ? kPageDirty : 0);
+      entries[frame] |= bits;
+      expected[frame] |= bits;
+    }
+    else if (action < 6 && entries[frame] != 0) {
+      replacer->Freed(frame);
+      naive.Freed(frame);
+      entries[frame] = expected[frame] = 0;
+      free_frames.push_back(frame);
+    }
+    else {
+      // load a page, evicting one if memory is full
+      if (free_frames.empty()) {
+        frame = replacer->Victim(pointers.data());
+        int victim = naive.Victim(expected);
+        CHECK(frame == victim);
+        CHECK(entries == expected);
+      }
+      else {
+        frame = free_frames.back();
+        free_frames.pop_back();
+      }
+      replacer->Loaded(frame);
+      naive.Loaded(frame);
+      entries[frame] = expected[frame] = kPageValid | kPageReferenced | frame;
+    }
+  }
+}
+
+int main() {
+  const ReplacementPolicy policies[] = {ReplacementPolicy::fifo,
+                                        ReplacementPolicy::second_chance,
+                                        ReplacementPolicy::clock};
+  const int sizes[] = {1, 2, 7, 64};
+  uint64_t seed = 1;
+  for (ReplacementPolicy policy: policies) {
+    for (int num_of_frames: sizes)
+      RandomReferences(seed++, policy, num_of_frames, 20000);
+  }
+  CHECK(PageReplacer::make_replacer(ReplacementPolicy::none, 8) == nullptr);
+  return TestResult("page_replacement_test");
+}
@@ -0,0 +1,116 @@
+// Page tables of every organization against a map from (pid, page) to page
+// table entry. Pages are mapped and unmapped, entries gain referenced and
+// dirty bits, and processes come and go; every page must be found with its
+// entry, or not at all, and destroying every table must free its memory.
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "page_table.h"
+#include "tests/check.h"
+
+static const int kFrames = 64;
+static const int kMaxPages = 40;
+
+// Check every page of p against the entries of the model
+static void CheckPages(PageTables& tables, const PCB* p, int levels,
+                       const std::map<std::pair<size_t,int>, int>& model) {
+  for (int page = 0; page < p->pages; page++) {
+    size_t accesses = 0;
+    const int* entry = tables.Find(p, page, &accesses);
+    auto mapped = model.find(std::make_pair(p->pid, page));
+    if (mapped == model.end()) {
+      CHECK(entry == nullptr || (*entry & kPageValid) == 0);
+    }
+    else {
+      CHECK(entry != nullptr && *entry == mapped->second);
+      // a walk takes one access per level; hash chains are not bounded
+      if (levels > 0) CHECK(accesses == (size_t)levels);
+    }
+  }
+}
+
+static void RandomMappings(uint64_t seed, PageTableKind kind, int operations) {
+  TestRandom random{seed};
+  PCBPool pool;
+  std::vector<std::pair<int,int>> frame_table(kFrames, std::make_pair(-1,-1));
+  std::unique_ptr<PageTables> tables{
+      PageTables::make_page_tables(kind, &pool, kMaxPages, frame_table)};
+  const int levels[] = {1, 2, 3, 0};
+  int walk = levels[static_cast<int>(kind)];
+  std::map<std::pair<size_t,int>, int> model;  // valid entries
+  std::vector<PCB*> processes;
+  std::vector<int> free_frames;
+  for (int frame = 0; frame < kFrames; frame++) free_frames.push_back(frame);
+  size_t next_pid = 0;
+  auto unmap = [&](PCB* p, int page) {
+    auto mapped = model.find(std::make_pair(p->pid, page));
+    if (mapped == model.end()) return;
+    int frame = mapped->second & kPageFrame;
+    tables->Unmap(frame, tables->Find(p, page));
+    frame_table[frame] = std::make_pair(-1,-1);
+    free_frames.push_back(frame);
+    model.erase(mapped);
+  };
+  auto destroy = [&](PCB* p) {
+    for (int page = 0; page < p->pages; page++) unmap(p, page);
+    CheckPages(*tables, p, walk, model);
+    tables->Destroy(p);
+    pool.Release(p);
+  };
+
+  for (int i = 0; i < operations; i++) {
+    int action = random.Below(20);
+    PCB* p = processes.empty() ? nullptr
+                               : processes[random.Below(processes.size())];
+    if (action < 2 || p == nullptr) {
+      int pages = 1 + random.Below(kMaxPages);
+      PCB* created = pool.Allocate(next_pid++, pages, pages);
+      tables->Create(created);
+      processes.push_back(created);
+      CheckPages(*tables, created, walk, model);
+    }
+    else if (action < 3) {
+      processes.erase(std::find(processes.begin(), processes.end(), p));
+      destroy(p);
+    }
+    else {
+      int page = random.Below(p->pages);
+      auto mapped = model.find(std::make_pair(p->pid, page));
+      if (mapped == model.end() && !free_frames.empty()) {
+        int frame = free_frames[random.Below(free_frames.size())];
+        free_frames.erase(std::find(free_frames.begin(), free_frames.end(), frame));
+        frame_table[frame] = std::make_pair((int)p->pid, page);
+        int* entry = tables->Map(p, page, frame);
+        CHECK(*entry == (frame | kPageValid));
+        model[std::make_pair(p->pid, page)] = *entry;
+      }
+      else if (mapped != model.end() && action < 8) {
+        unmap(p, page);
+      }
+      else if (mapped != model.end()) {
+        // reference, sometimes a write
+        int bits = kPageReferenced | (random.Below(2) ? kPageDirty : 0);
+        *tables->Find(p, page) |= bits;
+        mapped->second |= bits;
+      }
+      CheckPages(*tables, p, walk, model);
+    }
+  }
+  for (PCB* p: processes) CheckPages(*tables, p, walk, model);
+  for (PCB* p: processes) destroy(p);
+  // the inverted table has an entry per frame whatever is mapped
+  if (kind != PageTableKind::inverted) CHECK(tables->footprint() == 0);
+}
+
+int main() {
+  const PageTableKind kinds[] = {PageTableKind::dense,
+                                 PageTableKind::two_level,
+                                 PageTableKind::three_level,
+                                 PageTableKind::inverted};
+  uint64_t seed = 1;
+  for (PageTableKind kind: kinds) RandomMappings(seed++, kind, 20000);
+  return TestResult("page_table_test");
+}
@@ -0,0 +1,86 @@
+// PidIndex against a std::map of the same processes. Pids come from a small
+// range so probe runs grow long, wrap around the end of the table and are
+// repaired by the backward shift of erase.
+#include <map>
+#include <vector>
+
+#include "pcb_pool.h"
+#include "tests/check.h"
+
+// index holds exactly the processes of reference, checked for every pid
+// below max_pid and by iterating the index
+static void CheckSame(const PidIndex& index,
+                      const std::map<size_t, PCBHandle>& reference,
+                      size_t max_pid) {
+  CHECK(index.size() == reference.size());
+  for (size_t pid = 0; pid < max_pid; pid++) {
+    auto found = reference.find(pid);
+    PCBHandle expected = (found == reference.end()) ? kNullHandle : found->second;
+    CHECK(index.find(pid) == expected);
+  }
+  std::map<size_t, PCBHandle> visited;
+  index.ForEach([&](size_t pid, PCBHandle handle) {
+    CHECK(visited.count(pid) == 0);
+    visited[pid] = handle;
+  });
+  CHECK(visited == reference);
+}
+
+// Random inserts and erases of pids below max_pid, checking the whole index
+// every check_every operations
+static void RandomOperations(uint64_t seed, size_t max_pid, int operations,
+                             int check_every) {
+  TestRandom random{seed};
+  PidIndex index;
+  std::map<size_t, PCBHandle> reference;
+  for (int i = 0; i < operations; i++) {
+    size_t pid = random.Below(max_pid);
+    if (reference.count(pid) == 0) {
+      PCBHandle handle = random.Below(1 << 20);
+      index.insert(pid, handle);
+      reference[pid] = handle;
+    }
+    else {
+      index.erase(pid);
+      reference.erase(pid);
+    }
+    // erasing a pid that is not there changes nothing
+    size_t absent = max_pid + random.Below(max_pid);
+    index.erase(absent);
+    if (i % check_every == 0) CheckSame(index, reference, 2*max_pid);
+  }
+  CheckSame(index, reference, 2*max_pid);
+}
+
+// Pids in the order the OS creates them, the oldest terminated first
+static void SlidingWindow() {
+  PidIndex index;
+  std::map<size_t, PCBHandle> reference;
+  const size_t window = 1000;
+  for (size_t pid = 0; pid < 20000; pid++) {
+    index.insert(pid, pid);
+    reference[pid] = pid;
+    if (pid >= window) {
+      index.erase(pid - window);
+      reference.erase(pid - window);
+    }
+    if (pid % 1000 == 999) CheckSame(index, reference, pid + 1);
+  }
+  // drain completely, then reuse the grown table
+  for (size_t pid = 20000 - window; pid < 20000; pid++) {
+    index.erase(pid);
+    reference.erase(pid);
+  }
+  CheckSame(index, reference, 20000);
+  index.insert(7, 7);
+  reference[7] = 7;
+  CheckSame(index, reference, 20000);
+}
+
+int main() {
+  RandomOperations(1, 64, 20000, 97);
+  RandomOperations(2, 1000, 50000, 97);
+  RandomOperations(3, 100000, 50000, 4999);
+  SlidingWindow();
+  return TestResult("pid_index_test");
+}
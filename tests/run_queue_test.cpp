@@ -0,0 +1,230 @@
+// Run queues of every CPU policy against a model keeping a list of queued
+// processes per priority level, searched linearly for the least virtual
+// runtime under CFS. Processes are queued, dispatched, stolen, removed, run,
+// expire their slices and complete I/O; the processes popped, the levels
+// they move to, their virtual runtimes and time slices and the order in
+// which the ready processes are visited must match.
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "cpu_scheduler.h"
+#include "tests/check.h"
+
+class NaiveRunQueue {
+  public:
+    NaiveRunQueue(const SchedulerParams& params, int time_slice) :
+        params{params}, time_slice{time_slice},
+        queues(params.policy == CPUPolicy::mlfq ? params.levels : 1) {}
+
+    void Add(PCB* p) {
+      if (params.policy == CPUPolicy::cfs) {
+        // at most half a latency behind the least runtime dispatched
+        int64_t floor = min_vruntime - params.target_latency*1000/2;
+        vruntimes[p] = std::max(vruntimes[p], floor);
+      }
+      queues[Level(p)].push_back(p);
+    }
+    PCB* Next() {
+      if (params.policy == CPUPolicy::cfs) {
+        PCB* p = Pop(queues[0], Least());
+        if (p != nullptr) min_vruntime = std::max(min_vruntime, vruntimes[p]);
+        return p;
+      }
+      for (auto& queue: queues) {
+        if (!queue.empty()) return Pop(queue, 0);
+      }
+      return nullptr;
+    }
+    // the last process of the lowest level with processes, under CFS the
+    // one with the most virtual runtime
+    PCB* Steal() {
+      if (params.policy == CPUPolicy::cfs) return Pop(queues[0], Most());
+      for (int level = queues.size() - 1; level >= 0; level--) {
+        if (!queues[level].empty())
+          return Pop(queues[level], queues[level].size() - 1);
+      }
+      return nullptr;
+    }
+    void Remove(PCB* p) {
+      std::deque<PCB*>& queue = queues[Level(p)];
+      queue.erase(std::find(queue.begin(), queue.end(), p));
+    }
+    // time slice of p, which has been taken out of the queue to run
+    int Quantum(const PCB* p) const {
+      if (params.policy != CPUPolicy::cfs) return time_slice << Level(p);
+      int64_t weight = NiceWeight(p->nice), total = weight;
+      for (const PCB* queued: queues[0]) total += NiceWeight(queued->nice);
+      int slice = params.target_latency*weight/total;
+      return std::max(slice, params.min_granularity);
+    }
+    void Ran(const PCB* p, int duration) {
+      if (params.policy == CPUPolicy::cfs)
+        vruntimes[p] += (int64_t)duration*1000*1024/NiceWeight(p->nice);
+    }
+    int64_t vruntime(const PCB* p) const {
+      auto found = vruntimes.find(p);
+      return found == vruntimes.end() ? 0 : found->second;
+    }
+    // level p moves to when it expires or wakes
+    int Expired(const PCB* p) const {
+      return std::min<int>(Level(p) + 1, queues.size() - 1);
+    }
+    int Woken(const PCB* p) const {return std::max(Level(p) - 1, 0);}
+    void Boost() {
+      for (size_t level = 1; level < queues.size(); level++) {
+        for (PCB* p: queues[level]) queues[0].push_back(p);
+        queues[level].clear();
+      }
+    }
+
+    std::vector<PCB*> Ready() const {
+      std::vector<PCB*> ready;
+      for (const auto& queue: queues) {
+        for (PCB* p: queue) ready.push_back(p);
+      }
+      if (params.policy == CPUPolicy::cfs) {
+        std::sort(ready.begin(), ready.end(),
+                  [this](const PCB* a, const PCB* b) {return Before(a, b);});
+      }
+      return ready;
+    }
+    size_t level_size(int level) const {return queues[level].size();}
+
+  private:
+    SchedulerParams params;
+    int time_slice;
+    std::vector<std::deque<PCB*>> queues;  // in run order, CFS: any order
+    std::map<const PCB*, int64_t> vruntimes;  // CFS
+    int64_t min_vruntime = 0;
+
+    int Level(const PCB* p) const {return queues.size() == 1 ? 0 : p->priority;}
+    bool Before(const PCB* a, const PCB* b) const {
+      return vruntime(a) < vruntime(b) ||
+             (vruntime(a) == vruntime(b) && a->pid < b->pid);
+    }
+    // Index of the queued process with the least (most) virtual runtime,
+    // -1 if none is queued
+    int Least() const {
+      int found = -1;
+      for (size_t i = 0; i < queues[0].size(); i++) {
+        if (found < 0 || Before(queues[0][i], queues[0][found])) found = i;
+      }
+      return found;
+    }
+    int Most() const {
+      int found = -1;
+      for (size_t i = 0; i < queues[0].size(); i++) {
+        if (found < 0 || Before(queues[0][found], queues[0][i])) found = i;
+      }
+      return found;
+    }
+    // Remove and return the process at index of queue, nullptr if index < 0
+    static PCB* Pop(std::deque<PCB*>& queue, int index) {
+      if (index < 0) return nullptr;
+      PCB* p = queue[index];
+      queue.erase(queue.begin() + index);
+      return p;
+    }
+};
+
+static void RandomScheduling(uint64_t seed, const SchedulerParams& params,
+                             int operations) {
+  const int kTimeSlice = 10;
+  const size_t kProcesses = 64;
+  TestRandom random{seed};
+  PCBPool pool;
+  std::unique_ptr<RunQueue> run_queue{
+      RunQueue::make_run_queue(params, kTimeSlice, &pool)};
+  NaiveRunQueue naive{params, kTimeSlice};
+  std::vector<PCB*> queued, off;  // off: running or waiting for I/O
+  size_t next_pid = 0;
+  auto take = [&](PCB* p) {
+    if (p == nullptr) return;
+    queued.erase(std::find(queued.begin(), queued.end(), p));
+    off.push_back(p);
+  };
+
+  for (int i = 0; i < operations; i++) {
+    int action = random.Below(20);
+    PCB* p = off.empty() ? nullptr : off[random.Below(off.size())];
+    if (action < 3 && queued.size() + off.size() < kProcesses) {
+      PCB* created = pool.Allocate(next_pid++, 1, 1);
+      created->nice = kMinNice + random.Below(kMaxNice - kMinNice + 1);
+      run_queue->Add(created);
+      naive.Add(created);
+      queued.push_back(created);
+    }
+    else if (action < 8) {
+      PCB* next = run_queue->Next();
+      CHECK(next == naive.Next());
+      take(next);
+    }
+    else if (action < 10) {
+      PCB* stolen = run_queue->Steal();
+      CHECK(stolen == naive.Steal());
+      take(stolen);
+    }
+    else if (action < 11 && !queued.empty()) {
+      PCB* removed = queued[random.Below(queued.size())];
+      run_queue->Remove(removed);
+      naive.Remove(removed);
+      take(removed);
+    }
+    else if (action < 15 && p != nullptr) {
+      int quantum = run_queue->Quantum(p);
+      CHECK(quantum == naive.Quantum(p));
+      // runs for its slice or blocks early
+      int duration = 1 + random.Below(quantum);
+      run_queue->Ran(p, duration);
+      naive.Ran(p, duration);
+      int level = naive.Expired(p);
+      run_queue->Expired(p);
+      if (params.policy == CPUPolicy::mlfq) CHECK(p->priority == level);
+      run_queue->Add(p);
+      naive.Add(p);
+      off.erase(std::find(off.begin(), off.end(), p));
+      queued.push_back(p);
+    }
+    else if (action < 19 && p != nullptr) {
+      int level = naive.Woken(p);
+      run_queue->Woken(p);
+      if (params.policy == CPUPolicy::mlfq) CHECK(p->priority == level);
+      run_queue->Add(p);
+      naive.Add(p);
+      off.erase(std::find(off.begin(), off.end(), p));
+      queued.push_back(p);
+    }
+    else if (action == 19) {
+      run_queue->Boost();
+      if (params.policy == CPUPolicy::mlfq) {
+        naive.Boost();
+        for (PCB* ready: queued) CHECK(ready->priority == 0);
+      }
+    }
+    if (params.policy == CPUPolicy::cfs) {
+      for (PCB* r: queued) CHECK(r->vruntime == naive.vruntime(r));
+    }
+    CHECK(run_queue->size() == queued.size());
+    for (int level = 0; level < run_queue->levels(); level++)
+      CHECK(run_queue->level_size(level) == naive.level_size(level));
+    std::vector<PCB*> ready;
+    run_queue->ForEachReady([&](PCB* r) {ready.push_back(r);});
+    CHECK(ready == naive.Ready());
+  }
+}
+
+int main() {
+  const SchedulerParams schedulers[] = {{CPUPolicy::round_robin, 1, 0, 0, 0},
+                                        {CPUPolicy::mlfq, 1, 0, 0, 0},
+                                        {CPUPolicy::mlfq, 3, 0, 0, 0},
+                                        {CPUPolicy::mlfq, kMaxLevels, 0, 0, 0},
+                                        {CPUPolicy::cfs, 1, 0, 20, 4},
+                                        {CPUPolicy::cfs, 1, 0, 48, 1}};
+  uint64_t seed = 1;
+  for (const SchedulerParams& params: schedulers)
+    RandomScheduling(seed++, params, 20000);
+  return TestResult("run_queue_test");
+}
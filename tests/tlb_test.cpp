@@ -0,0 +1,124 @@
+// TLB against a model keeping the translations of each set in a list, least
+// recently used (lru) or oldest (fifo) first. The random policy evicts an
+// entry the model can not predict, so it is found by looking up every
+// translation the model holds. Lookups hit and miss like the model, with
+// translations inserted, invalidated and flushed in between.
+#include <vector>
+
+#include "tlb.h"
+#include "tests/check.h"
+
+class NaiveTLB {
+  public:
+    explicit NaiveTLB(const TLBParams& params) :
+        params{params}, sets(params.entries/params.ways) {}
+
+    int Lookup(size_t pid, int page) {
+      std::vector<Entry>& set = Set(page);
+      for (size_t i = 0; i < set.size(); i++) {
+        if (set[i].pid != pid || set[i].page != page) continue;
+        Entry found = set[i];
+        if (params.policy == TLBPolicy::lru) {
+          set.erase(set.begin() + i);
+          set.push_back(found);
+        }
+        return found.frame;
+      }
+      return -1;
+    }
+
+    // Insert after a miss. With the random policy the victim is the entry
+    // tlb no longer holds.
+    void Insert(size_t pid, int page, int frame, TLB& tlb) {
+      std::vector<Entry>& set = Set(page);
+      if ((int)set.size() == params.ways) {
+        if (params.policy != TLBPolicy::random) {
+          set.erase(set.begin());
+        }
+        else {
+          int evicted = 0;
+          for (size_t i = 0; i < set.size(); i++) {
+            if (tlb.Lookup(set[i].pid, set[i].page) >= 0) continue;
+            set.erase(set.begin() + i);
+            evicted++;
+            i--;
+          }
+          CHECK(evicted == 1);
+        }
+      }
+      set.push_back(Entry{pid, page, frame});
+    }
+
+    void Invalidate(size_t pid, int page) {
+      std::vector<Entry>& set = Set(page);
+      for (size_t i = 0; i < set.size(); i++) {
+        if (set[i].pid == pid && set[i].page == page) set.erase(set.begin() + i);
+      }
+    }
+
+    void Flush() {
+      for (std::vector<Entry>& set: sets) set.clear();
+    }
+
+  private:
+    struct Entry {
+      size_t pid;
+      int page;
+      int frame;
+    };
+    TLBParams params;
+    std::vector<std::vector<Entry>> sets;  // eviction order
+
+    std::vector<Entry>& Set(int page) {return sets[page % sets.size()];}
+};
+
+static void RandomTranslations(uint64_t seed, const TLBParams& params,
+                               int operations) {
+  TestRandom random{seed};
+  TLB tlb{params};
+  NaiveTLB naive{params};
+  // a working set somewhat larger than the TLB, so sets fill and evict
+  int pages = 1 + params.entries + params.entries/2;
+  for (int i = 0; i < operations; i++) {
+    size_t pid = random.Below(3);
+    int page = random.Below(pages);
+    int action = random.Below(100);
+    if (action < 90) {
+      int frame = tlb.Lookup(pid, page);
+      CHECK(frame == naive.Lookup(pid, page));
+      if (frame < 0) {
+        frame = random.Below(1 << 20);
+        tlb.Insert(pid, page, frame);
+        naive.Insert(pid, page, frame, tlb);
+      }
+    }
+    else if (action < 98) {
+      tlb.Invalidate(pid, page);
+      naive.Invalidate(pid, page);
+    }
+    else {
+      tlb.Flush();
+      naive.Flush();
+    }
+  }
+  // every translation of the model and nothing else is cached
+  for (size_t pid = 0; pid < 3; pid++) {
+    for (int page = 0; page < pages; page++)
+      CHECK(tlb.Lookup(pid, page) == naive.Lookup(pid, page));
+  }
+}
+
+int main() {
+  const TLBPolicy policies[] = {TLBPolicy::lru, TLBPolicy::fifo,
+                                TLBPolicy::random};
+  // direct mapped, set associative and fully associative
+  const int shapes[][2] = {{1, 1}, {8, 1}, {8, 2}, {16, 4}, {16, 16}, {64, 4}};
+  uint64_t seed = 1;
+  for (TLBPolicy policy: policies) {
+    for (const auto& shape: shapes) {
+      TLBParams params{shape[0], shape[1], policy, true};
+      RandomTranslations(seed++, params, 20000);
+    }
+  }
+  return TestResult("tlb_test");
+}
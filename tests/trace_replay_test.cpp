@@ -0,0 +1,123 @@
+// Replay of tests/data/replay.txt against the output it is known to give,
+// tests/data/replay.expected: the status of every command, snapshots along
+// the way and the replay summary. The same trace converted to the binary
+// format and replayed must end in the same state. Run from the top
+// directory; --print writes the output instead of comparing it, to
+// regenerate the expected file after an intended change of behavior.
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+#include "trace.h"
+#include "tests/check.h"
+
+using namespace os_ops;
+
+static const char kTrace[] = "tests/data/replay.txt";
+static const char kExpected[] = "tests/data/replay.expected";
+
+static void WriteSnapshots(const OS& os, std::ostream& out) {
+  for (char snap_type: std::string("rpdcjm")) os.Snapshot(snap_type, out);
+}
+
+// Counters of summary, without the time the replay took
+static void WriteSummary(const ReplaySummary& summary, std::ostream& out) {
+  out << "events " << summary.events << " failed " << summary.failed
+      << " completed " << summary.completed << std::endl;
+  for (int p = 0; p < 7; p++) {
+    const PolicySummary& policy = summary.policies[p];
+    if (policy.disks == 0) continue;
+    out << PolicyName(static_cast<DiskPolicy>(p)) << " disks " << policy.disks
+        << " seek " << policy.stats.seek_distance
+        << " serviced " << policy.stats.serviced
+        << " total wait " << policy.stats.total_wait
+        << " max wait " << policy.stats.max_wait << std::endl;
+  }
+  out << "free frames " << summary.frames.free_frames
+      << " runs " << summary.frames.runs
+      << " largest run " << summary.frames.largest_run << std::endl;
+}
+
+// Apply the commands of the trace one at a time, writing their status and
+// snapshots every 100 commands
+static bool StepThrough(std::ostream& out) {
+  MappedFile file{kTrace};
+  if (!file.is_open()) return false;
+  Tokenizer tokens{file.data(), file.data() + file.size()};
+  SysgenParams params{};
+  std::string error;
+  if (!ParseSysgen(tokens, &params, &error)) return false;
+  OS os{params};
+  TraceRecord record;
+  for (int n = 1; ParseRecord(tokens, &record, &error); n++) {
+    out << n << " " << record.command << " "
+        << StatusMessage(ApplyRecord(os, record)) << std::endl;
+    if (n % 100 == 0) WriteSnapshots(os, out);
+  }
+  WriteSnapshots(os, out);
+  return error.empty();
+}
+
+// Final state and summary of a replay of path
+static bool Replay(const char* path, std::ostream& out) {
+  ReplaySummary summary;
+  std::string error;
+  std::unique_ptr<OS> os;
+  if (!ReplayTrace(path, &summary, &error, &os)) {
+    std::cerr << path << ": " << error << std::endl;
+    return false;
+  }
+  WriteSnapshots(*os, out);
+  WriteSummary(summary, out);
+  return true;
+}
+
+// Number of the first line where a and b differ, 0 if they are the same
+static int FirstDifference(const std::string& a, const std::string& b) {
+  std::istringstream in_a{a}, in_b{b};
+  std::string line_a, line_b;
+  for (int line = 1; ; line++) {
+    bool more_a = static_cast<bool>(std::getline(in_a, line_a));
+    bool more_b = static_cast<bool>(std::getline(in_b, line_b));
+    if (!more_a && !more_b) return 0;
+    if (more_a != more_b || line_a != line_b) return line;
+  }
+}
+
+int main(int argc, char* argv[]) {
+  std::ostringstream text;
+  CHECK(StepThrough(text));
+  std::ostringstream replayed;
+  CHECK(Replay(kTrace, replayed));
+  text << replayed.str();
+  if (argc > 1 && strcmp(argv[1], "--print") == 0) {
+    std::cout << text.str();
+    return check_failures == 0 ? 0 : 1;
+  }
+
+  std::ifstream expected_file{kExpected};
+  std::stringstream expected;
+  expected << expected_file.rdbuf();
+  CHECK(expected_file.is_open());
+  int line = FirstDifference(text.str(), expected.str());
+  if (line != 0) std::cerr << kExpected << ":" << line << ": differs" << std::endl;
+  CHECK(line == 0);
+
+  // the binary trace ends in the state of the text trace
+  char binary_path[] = "/tmp/replay_testXXXXXX";
+  int fd = mkstemp(binary_path);
+  CHECK(fd >= 0);
+  if (fd >= 0) {
+    close(fd);
+    std::string error;
+    CHECK(ConvertTrace(kTrace, binary_path, &error));
+    std::ostringstream binary;
+    CHECK(Replay(binary_path, binary));
+    CHECK(binary.str() == replayed.str());
+    unlink(binary_path);
+  }
+  return TestResult("trace_replay_test");
+}
@@ -0,0 +1,71 @@
+#include "tlb.h"
+
+const char* kTLBPolicyNames[] = {"lru", "fifo", "random"};
+
+const char* TLBPolicyName(TLBPolicy policy) {
+  return kTLBPolicyNames[static_cast<int>(policy)];
+}
+bool ParseTLBPolicy(const std::string& name, TLBPolicy* policy) {
+  for (int i = 0; i < 3; i++) {
+    if (name == kTLBPolicyNames[i]) {
+      *policy = static_cast<TLBPolicy>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+TLB::TLB(const TLBParams& params) :
+    ways{params.ways}, sets{params.entries/params.ways},
+    policy{params.policy}, tag_asid{params.asid},
+    entries(params.entries, Entry{0, 0, 0, 0, 0}) {}
+
+void TLB::Insert(size_t pid, int page, int frame) {
+  Entry* set = Set(page);
+  // an invalid entry if there is one, otherwise the policy's victim
+  Entry* victim = nullptr;
+  for (int w = 0; w < ways && victim == nullptr; w++) {
+    if (set[w].generation != generation) victim = &set[w];
+  }
+  if (victim == nullptr) {
+    if (policy == TLBPolicy::random) {
+      // xorshift64, fixed seed so runs are repeatable
+      random_state ^= random_state << 13;
+      random_state ^= random_state >> 7;
+      random_state ^= random_state << 17;
+      victim = &set[random_state % ways];
+    }
+    else {
+      victim = &set[0];
+      for (int w = 1; w < ways; w++) {
+        if (set[w].stamp < victim->stamp) victim = &set[w];
+      }
+    }
+  }
+  *victim = Entry{generation, page, frame, pid, ++clock};
+}
+
+void TLB::Invalidate(size_t pid, int page) {
+  Entry* set = Set(page);
+  for (int w = 0; w < ways; w++) {
+    if (set[w].generation == generation && set[w].page == page &&
+        set[w].pid == pid)
+      set[w].generation = 0;
+  }
+}
+
+void TLB::Save(CheckpointWriter& out) const {
+  out.PutVector(entries);
+  out.Put(generation);
+  out.Put(clock);
+  out.Put(random_state);
+}
+
+void TLB::Restore(CheckpointReader& in) {
+  size_t num_of_entries = entries.size();
+  in.GetVector(&entries);
+  generation = in.Get<uint64_t>();
+  clock = in.Get<uint64_t>();
+  random_state = in.Get<uint64_t>();
+  if (entries.size() != num_of_entries) in.Fail();
+}
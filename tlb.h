@@ -0,0 +1,82 @@
+// Translation lookaside buffer: a set associative cache of page to frame
+// translations of one CPU. Entries are tagged with the pid of their process
+// (ASID), so without ASIDs the OS flushes the TLB on every context switch.
+#ifndef TLB_H
+#define TLB_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "checkpoint_io.h"
+
+// Entry replaced when a set is full
+enum class TLBPolicy {lru, fifo, random};
+
+// Name of policy as used in options
+const char* TLBPolicyName(TLBPolicy policy);
+// Store the policy called name in policy. Returns false if there is none.
+bool ParseTLBPolicy(const std::string& name, TLBPolicy* policy);
+
+// Configuration of the TLB of every CPU, no TLB if entries == 0
+struct TLBParams {
+  int entries;
+  int ways;           // entries per set, entries for fully associative
+  TLBPolicy policy;
+  bool asid;          // keep entries of other processes on context switches
+};
+
+class TLB {
+  public:
+    // params.entries > 0, a multiple of params.ways
+    explicit TLB(const TLBParams& params);
+
+    bool asid() const {return tag_asid;}
+
+    // Frame of page of process pid, -1 on a miss
+    int Lookup(size_t pid, int page) {
+      Entry* set = Set(page);
+      for (int w = 0; w < ways; w++) {
+        Entry& e = set[w];
+        if (e.generation == generation && e.page == page && e.pid == pid) {
+          if (policy == TLBPolicy::lru) e.stamp = ++clock;
+          return e.frame;
+        }
+      }
+      return -1;
+    }
+    // Cache the translation of page of process pid after a miss
+    void Insert(size_t pid, int page, int frame);
+    // Drop the translation of page of process pid if cached
+    void Invalidate(size_t pid, int page);
+    // Drop every translation
+    void Flush() {generation++;}
+
+    // Restore into a TLB of the same parameters
+    void Save(CheckpointWriter& out) const;
+    void Restore(CheckpointReader& in);
+
+  private:
+    // entries are valid while their generation is the TLB's, so a flush
+    // does not touch them
+    struct Entry {
+      uint64_t generation;
+      int page;
+      int frame;
+      size_t pid;
+      uint64_t stamp;  // last use (lru) or insertion (fifo)
+    };
+
+    int ways, sets;
+    TLBPolicy policy;
+    bool tag_asid;
+    std::vector<Entry> entries;
+    uint64_t generation = 1;
+    uint64_t clock = 0;
+    uint64_t random_state = 0x9e3779b97f4a7c15ull;
+
+    Entry* Set(int page) {return &entries[(page % sets)*ways];}
+};
+
+#endif
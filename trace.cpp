@@ -0,0 +1,403 @@
+// Implementation of trace replay in trace.h
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+namespace os_ops {
+
+  MappedFile::MappedFile(const char* path) : data_{nullptr}, size_{0} {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED) {
+        madvise(addr, st.st_size, MADV_SEQUENTIAL);
+        data_ = static_cast<const char*>(addr);
+        size_ = st.st_size;
+      }
+    }
+    close(fd);
+  }
+  MappedFile::~MappedFile() {
+    if (data_ != nullptr) munmap(const_cast<char*>(data_), size_);
+  }
+
+  bool Tokenizer::Next(const char*& tok, size_t& len) {
+    while (pos_ != end_ && (unsigned char)*pos_ <= ' ') ++pos_;
+    if (pos_ == end_) return false;
+    tok = pos_;
+    while (pos_ != end_ && (unsigned char)*pos_ > ' ') ++pos_;
+    len = pos_ - tok;
+    return true;
+  }
+
+  // Parse len characters at tok as a number in base 10 or 16 into value.
+  // Returns false if they are not a valid number in the range of int, with
+  // an optional leading '-'.
+  static bool ParseNumber(const char* tok, size_t len, int base, int& value) {
+    if (len == 0) return false;
+    bool negative = (tok[0] == '-');
+    size_t i = negative;
+    if (i == len) return false;
+    long long result = 0;
+    for (; i < len; i++) {
+      char ch = tok[i];
+      int digit;
+      if (ch >= '0' && ch <= '9') digit = ch - '0';
+      else if (base == 16 && ch >= 'a' && ch <= 'f') digit = ch - 'a' + 10;
+      else if (base == 16 && ch >= 'A' && ch <= 'F') digit = ch - 'A' + 10;
+      else return false;
+      result = result*base + digit;
+      if (result > 0x7fffffff) return false;
+    }
+    value = negative ? -result : result;
+    return true;
+  }
+
+  bool Tokenizer::NextInt(int& value) {
+    const char* tok;
+    size_t len;
+    return Next(tok, len) && ParseNumber(tok, len, 10, value);
+  }
+  bool Tokenizer::NextHex(int& value) {
+    const char* tok;
+    size_t len;
+    return Next(tok, len) && ParseNumber(tok, len, 16, value);
+  }
+
+  bool ParseSysgen(Tokenizer& tokens, SysgenParams* params, std::string* error) {
+    bool read = tokens.NextInt(params->printer_num) &&
+                tokens.NextInt(params->disk_num) && params->disk_num >= 0;
+    params->cyl_nums.clear();
+    params->disk_policies.clear();
+    for (int i = 0; read && i < params->disk_num; i++) {
+      // <cylinders>[:<policy>]
+      const char* tok;
+      size_t len;
+      int num_of_cylinders = 0;
+      DiskPolicy policy = DiskPolicy::fscan;
+      read = tokens.Next(tok, len);
+      const char* colon = read ? static_cast<const char*>(memchr(tok, ':', len)) : nullptr;
+      if (colon != nullptr) {
+        read = ParsePolicy(std::string(colon+1, tok+len), &policy);
+        len = colon - tok;
+      }
+      read = read && ParseNumber(tok, len, 10, num_of_cylinders);
+      if (!read) break;
+      params->cyl_nums.push_back(num_of_cylinders);
+      params->disk_policies.push_back(policy);
+    }
+    // traces do not ask for contiguous frames
+    params->contiguous_frames = false;
+    // traces run on one round robin CPU with all pages of a process in
+    // memory, dense page tables and no TLB
+    params->cpu_num = 1;
+    params->cpu_affinity = false;
+    params->page_replacement = ReplacementPolicy::none;
+    params->tlb = TLBParams{};
+    params->page_tables = PageTableKind::dense;
+    params->scheduler = SchedulerParams{};
+    params->device_timings = DeviceTimings{};
+    read = read && tokens.NextInt(params->cd_num) &&
+           tokens.NextInt(params->time_slice) &&
+           tokens.NextInt(params->page_size) &&
+           tokens.NextInt(params->mem_size) &&
+           tokens.NextInt(params->max_proc_size);
+    if (!read) {
+      *error = "Sysgen parameters missing, not numbers or unknown disk policy";
+      return false;
+    }
+    return ValidSysgen(*params, error);
+  }
+
+  bool ParseRecord(Tokenizer& tokens, TraceRecord* record, std::string* error) {
+    const char* tok;
+    size_t len;
+    error->clear();
+    if (!tokens.Next(tok, len)) return false;
+
+    char command = tok[0];
+    *record = TraceRecord{};
+    record->command = command;
+    bool valid = true;
+    if (len == 1) {
+      if (command == 'A') valid = tokens.NextInt(record->num);
+      else if (command == 't') valid = tokens.NextInt(record->burst);
+      else if (command == 'S') {
+        // device type of the status, a field of its own
+        const char* field;
+        size_t field_len;
+        valid = tokens.Next(field, field_len) && field_len == 1;
+        if (valid) record->num = field[0];
+      }
+      else valid = (command == 'T');
+    }
+    // letter followed by a device number or pid
+    else if (command == 'K' || command == 'C' || command == 'D' ||
+             command == 'P') {
+      valid = ParseNumber(tok+1, len-1, 10, record->num);
+    }
+    else if (command == 'c' || command == 'd' || command == 'p') {
+      valid = ParseNumber(tok+1, len-1, 10, record->num) &&
+              tokens.NextInt(record->burst) && tokens.Next(tok, len) &&
+              len <= 20;
+      if (valid) {
+        memcpy(record->file_name, tok, len);
+        record->file_name[len] = '\0';
+        valid = tokens.NextHex(record->start_mem_loc);
+      }
+      record->op = 'w';
+      if (valid && command != 'p') {
+        valid = tokens.Next(tok, len) && len == 1;
+        if (valid) record->op = tok[0];
+      }
+      record->cylinder = -1;
+      if (valid && command == 'd') valid = tokens.NextInt(record->cylinder);
+      if (valid && record->op == 'w') valid = tokens.NextInt(record->file_size);
+    }
+    else valid = false;
+
+    if (!valid) {
+      *error = "Malformed command " + std::string(1, command);
+      return false;
+    }
+    return true;
+  }
+
+  Status ApplyRecord(OS& os, const TraceRecord& record) {
+    switch (record.command) {
+      case 'A': return os.NewProcess(record.num);
+      case 't': return os.TerminateActiveProcess(record.burst);
+      case 'T': return os.EndOfTimeSlice();
+      case 'S': return Status::ok;
+      case 'K': return os.Kill(record.num);
+      case 'C': case 'D': case 'P':
+        return os.HandleInterrupt(record.command, record.num);
+      case 'c': case 'd': case 'p': {
+        IOParams params{record.file_name, record.start_mem_loc, record.op,
+                        record.cylinder, record.file_size};
+        return os.IORequest(record.command, record.num, record.burst, params);
+      }
+    }
+    return Status::invalid_params;
+  }
+
+  // Whether a and b agree in the parameters a trace sets: devices with their
+  // cylinders and policies, time slice and memory
+  static bool SameSystem(const SysgenParams& a, const SysgenParams& b) {
+    if (a.printer_num != b.printer_num || a.disk_num != b.disk_num ||
+        a.cd_num != b.cd_num || a.cyl_nums != b.cyl_nums ||
+        a.time_slice != b.time_slice || a.page_size != b.page_size ||
+        a.mem_size != b.mem_size || a.max_proc_size != b.max_proc_size)
+      return false;
+    // no policies means FSCAN for every disk
+    for (int i = 0; i < a.disk_num; i++) {
+      DiskPolicy policy_a = a.disk_policies.empty() ? DiskPolicy::fscan : a.disk_policies[i];
+      DiskPolicy policy_b = b.disk_policies.empty() ? DiskPolicy::fscan : b.disk_policies[i];
+      if (policy_a != policy_b) return false;
+    }
+    return true;
+  }
+
+  // Store end of replay counters of os in summary
+  static void CollectSummary(const OS& os, ReplaySummary* summary) {
+    summary->completed = os.completed();
+    summary->frames = os.frame_allocator().RunStats();
+    for (int i = 1; i <= (int)os.get_disk_num(); i++) {
+      const Disk* d = os.disk(i);
+      PolicySummary& policy = summary->policies[static_cast<int>(d->get_policy())];
+      policy.disks++;
+      policy.stats.seek_distance += d->stats().seek_distance;
+      policy.stats.serviced += d->stats().serviced;
+      policy.stats.total_wait += d->stats().total_wait;
+      policy.stats.max_wait = std::max(policy.stats.max_wait, d->stats().max_wait);
+    }
+  }
+
+  bool ReplayText(const char* path, ReplaySummary* summary, std::string* error,
+                  std::unique_ptr<OS>* os) {
+    MappedFile file{path};
+    if (!file.is_open()) {
+      *error = std::string("Can not read trace ") + path;
+      return false;
+    }
+    Tokenizer tokens{file.data(), file.data() + file.size()};
+    SysgenParams params{};
+    if (!ParseSysgen(tokens, &params, error)) return false;
+
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<OS> own;
+    std::unique_ptr<OS>& target = (os != nullptr) ? *os : own;
+    if (!target) target.reset(new OS{params});
+    else if (!SameSystem(params, target->sysgen())) {
+      *error = "Sysgen parameters of the trace differ from those of the OS";
+      return false;
+    }
+    TraceRecord record;
+    while (ParseRecord(tokens, &record, error)) {
+      summary->events++;
+      if (ApplyRecord(*target, record) != Status::ok) summary->failed++;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    summary->seconds = elapsed.count();
+    CollectSummary(*target, summary);
+    if (!error->empty()) {
+      *error += " after event " + std::to_string(summary->events);
+      return false;
+    }
+    return true;
+  }
+
+  bool ReplayBinary(const char* path, ReplaySummary* summary,
+                    std::string* error, std::unique_ptr<OS>* os) {
+    MappedFile file{path};
+    if (!file.is_open()) {
+      *error = std::string("Can not read trace ") + path;
+      return false;
+    }
+    const TraceHeader* header = reinterpret_cast<const TraceHeader*>(file.data());
+    if (file.size() < sizeof(TraceHeader) ||
+        memcmp(header->magic, kTraceMagic, sizeof(kTraceMagic)) != 0 ||
+        header->version != kTraceVersion ||
+        header->disk_num < 0) {
+      *error = "Not a binary trace of a supported version";
+      return false;
+    }
+    size_t records_offset = sizeof(TraceHeader) +
+                            header->disk_num*2*sizeof(int32_t);
+    if (file.size() < records_offset ||
+        (file.size() - records_offset)/sizeof(TraceRecord) != header->num_of_records) {
+      *error = "Binary trace truncated";
+      return false;
+    }
+    const int32_t* disk_entries = reinterpret_cast<const int32_t*>(header + 1);
+    SysgenParams params{header->printer_num, header->disk_num, header->cd_num,
+                        {}, {}, header->time_slice, header->page_size,
+                        header->mem_size, header->max_proc_size, false, 1,
+                        false, ReplacementPolicy::none, TLBParams{},
+                        PageTableKind::dense, SchedulerParams{},
+                        DeviceTimings{}};
+    for (int i = 0; i < header->disk_num; i++) {
+      const int32_t* entry = disk_entries + i*2;
+      params.cyl_nums.push_back(entry[0]);
+      int32_t policy = entry[1];
+      if (policy < 0 || policy > (int32_t)DiskPolicy::fscan) {
+        *error = "Invalid disk policy in binary trace";
+        return false;
+      }
+      params.disk_policies.push_back(static_cast<DiskPolicy>(policy));
+    }
+    if (!ValidSysgen(params, error)) return false;
+
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<OS> own;
+    std::unique_ptr<OS>& target = (os != nullptr) ? *os : own;
+    if (!target) target.reset(new OS{params});
+    else if (!SameSystem(params, target->sysgen())) {
+      *error = "Sysgen parameters of the trace differ from those of the OS";
+      return false;
+    }
+    const TraceRecord* begin = reinterpret_cast<const TraceRecord*>(
+        file.data() + records_offset);
+    const TraceRecord* end = begin + header->num_of_records;
+    const TraceRecord* record = begin;
+    for (; record != end; ++record) {
+      // the OS reads file names up to their terminator
+      if (memchr(record->file_name, '\0', sizeof(record->file_name)) == nullptr) {
+        *error = "Corrupt binary trace: file name of event " +
+                 std::to_string(record - begin) +
+                 " not terminated";
+        break;
+      }
+      if (ApplyRecord(*target, *record) != Status::ok) summary->failed++;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    summary->events = record - begin;
+    summary->seconds = elapsed.count();
+    CollectSummary(*target, summary);
+    return record == end;
+  }
+
+  bool ReplayTrace(const char* path, ReplaySummary* summary, std::string* error,
+                   std::unique_ptr<OS>* os) {
+    char magic[sizeof(kTraceMagic)] = {0};
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+      *error = std::string("Can not read trace ") + path;
+      return false;
+    }
+    size_t read = fread(magic, 1, sizeof(magic), file);
+    fclose(file);
+    if (read == sizeof(magic) && memcmp(magic, kTraceMagic, sizeof(magic)) == 0)
+      return ReplayBinary(path, summary, error, os);
+    return ReplayText(path, summary, error, os);
+  }
+
+  bool ConvertTrace(const char* text_path, const char* binary_path,
+                    std::string* error) {
+    MappedFile text{text_path};
+    if (!text.is_open()) {
+      *error = std::string("Can not read trace ") + text_path;
+      return false;
+    }
+    Tokenizer tokens{text.data(), text.data() + text.size()};
+    SysgenParams params{};
+    if (!ParseSysgen(tokens, &params, error)) return false;
+
+    FILE* out = fopen(binary_path, "wb");
+    if (out == nullptr) {
+      *error = std::string("Can not write trace ") + binary_path;
+      return false;
+    }
+    std::vector<char> buffer(1 << 20);
+    setvbuf(out, buffer.data(), _IOFBF, buffer.size());
+
+    // header is rewritten with the number of records at the end
+    TraceHeader header{};
+    memcpy(header.magic, kTraceMagic, sizeof(kTraceMagic));
+    header.version = kTraceVersion;
+    header.printer_num = params.printer_num;
+    header.disk_num = params.disk_num;
+    header.cd_num = params.cd_num;
+    header.time_slice = params.time_slice;
+    header.page_size = params.page_size;
+    header.mem_size = params.mem_size;
+    header.max_proc_size = params.max_proc_size;
+    fwrite(&header, sizeof(header), 1, out);
+    for (int i = 0; i < params.disk_num; i++) {
+      int32_t disk_entry[2] = {params.cyl_nums[i],
+                               static_cast<int32_t>(params.disk_policies[i])};
+      fwrite(disk_entry, sizeof(disk_entry), 1, out);
+    }
+    TraceRecord record;
+    while (ParseRecord(tokens, &record, error)) {
+      fwrite(&record, sizeof(record), 1, out);
+      header.num_of_records++;
+    }
+    if (error->empty()) {
+      fseek(out, 0, SEEK_SET);
+      fwrite(&header, sizeof(header), 1, out);
+    }
+    bool written = !ferror(out);
+    fclose(out);
+    if (!error->empty()) {
+      *error += " after record " + std::to_string(header.num_of_records);
+      return false;
+    }
+    if (!written) {
+      *error = std::string("Can not write trace ") + binary_path;
+      return false;
+    }
+    return true;
+  }
+
+}
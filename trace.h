@@ -0,0 +1,156 @@
+// Replay of recorded command traces against the headless OS API at full
+// speed, without any console I/O.
+//
+// A text trace starts with the Sysgen parameters in the order Sysgen asks for
+// them:
+//   <printers> <disks> <cylinders of disk 1..n> <cd-rws> <time slice>
+//   <page size> <memory size> <max process size>
+// where the cylinders of a disk may be followed by :<scheduling policy>
+// (e.g. 200:c-look, FSCAN if not given)
+// followed by a stream of whitespace separated commands:
+//   A <size>            new process
+//   t <burst>           terminate active process
+//   T                   end of time slice
+//   S <r/p/d/c/m/j>     snapshot (ignored during replay)
+//   K<pid>              kill process
+//   C<n> D<n> P<n>      interrupt from device n
+//   c<n> d<n> p<n> <burst> <file name> <logical address (hex)> [r/w]
+//       [cylinder] [file size]
+//                       I/O request, r/w is given for all devices except
+//                       printers, cylinder only for disks and file size only
+//                       for writes (same order as the interactive prompts)
+//
+// A binary trace is a TraceHeader, followed by an int32 cylinder count and
+// an int32 DiskPolicy per disk and a TraceRecord per command up to the end of
+// the file. All fields are stored in host byte order.
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "os.h"
+
+namespace os_ops {
+
+// Read-only memory mapping of a whole file
+class MappedFile {
+  public:
+    explicit MappedFile(const char* path);
+    ~MappedFile();
+
+    // disable copy/move constructor and assignment operator
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool is_open() const {return data_ != nullptr;}
+    const char* data() const {return data_;}
+    size_t size() const {return size_;}
+
+  private:
+    const char* data_;
+    size_t size_;
+};
+
+// Splits a text buffer into whitespace separated tokens without copying
+class Tokenizer {
+  public:
+    Tokenizer(const char* begin, const char* end) : pos_{begin}, end_{end} {}
+
+    // Store next token in tok and len. Returns false at end of buffer.
+    bool Next(const char*& tok, size_t& len);
+    // Parse next token as a decimal or hex integer. Returns false at end of
+    // buffer or if the token is not a number.
+    bool NextInt(int& value);
+    bool NextHex(int& value);
+
+  private:
+    const char* pos_;
+    const char* end_;
+};
+
+// Binary trace file header with the Sysgen parameters of the trace
+struct TraceHeader {
+  char magic[4];       // "OSTR"
+  uint32_t version;
+  int32_t printer_num, disk_num, cd_num;
+  int32_t time_slice, page_size, mem_size, max_proc_size;
+  uint32_t reserved;
+  uint64_t num_of_records;
+};
+
+const char kTraceMagic[4] = {'O', 'S', 'T', 'R'};
+const uint32_t kTraceVersion = 2;
+
+// One command of a trace, fixed width so binary traces can be iterated in
+// place
+struct TraceRecord {
+  char command;        // A/t/T/S/K, c/d/p for I/O requests, C/D/P interrupts
+  char op;             // I/O request parameters
+  char pad[2];
+  int32_t num;         // device number, pid, process size or snapshot type
+  int32_t burst;       // t and I/O requests
+  int32_t start_mem_loc;
+  int32_t cylinder;
+  int32_t file_size;
+  char file_name[24];  // null terminated, max 20 characters
+};
+
+static_assert(sizeof(TraceHeader) == 48, "TraceHeader layout changed");
+static_assert(sizeof(TraceRecord) == 48, "TraceRecord layout changed");
+
+// Disk statistics of all disks using a scheduling policy
+struct PolicySummary {
+  int disks = 0;
+  DiskStats stats;
+};
+
+// Counters of a replayed trace
+struct ReplaySummary {
+  size_t events = 0;
+  size_t failed = 0;    // events the OS rejected
+  int completed = 0;    // processes terminated with t
+  double seconds = 0;
+  PolicySummary policies[7];  // indexed by DiskPolicy
+  FreeRunStats frames;        // free memory at the end of the replay
+};
+
+// Parse text trace Sysgen parameters from tokens into params.
+// Returns false and stores the reason in error if they are invalid.
+bool ParseSysgen(Tokenizer& tokens, SysgenParams* params, std::string* error);
+
+// Parse next text trace command from tokens into record. Returns false at end
+// of trace or on a malformed command, in which case error is set.
+bool ParseRecord(Tokenizer& tokens, TraceRecord* record, std::string* error);
+
+// Apply record to os through the headless API.
+Status ApplyRecord(OS& os, const TraceRecord& record);
+
+// Replay text trace at path. Returns false and stores the reason in error if
+// the trace can not be read or is malformed.
+// If os is given, the trace is replayed on *os instead of a new OS of its
+// Sysgen parameters (unless *os is empty, then it is set to the new OS), which
+// must have the devices, time slice and memory of the trace. The OS stays in
+// *os after the replay.
+bool ReplayText(const char* path, ReplaySummary* summary, std::string* error,
+                std::unique_ptr<OS>* os = nullptr);
+
+// Replay binary trace at path in place from a memory mapping.
+// Returns false and stores the reason in error if the trace is invalid.
+bool ReplayBinary(const char* path, ReplaySummary* summary, std::string* error,
+                  std::unique_ptr<OS>* os = nullptr);
+
+// Replay binary or text trace at path depending on its first bytes.
+bool ReplayTrace(const char* path, ReplaySummary* summary, std::string* error,
+                 std::unique_ptr<OS>* os = nullptr);
+
+// Convert text trace at text_path to a binary trace at binary_path.
+// Returns false and stores the reason in error if conversion failed.
+bool ConvertTrace(const char* text_path, const char* binary_path,
+                  std::string* error);
+
+}
+
+#endif
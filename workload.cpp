@@ -0,0 +1,186 @@
+#include "workload.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace os_ops {
+
+  Random::Random(uint64_t seed) {
+    // splitmix64 so similar seeds give unrelated states
+    for (auto& word: s) {
+      uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+      z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ull;
+      z = (z ^ (z >> 27))*0x94D049BB133111EBull;
+      word = z ^ (z >> 31);
+    }
+  }
+
+  double Random::Exponential(double mean) {
+    return -mean*std::log1p(-Uniform());
+  }
+
+  int Random::Geometric(double p) {
+    if (p >= 1) return 0;
+    return (int)std::floor(std::log1p(-Uniform())/std::log1p(-p));
+  }
+
+  const char* PatternName(ArrivalPattern pattern) {
+    return pattern == ArrivalPattern::poisson ? "poisson" : "bursty";
+  }
+
+  const char* PatternName(CylinderPattern pattern) {
+    switch (pattern) {
+      case CylinderPattern::uniform:    return "uniform";
+      case CylinderPattern::hot_spot:   return "hot-spot";
+      case CylinderPattern::sequential: return "sequential";
+    }
+    return "";
+  }
+
+  bool ParsePattern(const std::string& name, ArrivalPattern* pattern) {
+    if (name == "poisson") *pattern = ArrivalPattern::poisson;
+    else if (name == "bursty") *pattern = ArrivalPattern::bursty;
+    else return false;
+    return true;
+  }
+
+  bool ParsePattern(const std::string& name, CylinderPattern* pattern) {
+    if (name == "uniform") *pattern = CylinderPattern::uniform;
+    else if (name == "hot-spot") *pattern = CylinderPattern::hot_spot;
+    else if (name == "sequential") *pattern = CylinderPattern::sequential;
+    else return false;
+    return true;
+  }
+
+  bool ValidWorkload(const WorkloadParams& params, std::string* error) {
+    std::string reason;
+    if (params.mean_interarrival < 0)
+      reason = "Mean interarrival time must be at least 0.";
+    else if (params.mean_batch < 1)
+      reason = "Mean batch size must be at least 1.";
+    else if (params.max_size_fraction <= 0 || params.max_size_fraction > 1)
+      reason = "Maximum size fraction must be in (0, 1].";
+    else if (params.max_nice < 0 || params.max_nice > kMaxNice)
+      reason = "Maximum nice value must be in [0, 19].";
+    else if (params.mean_burst < 0 || params.max_burst_slices < 1)
+      reason = "CPU bursts must be at least 0 ms and one time slice long.";
+    else if (params.mean_io_requests < 0)
+      reason = "Mean I/O requests must be at least 0.";
+    else if (params.printer_weight < 0 || params.disk_weight < 0 ||
+             params.cd_weight < 0)
+      reason = "Device weights must be at least 0.";
+    else if (params.write_fraction < 0 || params.write_fraction > 1)
+      reason = "Write fraction must be in [0, 1].";
+    else if (params.max_file_size < 1)
+      reason = "Maximum file size must be at least 1.";
+    else if (params.hot_fraction < 0 || params.hot_fraction > 1 ||
+             params.hot_width <= 0 || params.hot_width > 1)
+      reason = "Hot spot fraction must be in [0, 1] and width in (0, 1].";
+    if (reason.empty()) return true;
+    if (error != nullptr) *error = reason;
+    return false;
+  }
+
+  SyntheticWorkload::SyntheticWorkload(const WorkloadParams& params,
+                                       const OS& os) :
+      params(params), random{params.seed}, time_slice{os.time_slice()},
+      max_size{std::max(1, (int)(os.max_process_size()*params.max_size_fraction))} {
+    device_counts[0] = os.get_printer_num();
+    device_counts[2] = os.get_cd_num();
+    // disks without cylinders take no requests
+    for (int d = 1; d <= (int)os.get_disk_num(); d++) {
+      if (os.disk_cylinders(d) > 0) disks.push_back(d);
+    }
+    device_counts[1] = disks.size();
+    // device types without devices are never picked
+    double weights[3] = {params.printer_weight, params.disk_weight,
+                         params.cd_weight};
+    double sum = 0;
+    for (int t = 0; t < 3; t++) {
+      if (device_counts[t] > 0) sum += weights[t];
+      type_weights[t] = sum;
+    }
+    for (int d: disks) {
+      int cyls = os.disk_cylinders(d);
+      int width = std::max(1, (int)(cyls*params.hot_width));
+      cylinders.push_back(cyls);
+      hot_start.push_back(random.Below(cyls - width + 1));
+      next_cylinder.push_back(random.Below(cyls));
+    }
+  }
+
+  bool SyntheticWorkload::NextArrival(SimTime& time, int& size) {
+    if (arrived == params.processes) return false;
+    arrived++;
+    if (params.arrivals == ArrivalPattern::poisson) {
+      arrival_time += random.Exponential(params.mean_interarrival);
+    }
+    // bursty: batches arrive at once, the gaps between batches keep the
+    // mean interarrival time
+    else if (batch_left-- == 0) {
+      batch_left = random.Geometric(1/params.mean_batch);
+      arrival_time += random.Exponential(params.mean_interarrival*
+                                         params.mean_batch);
+    }
+    time = (SimTime)(arrival_time*kMillisecond);
+    size = 1 + random.Below(max_size);
+    return true;
+  }
+
+  int SyntheticWorkload::ArrivalNice() {
+    // no draw without nice values, so other runs keep their sequence
+    if (params.max_nice == 0) return 0;
+    return (int)random.Below(2*params.max_nice + 1) - params.max_nice;
+  }
+
+  ProcessAction SyntheticWorkload::NextAction(const PCB* process) {
+    static const char* const file_names[] = {
+      "data", "log", "index", "config", "cache", "report", "image", "archive"};
+
+    ProcessAction action{};
+    double burst = random.Exponential(params.mean_burst);
+    action.burst = (int)std::min(burst, (double)time_slice*params.max_burst_slices);
+
+    // terminate with probability 1/(mean+1) so the number of I/O requests is
+    // geometric with the given mean
+    double total = type_weights[2];
+    if (total == 0 ||
+        random.Uniform()*(params.mean_io_requests + 1) < 1) return action;
+
+    double pick = random.Uniform()*total;
+    int type = 0;
+    while (pick >= type_weights[type] && type < 2) type++;
+    action.device_type = "pdc"[type];
+    int index = random.Below(device_counts[type]);
+    action.device_num = (type == 1) ? disks[index] : 1 + index;
+
+    IOParams& io = action.io;
+    io.file_name = file_names[random.Below(8)];
+    io.start_mem_loc = random.Below(process->size);
+    io.op = (type == 0 || random.Uniform() < params.write_fraction) ? 'w' : 'r';
+    io.file_size = (io.op == 'w') ? 1 + random.Below(params.max_file_size) : 0;
+    io.cylinder = (type == 1) ? NextCylinder(index) : -1;
+    return action;
+  }
+
+  int SyntheticWorkload::NextCylinder(int index) {
+    int cyls = cylinders[index];
+    switch (params.cylinders) {
+      case CylinderPattern::uniform:
+        return random.Below(cyls);
+      case CylinderPattern::hot_spot: {
+        int width = std::max(1, (int)(cyls*params.hot_width));
+        if (random.Uniform() < params.hot_fraction)
+          return hot_start[index] + random.Below(width);
+        return random.Below(cyls);
+      }
+      case CylinderPattern::sequential: {
+        int cylinder = next_cylinder[index];
+        next_cylinder[index] = (cylinder + 1) % cyls;
+        return cylinder;
+      }
+    }
+    return 0;
+  }
+
+}
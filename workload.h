@@ -0,0 +1,127 @@
+// Synthetic workloads for the simulator: seeded process arrivals, sizes, CPU
+// bursts and I/O requests drawn from configurable distributions, so runs are
+// reproducible.
+#ifndef WORKLOAD_H
+#define WORKLOAD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "os.h"
+#include "simulator.h"
+
+namespace os_ops {
+
+// xoshiro256** pseudo random number generator seeded through splitmix64
+class Random {
+  public:
+    explicit Random(uint64_t seed);
+
+    uint64_t Next() {
+      uint64_t result = Rotl(s[1]*5, 7)*9;
+      uint64_t t = s[1] << 17;
+      s[2] ^= s[0];
+      s[3] ^= s[1];
+      s[1] ^= s[2];
+      s[0] ^= s[3];
+      s[2] ^= t;
+      s[3] = Rotl(s[3], 45);
+      return result;
+    }
+    // Uniform in [0, n), n > 0
+    uint32_t Below(uint32_t n) {
+      return ((Next() >> 32)*n) >> 32;
+    }
+    // Uniform in [0, 1)
+    double Uniform() {return (Next() >> 11)*(1.0/9007199254740992.0);}
+    // Exponentially distributed with mean
+    double Exponential(double mean);
+    // Number of failures before the first success with success probability p
+    int Geometric(double p);
+
+  private:
+    uint64_t s[4];
+
+    static uint64_t Rotl(uint64_t x, int k) {return (x << k) | (x >> (64 - k));}
+};
+
+enum class ArrivalPattern {poisson, bursty};
+enum class CylinderPattern {uniform, hot_spot, sequential};
+
+// Name of pattern as used on the command line
+const char* PatternName(ArrivalPattern pattern);
+const char* PatternName(CylinderPattern pattern);
+// Parse pattern name. Returns false if name is unknown.
+bool ParsePattern(const std::string& name, ArrivalPattern* pattern);
+bool ParsePattern(const std::string& name, CylinderPattern* pattern);
+
+// Distributions of a SyntheticWorkload
+struct WorkloadParams {
+  uint64_t seed = 1;
+  size_t processes = 1000;          // number of arrivals
+
+  ArrivalPattern arrivals = ArrivalPattern::poisson;
+  double mean_interarrival = 50;    // ms
+  double mean_batch = 8;            // bursty: mean arrivals at the same time
+
+  // process sizes are uniform in [1, max_proc_size*max_size_fraction]
+  double max_size_fraction = 1;
+
+  // nice values are uniform in [-max_nice, max_nice]
+  int max_nice = 0;
+
+  // CPU bursts are exponential, at most max_burst_slices time slices
+  double mean_burst = 10;           // ms
+  int max_burst_slices = 1;
+
+  double mean_io_requests = 4;      // I/O requests per process (geometric)
+  // relative frequency of I/O requests to each device type
+  double printer_weight = 1, disk_weight = 4, cd_weight = 1;
+  double write_fraction = 0.5;
+  int max_file_size = 4096;
+
+  CylinderPattern cylinders = CylinderPattern::uniform;
+  // hot spot: hot_fraction of requests go to hot_width of the cylinders
+  double hot_fraction = 0.8, hot_width = 0.1;
+};
+
+// Check params for values no workload can be generated from. Returns false
+// and stores the reason in error if params are invalid.
+bool ValidWorkload(const WorkloadParams& params, std::string* error);
+
+// Workload drawn from the distributions of WorkloadParams for the devices of
+// an OS
+class SyntheticWorkload : public Workload {
+  public:
+    SyntheticWorkload(const WorkloadParams& params, const OS& os);
+
+    bool NextArrival(SimTime& time, int& size);
+    int ArrivalNice();
+    ProcessAction NextAction(const PCB* process);
+
+  private:
+    WorkloadParams params;
+    Random random;
+    int time_slice, max_size;
+    size_t arrived = 0;
+    double arrival_time = 0;  // ms
+    int batch_left = 0;
+
+    // cumulative device type weights of printers, disks and cd/rws
+    double type_weights[3];
+    int device_counts[3];
+    // numbers of the disks with cylinders, and for each of them:
+    std::vector<int> disks;
+    std::vector<int> cylinders;
+    std::vector<int> hot_start;     // first hot cylinder
+    std::vector<int> next_cylinder; // sequential position
+
+    // Cylinder of the next request to disks[index]
+    int NextCylinder(int index);
+};
+
+}
+
+#endif